@@ -218,6 +218,34 @@ AC_DEFUN([AX_CXX11_TUPLES],[
   fi
 ])
 
+AC_DEFUN([AX_CXX11_THREAD_LOCAL],[
+  AC_CACHE_CHECK([for support for C++11 feature "thread_local"], [ax_cv_cxx11_thread_local],[
+
+    CXXFLAGS_SAVED=$CXXFLAGS
+    CXXFLAGS="$CXXFLAGS $STD_CXX11"
+    export CXXFLAGS
+
+    AC_LANG_PUSH(C++)
+    AC_TRY_COMPILE(
+      [
+struct charlie {
+  ~charlie() {}
+};
+thread_local charlie delta;
+],
+      [static thread_local int echo = 42; return echo;],
+      [ax_cv_cxx11_thread_local="yes"],
+      [ax_cv_cxx11_thread_local="no"])
+    AC_LANG_POP
+
+    CXXFLAGS="$CXXFLAGS_SAVED"
+  ])
+
+  if ! test x"$ax_cv_cxx11_thread_local" = xyes ; then
+    missing_cxx11_features="$missing_cxx11_features\n  * thread_local"
+  fi
+])
+
 dnl AC_DEFUN([AX_CXX11_DEF_NAME],[
 dnl   AC_CACHE_CHECK([for support for C++11 feature "human"], [ax_cv_cxx11_def_name],[
 dnl
@@ -249,10 +277,11 @@ AX_CXX11_AUTO_KEYWORD
 AX_CXX11_LAMBDA_FUNCTIONS
 AX_CXX11_NULLPTR
 AX_CXX11_TUPLES
+AX_CXX11_THREAD_LOCAL
 
 if test x"$missing_cxx11_features" != x ; then
   printf "The following features of the C++11 standard are not supported by $CXX:$missing_cxx11_features\n"
   printf "If you are using the GNU C compiler collection (gcc) then you need\n"
-  printf "at least v4.6.\n"
+  printf "at least v4.8.\n"
   AC_MSG_ERROR([support for required C++11 features incomplete])
 fi
@@ -0,0 +1,47 @@
+dnl
+dnl Check whether the compiler supports the instructions used for
+dnl calculating CRC-32 checksums in hardware. Whether or not the CPU
+dnl running the programs supports them is determined at runtime.
+dnl
+AC_CACHE_CHECK([for PCLMULQDQ intrinsics], [ac_cv_crc32_pclmul],[
+  AC_LANG_PUSH(C++)
+  AC_TRY_COMPILE([
+#include <cpuid.h>
+#include <smmintrin.h>
+#include <wmmintrin.h>
+
+__attribute__((target("sse4.1,pclmul")))
+int fold(__m128i a, __m128i b) {
+  return _mm_extract_epi32(_mm_clmulepi64_si128(a, b, 0x11), 1);
+}
+    ],
+    [unsigned int a, b, c, d; __get_cpuid(1, &a, &b, &c, &d); return fold(_mm_setzero_si128(), _mm_setzero_si128());],
+    ac_cv_crc32_pclmul=yes,
+    ac_cv_crc32_pclmul=no)
+  AC_LANG_POP
+])
+
+if test x"$ac_cv_crc32_pclmul" = "xyes" ; then
+  AC_DEFINE(HAVE_CRC32_PCLMUL, 1, [define if the PCLMULQDQ intrinsics are available])
+fi
+
+AC_CACHE_CHECK([for ARMv8 CRC32 intrinsics], [ac_cv_crc32_armv8],[
+  AC_LANG_PUSH(C++)
+  AC_TRY_COMPILE([
+#include <arm_acle.h>
+#include <sys/auxv.h>
+
+__attribute__((target("+crc")))
+unsigned int update(unsigned int crc, unsigned long long value) {
+  return __crc32d(crc, value);
+}
+    ],
+    [return update(getauxval(AT_HWCAP), 0);],
+    ac_cv_crc32_armv8=yes,
+    ac_cv_crc32_armv8=no)
+  AC_LANG_POP
+])
+
+if test x"$ac_cv_crc32_armv8" = "xyes" ; then
+  AC_DEFINE(HAVE_CRC32_ARMV8, 1, [define if the ARMv8 CRC32 intrinsics are available])
+fi
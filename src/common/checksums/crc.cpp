@@ -16,12 +16,179 @@
 
 #include "common/common_pch.h"
 
+#if defined(HAVE_CRC32_PCLMUL)
+# include <cpuid.h>
+# include <smmintrin.h>
+# include <wmmintrin.h>
+#elif defined(HAVE_CRC32_ARMV8) && defined(__aarch64__)
+# include <arm_acle.h>
+# include <asm/hwcap.h>
+# include <sys/auxv.h>
+#endif
+
 #include "common/bswap.h"
 #include "common/checksums/crc.h"
 #include "common/endian.h"
 
 namespace mtx { namespace checksum {
 
+namespace {
+
+// Hardware kernels for the reflected CRC-32 used by zlib, EBML and
+// others (crc32_ieee_le_c). They process as much of the buffer as
+// they can handle efficiently and return the number of bytes
+// processed. The rest is handled by the table based code.
+typedef size_t (*crc32_le_kernel_t)(uint32_t &crc, unsigned char const *buffer, size_t size);
+
+// Compilers turn these into a single load on little endian
+// architectures, unlike the out-of-line get_uint32_le().
+inline uint32_t
+read_uint32_le(unsigned char const *buffer) {
+  return static_cast<uint32_t>(buffer[0]) | (static_cast<uint32_t>(buffer[1]) << 8) | (static_cast<uint32_t>(buffer[2]) << 16) | (static_cast<uint32_t>(buffer[3]) << 24);
+}
+
+inline uint64_t
+read_uint64_le(unsigned char const *buffer) {
+  return static_cast<uint64_t>(read_uint32_le(buffer)) | (static_cast<uint64_t>(read_uint32_le(buffer + 4)) << 32);
+}
+
+#if defined(HAVE_CRC32_PCLMUL)
+__attribute__((target("sse4.1,pclmul")))
+inline __m128i
+crc32_le_pclmul_fold(__m128i x,
+                     __m128i next,
+                     __m128i k) {
+  auto lo = _mm_clmulepi64_si128(x, k, 0x00);
+  auto hi = _mm_clmulepi64_si128(x, k, 0x11);
+  return _mm_xor_si128(_mm_xor_si128(hi, next), lo);
+}
+
+// Folding with carry-less multiplication as described in Intel's
+// white paper "Fast CRC Computation for Generic Polynomials Using
+// PCLMULQDQ Instruction". Requires at least 64 bytes and handles
+// multiples of 16 bytes.
+__attribute__((target("sse4.1,pclmul")))
+size_t
+crc32_le_pclmul(uint32_t &crc,
+                unsigned char const *buffer,
+                size_t size) {
+  if (size < 64)
+    return 0;
+
+  size           &= ~static_cast<size_t>(15);
+  auto processed  = size;
+
+  auto k1k2       = _mm_set_epi64x(0x01c6e41596ll, 0x0154442bd4ll);
+  auto k3k4       = _mm_set_epi64x(0x00ccaa009ell, 0x01751997d0ll);
+  auto k5k0       = _mm_set_epi64x(0,              0x0163cd6124ll);
+  auto poly       = _mm_set_epi64x(0x01f7011641ll, 0x01db710641ll);
+  auto mask32     = _mm_setr_epi32(~0, 0, ~0, 0);
+
+  auto x1         = _mm_loadu_si128(reinterpret_cast<__m128i const *>(buffer + 0x00));
+  auto x2         = _mm_loadu_si128(reinterpret_cast<__m128i const *>(buffer + 0x10));
+  auto x3         = _mm_loadu_si128(reinterpret_cast<__m128i const *>(buffer + 0x20));
+  auto x4         = _mm_loadu_si128(reinterpret_cast<__m128i const *>(buffer + 0x30));
+
+  x1              = _mm_xor_si128(x1, _mm_cvtsi32_si128(crc));
+
+  buffer         += 64;
+  size           -= 64;
+
+  // Fold four 128-bit blocks in parallel.
+  while (size >= 64) {
+    auto x5 = _mm_clmulepi64_si128(x1, k1k2, 0x00);
+    auto x6 = _mm_clmulepi64_si128(x2, k1k2, 0x00);
+    auto x7 = _mm_clmulepi64_si128(x3, k1k2, 0x00);
+    auto x8 = _mm_clmulepi64_si128(x4, k1k2, 0x00);
+
+    x1      = _mm_clmulepi64_si128(x1, k1k2, 0x11);
+    x2      = _mm_clmulepi64_si128(x2, k1k2, 0x11);
+    x3      = _mm_clmulepi64_si128(x3, k1k2, 0x11);
+    x4      = _mm_clmulepi64_si128(x4, k1k2, 0x11);
+
+    x1      = _mm_xor_si128(_mm_xor_si128(x1, x5), _mm_loadu_si128(reinterpret_cast<__m128i const *>(buffer + 0x00)));
+    x2      = _mm_xor_si128(_mm_xor_si128(x2, x6), _mm_loadu_si128(reinterpret_cast<__m128i const *>(buffer + 0x10)));
+    x3      = _mm_xor_si128(_mm_xor_si128(x3, x7), _mm_loadu_si128(reinterpret_cast<__m128i const *>(buffer + 0x20)));
+    x4      = _mm_xor_si128(_mm_xor_si128(x4, x8), _mm_loadu_si128(reinterpret_cast<__m128i const *>(buffer + 0x30)));
+
+    buffer += 64;
+    size   -= 64;
+  }
+
+  // Fold the four blocks into one, then the remaining 16 byte blocks
+  // into that one.
+  x1 = crc32_le_pclmul_fold(x1, x2, k3k4);
+  x1 = crc32_le_pclmul_fold(x1, x3, k3k4);
+  x1 = crc32_le_pclmul_fold(x1, x4, k3k4);
+
+  while (size >= 16) {
+    x1      = crc32_le_pclmul_fold(x1, _mm_loadu_si128(reinterpret_cast<__m128i const *>(buffer)), k3k4);
+    buffer += 16;
+    size   -= 16;
+  }
+
+  // Reduce 128 bits to 64 bits...
+  x2 = _mm_clmulepi64_si128(x1, k3k4, 0x10);
+  x1 = _mm_xor_si128(_mm_srli_si128(x1, 8), x2);
+
+  x2 = _mm_srli_si128(x1, 4);
+  x1 = _mm_and_si128(x1, mask32);
+  x1 = _mm_clmulepi64_si128(x1, k5k0, 0x00);
+  x1 = _mm_xor_si128(x1, x2);
+
+  // ...and to 32 bits with a Barrett reduction.
+  x2 = _mm_and_si128(x1, mask32);
+  x2 = _mm_clmulepi64_si128(x2, poly, 0x10);
+  x2 = _mm_and_si128(x2, mask32);
+  x2 = _mm_clmulepi64_si128(x2, poly, 0x00);
+  x1 = _mm_xor_si128(x1, x2);
+
+  crc = _mm_extract_epi32(x1, 1);
+
+  return processed;
+}
+
+#elif defined(HAVE_CRC32_ARMV8) && defined(__aarch64__)
+__attribute__((target("+crc")))
+size_t
+crc32_le_armv8(uint32_t &crc,
+               unsigned char const *buffer,
+               size_t size) {
+  auto processed = size & ~static_cast<size_t>(7);
+
+  for (auto end = buffer + processed; buffer < end; buffer += 8)
+    crc = __crc32d(crc, read_uint64_le(buffer));
+
+  return processed;
+}
+#endif
+
+crc32_le_kernel_t
+determine_crc32_le_kernel() {
+  if (debugging_c::requested("crc_no_hardware"))
+    return nullptr;
+
+#if defined(HAVE_CRC32_PCLMUL)
+  unsigned int eax, ebx, ecx, edx;
+  if (__get_cpuid(1, &eax, &ebx, &ecx, &edx) && (ecx & bit_PCLMUL) && (ecx & bit_SSE4_1))
+    return crc32_le_pclmul;
+
+#elif defined(HAVE_CRC32_ARMV8) && defined(__aarch64__)
+  if (getauxval(AT_HWCAP) & HWCAP_CRC32)
+    return crc32_le_armv8;
+#endif
+
+  return nullptr;
+}
+
+crc32_le_kernel_t
+get_crc32_le_kernel() {
+  static auto s_kernel = determine_crc32_le_kernel();
+  return s_kernel;
+}
+
+}
+
 crc_base_c::table_parameters_t const crc_base_c::ms_table_parameters[5] = {
   { 0,  8,       0x07 },
   { 0, 16,     0x8005 },
@@ -56,7 +223,7 @@ crc_base_c::init_table() {
   if ((parameters.bits < 8) || (parameters.bits > 32) || (parameters.poly >= (1LL<<parameters.bits)))
     throw std::domain_error{"Invalid CRC parameters"};
 
-  m_table.resize(256);
+  m_table.resize(8 * 256);
 
   for (auto i = 0u; i < 256u; i++) {
     if (parameters.le) {
@@ -73,6 +240,15 @@ crc_base_c::init_table() {
     }
   }
 
+  // Tables 1 to 7 contain the effect of a byte followed by 1 to 7
+  // zero bytes for processing eight bytes at a time ("slicing by
+  // eight").
+  for (auto i = 0u; i < 256u; i++)
+    for (auto j = 1u; j < 8u; j++) {
+      auto previous          = m_table[(j - 1) * 256 + i];
+      m_table[j * 256 + i]   = (previous >> 8) ^ m_table[previous & 0xff];
+    }
+
   // for (auto row = 0u; row < (265u / 4); ++row)
   //   mxinfo(boost::format("0x%|1$08x| 0x%|2$08x| 0x%|3$08x| 0x%|4$08x|\n")
   //          % m_table[row * 4 + 0] % m_table[row * 4 + 1] % m_table[row * 4 + 2] % m_table[row * 4 + 3]);
@@ -114,12 +290,40 @@ crc_base_c::set_xor_result(uint64_t xor_result) {
 void
 crc_base_c::add_impl(unsigned char const *buffer,
                      size_t size) {
-  auto end = buffer + size;
+  auto crc = m_crc;
+
+  if (crc_32_ieee_le == m_type) {
+    auto kernel = get_crc32_le_kernel();
+    if (kernel) {
+      auto processed  = kernel(crc, buffer, size);
+      buffer         += processed;
+      size           -= processed;
+    }
+  }
 
-  while (buffer < end) {
-    m_crc = m_table[(m_crc & 0xff) ^ *buffer] ^ (m_crc >> 8);
-    ++buffer;
+  auto table = m_table.data();
+
+  while (size >= 8) {
+    auto one  = read_uint32_le(buffer) ^ crc;
+    auto two  = read_uint32_le(buffer + 4);
+    crc       = table[7 * 256 + ( one        & 0xff)] ^ table[6 * 256 + ((one >>  8) & 0xff)]
+              ^ table[5 * 256 + ((one >> 16) & 0xff)] ^ table[4 * 256 + ( one >> 24        )]
+              ^ table[3 * 256 + ( two        & 0xff)] ^ table[2 * 256 + ((two >>  8) & 0xff)]
+              ^ table[1 * 256 + ((two >> 16) & 0xff)] ^ table[          ( two >> 24        )];
+    buffer   += 8;
+    size     -= 8;
   }
+
+  for (auto end = buffer + size; buffer < end; ++buffer)
+    crc = table[(crc & 0xff) ^ *buffer] ^ (crc >> 8);
+
+  m_crc = crc;
+}
+
+bool
+crc_base_c::is_hardware_accelerated()
+  const {
+  return (crc_32_ieee_le == m_type) && get_crc32_le_kernel();
 }
 
 // ----------------------------------------------------------------------
@@ -59,6 +59,10 @@ public:
 
   virtual void set_xor_result(uint64_t xor_result);
 
+  // Whether or not the CPU's CRC instructions are used. Only
+  // supported for crc32_ieee_le_c.
+  bool is_hardware_accelerated() const;
+
 protected:
   virtual void add_impl(unsigned char const *buffer, size_t size);
 
@@ -92,6 +92,7 @@ mtx_common_cleanup() {
 
   random_c::cleanup();
   mm_file_io_c::cleanup();
+  memory_pool_c::dump_statistics();
 
   matroska_done();
 }
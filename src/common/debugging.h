@@ -16,6 +16,9 @@
 
 #include "common/common_pch.h"
 
+#include <atomic>
+#include <deque>
+#include <mutex>
 #include <sstream>
 #include <unordered_map>
 
@@ -42,47 +45,54 @@ public:
 };
 
 class debugging_option_c {
+  // Options are only registered and updated while holding ms_mutex
+  // so that they can be queried from several threads at once.
   struct option_c {
-    boost::tribool m_requested;
+    bool m_requested;
     std::string m_option;
 
     option_c(std::string const &option)
-      : m_requested{boost::logic::indeterminate}
+      : m_requested{debugging_c::requested(option)}
       , m_option{option}
     {
     }
-
-    bool get() {
-      if (boost::logic::indeterminate(m_requested))
-        m_requested = debugging_c::requested(m_option);
-
-      return m_requested;
-    }
   };
 
 protected:
-  mutable size_t m_registered_idx;
+  mutable std::atomic<option_c *> m_registered;
   std::string m_option;
 
 private:
-  static std::vector<option_c> ms_registered_options;
+  // A deque is used so that pointers to registered options stay valid
+  // even if other threads register further options.
+  static std::deque<option_c> ms_registered_options;
+  static std::mutex ms_mutex;
 
 public:
   debugging_option_c(std::string const &option)
-    : m_registered_idx{std::numeric_limits<size_t>::max()}
+    : m_registered{}
     , m_option{option}
   {
   }
 
+  debugging_option_c(debugging_option_c const &other)
+    : m_registered{other.m_registered.load()}
+    , m_option{other.m_option}
+  {
+  }
+
   operator bool() const {
-    if (m_registered_idx == std::numeric_limits<size_t>::max())
-      m_registered_idx = register_option(m_option);
+    auto registered = m_registered.load();
+    if (!registered) {
+      registered   = register_option(m_option);
+      m_registered = registered;
+    }
 
-    return ms_registered_options.at(m_registered_idx).get();
+    return registered->m_requested;
   }
 
 public:
-  static size_t register_option(std::string const &option);
+  static option_c *register_option(std::string const &option);
   static void invalidate_cache();
 };
 
@@ -0,0 +1,117 @@
+/*
+   mkvmerge -- utility for splicing together matroska files
+   from component media subtypes
+
+   Distributed under the GPL v2
+   see the file COPYING for details
+   or visit http://www.gnu.org/copyleft/gpl.html
+
+   a compact, delta coded vector of integers
+
+   Written by Moritz Bunkus <moritz@bunkus.org>.
+*/
+
+#include "common/common_pch.h"
+
+#include "common/delta_coded_vector.h"
+
+static auto const s_no_cursor = std::numeric_limits<size_t>::max();
+
+delta_coded_vector_c::delta_coded_vector_c(size_t checkpoint_interval)
+  : m_size{}
+  , m_checkpoint_interval{std::max<size_t>(checkpoint_interval, 1)}
+  , m_last_value{}
+  , m_cursor_idx{s_no_cursor}
+  , m_cursor_offset{}
+  , m_cursor_value{}
+{
+}
+
+void
+delta_coded_vector_c::push_back(int64_t value) {
+  if (!(m_size % m_checkpoint_interval))
+    m_checkpoints.push_back(checkpoint_t{ m_data.size(), m_last_value });
+
+  // Calculate in unsigned arithmetic so that differences between
+  // extreme values wrap around instead of overflowing.
+  auto delta   = static_cast<uint64_t>(value) - static_cast<uint64_t>(m_last_value);
+  auto zigzag  = (delta << 1) ^ (0 - (delta >> 63));
+
+  while (zigzag >= 0x80) {
+    m_data.push_back(static_cast<unsigned char>(zigzag | 0x80));
+    zigzag >>= 7;
+  }
+  m_data.push_back(static_cast<unsigned char>(zigzag));
+
+  m_last_value = value;
+  ++m_size;
+}
+
+int64_t
+delta_coded_vector_c::decode_next(size_t &offset)
+  const {
+  auto zigzag = uint64_t{};
+  auto shift  = 0u;
+
+  while (true) {
+    auto byte  = m_data[offset++];
+    zigzag    |= static_cast<uint64_t>(byte & 0x7f) << shift;
+    shift     += 7;
+
+    if (!(byte & 0x80))
+      break;
+  }
+
+  return static_cast<int64_t>((zigzag >> 1) ^ (0 - (zigzag & 1)));
+}
+
+int64_t
+delta_coded_vector_c::at(size_t idx)
+  const {
+  assert(idx < m_size);
+
+  if (idx == m_cursor_idx)
+    return m_cursor_value;
+
+  auto checkpoint_idx = idx / m_checkpoint_interval;
+
+  // Continue from the cursor if it's located in front of the
+  // requested entry within the same checkpoint interval. Otherwise
+  // start decoding at the closest checkpoint.
+  if ((s_no_cursor == m_cursor_idx) || (m_cursor_idx > idx) || ((m_cursor_idx / m_checkpoint_interval) != checkpoint_idx)) {
+    auto const &checkpoint = m_checkpoints[checkpoint_idx];
+    m_cursor_idx           = checkpoint_idx * m_checkpoint_interval;
+    m_cursor_offset        = checkpoint.offset;
+    m_cursor_value         = static_cast<int64_t>(static_cast<uint64_t>(checkpoint.previous_value) + static_cast<uint64_t>(decode_next(m_cursor_offset)));
+  }
+
+  while (m_cursor_idx < idx) {
+    m_cursor_value = static_cast<int64_t>(static_cast<uint64_t>(m_cursor_value) + static_cast<uint64_t>(decode_next(m_cursor_offset)));
+    ++m_cursor_idx;
+  }
+
+  return m_cursor_value;
+}
+
+void
+delta_coded_vector_c::clear() {
+  m_data.clear();
+  m_checkpoints.clear();
+
+  m_size         = 0;
+  m_last_value   = 0;
+  m_cursor_idx   = s_no_cursor;
+  m_cursor_value = 0;
+}
+
+void
+delta_coded_vector_c::shrink_to_fit() {
+  m_data.shrink_to_fit();
+  m_checkpoints.shrink_to_fit();
+}
+
+size_t
+delta_coded_vector_c::get_memory_usage()
+  const {
+  return m_data.capacity() + m_checkpoints.capacity() * sizeof(checkpoint_t);
+}
@@ -0,0 +1,79 @@
+/*
+   mkvmerge -- utility for splicing together matroska files
+   from component media subtypes
+
+   Distributed under the GPL v2
+   see the file COPYING for details
+   or visit http://www.gnu.org/copyleft/gpl.html
+
+   definitions for a compact, delta coded vector of integers
+
+   Written by Moritz Bunkus <moritz@bunkus.org>.
+*/
+
+#ifndef MTX_COMMON_DELTA_CODED_VECTOR_H
+#define MTX_COMMON_DELTA_CODED_VECTOR_H
+
+#include "common/common_pch.h"
+
+// Stores a sequence of 64-bit integers compactly. Each value is
+// stored as the difference to the previous value, zigzag coded into a
+// variable number of bytes (seven bits per byte). Monotonous or
+// slowly changing sequences such as file positions or timecodes
+// therefore only need one to four bytes per entry instead of eight.
+//
+// Every 'checkpoint_interval' entries the byte offset and the
+// preceding value are recorded. Accessing an arbitrary entry decodes
+// at most that many values. Accessing the entry following the one
+// accessed last (or the same one again) is handled by a cursor
+// without any search.
+//
+// Values can only be appended. As the cursor is updated by the const
+// accessors an object must not be read by several threads at the
+// same time.
+class delta_coded_vector_c {
+protected:
+  struct checkpoint_t {
+    size_t offset;
+    int64_t previous_value;
+  };
+
+  std::vector<unsigned char> m_data;
+  std::vector<checkpoint_t> m_checkpoints;
+  size_t m_size, m_checkpoint_interval;
+  int64_t m_last_value;
+
+  mutable size_t m_cursor_idx, m_cursor_offset;
+  mutable int64_t m_cursor_value;
+
+public:
+  delta_coded_vector_c(size_t checkpoint_interval = 64);
+
+  void push_back(int64_t value);
+  int64_t at(size_t idx) const;
+  int64_t operator [](size_t idx) const {
+    return at(idx);
+  }
+
+  int64_t back() const {
+    return m_last_value;
+  }
+  size_t size() const {
+    return m_size;
+  }
+  bool empty() const {
+    return !m_size;
+  }
+
+  void clear();
+  void shrink_to_fit();
+
+  // Number of bytes allocated for the coded values and the
+  // checkpoints.
+  size_t get_memory_usage() const;
+
+protected:
+  int64_t decode_next(size_t &offset) const;
+};
+
+#endif  // MTX_COMMON_DELTA_CODED_VECTOR_H
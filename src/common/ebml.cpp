@@ -30,6 +30,8 @@
 #include <ebml/EbmlVoid.h>
 
 #include <matroska/KaxChapters.h>
+#include <matroska/KaxCues.h>
+#include <matroska/KaxCuesData.h>
 #include <matroska/KaxTags.h>
 #include <matroska/KaxTrackAudio.h>
 #include <matroska/KaxTrackVideo.h>
@@ -554,3 +556,42 @@ write_ebml_element_head(mm_io_c &out,
 
   return out.write(buffer, id_size + coded_size);
 }
+
+int64_t
+find_cluster_position_in_cues(KaxCues &cues,
+                              int64_t timecode,
+                              int64_t timecode_scale) {
+  auto best_time     = int64_t{-1};
+  auto best_position = int64_t{-1};
+
+  for (auto cues_child : cues) {
+    auto point = dynamic_cast<KaxCuePoint *>(cues_child);
+    if (!point)
+      continue;
+
+    auto time = static_cast<int64_t>(FindChildValue<KaxCueTime, uint64_t>(*point, 0)) * timecode_scale;
+    if ((time > timecode) || (time < best_time))
+      continue;
+
+    // A cue point can have positions for several tracks. Reading must
+    // start at the earliest one.
+    auto position = int64_t{-1};
+    for (auto point_child : *point) {
+      auto positions = dynamic_cast<KaxCueTrackPositions *>(point_child);
+      if (!positions)
+        continue;
+
+      auto cluster_position = FindChildValue<KaxCueClusterPosition, int64_t>(*positions, -1);
+      if ((-1 != cluster_position) && ((-1 == position) || (cluster_position < position)))
+        position = cluster_position;
+    }
+
+    if (-1 == position)
+      continue;
+
+    best_time     = time;
+    best_position = position;
+  }
+
+  return best_position;
+}
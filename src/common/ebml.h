@@ -21,6 +21,10 @@
 
 #include <matroska/KaxTracks.h>
 
+namespace libmatroska {
+  class KaxCues;
+};
+
 using namespace libebml;
 using namespace libmatroska;
 
@@ -47,6 +51,11 @@ int kt_get_v_pixel_height(KaxTrackEntry &track);
 
 int write_ebml_element_head(mm_io_c &out, EbmlId const &id, int64_t content_size);
 
+// Returns the position of the cluster the last cue point at or before
+// 'timecode' (in ns) refers to. The position is relative to the start
+// of the segment's data. Returns -1 if there's no such cue point.
+int64_t find_cluster_position_in_cues(KaxCues &cues, int64_t timecode, int64_t timecode_scale);
+
 #if !defined(EBML_INFO)
 #define EBML_INFO(ref)  ref::ClassInfos
 #endif
@@ -11,8 +11,8 @@
    Written by Moritz Bunkus <moritz@bunkus.org>.
 */
 
-#ifndef MTX_COMMON_PGSSUP_H
-#define MTX_COMMON_PGSSUP_H
+#ifndef MTX_COMMON_HDSUB_H
+#define MTX_COMMON_HDSUB_H
 
 #define HDSUB_FILE_MAGIC 0x5350 // "SP" big endian
 
@@ -116,6 +116,9 @@
 #define HEVC_SLICE_TYPE_B   1
 #define HEVC_SLICE_TYPE_I   2
 
+// Upper limit for the part of a slice header the parser reads
+#define HEVC_SLICE_HEADER_MAX_SIZE 128
+
 #define HEVC_EXTENDED_SAR        0xff
 #define HEVC_NUM_PREDEFINED_PARS   17
 
@@ -483,8 +486,10 @@ protected:
 
   memory_cptr m_unparsed_buffer;
   uint64_t m_stream_position, m_parsed_position;
+  size_t m_unparsed_marker_size;
 
   hevc_frame_t m_incomplete_frame;
+  std::vector<memory_cptr> m_incomplete_frame_extra_data, m_incomplete_frame_slices;
   bool m_have_incomplete_frame;
   std::deque<memory_cptr> m_unhandled_nalus;
 
@@ -619,9 +624,10 @@ protected:
   void handle_slice_nalu(memory_cptr &nalu);
   void cleanup();
   void flush_incomplete_frame();
+  void assemble_incomplete_frame();
   void flush_unhandled_nalus();
   void write_nalu_size(unsigned char *buffer, size_t size, int this_nalu_size_length = -1) const;
-  memory_cptr create_nalu_with_size(const memory_cptr &src, bool add_extra_data = false);
+  memory_cptr create_nalu_with_size(const memory_cptr &src);
   void init_nalu_names();
 };
 typedef std::shared_ptr<hevc_es_parser_c> hevc_es_parser_cptr;
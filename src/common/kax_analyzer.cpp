@@ -14,11 +14,19 @@
 #include "common/common_pch.h"
 
 #include <algorithm>
+#if defined(SYS_WINDOWS)
+# include <windows.h>
+#else
+# include <sys/stat.h>
+# include <sys/types.h>
+#endif
 
 #include <ebml/EbmlHead.h>
 #include <ebml/EbmlStream.h>
 #include <ebml/EbmlVoid.h>
 #include <matroska/KaxCluster.h>
+#include <matroska/KaxInfo.h>
+#include <matroska/KaxInfoData.h>
 #include <matroska/KaxSeekHead.h>
 #include <matroska/KaxSegment.h>
 #include <matroska/KaxTags.h>
@@ -28,6 +36,8 @@
 #include "common/kax_analyzer.h"
 #include "common/mm_io_x.h"
 #include "common/strings/editing.h"
+#include "common/strings/utf8.h"
+#include "common/vint.h"
 
 using namespace libebml;
 using namespace libmatroska;
@@ -36,6 +46,37 @@ using namespace libmatroska;
 
 #define CONSOLE_PERCENTAGE_WIDTH 25
 
+// "mtxi"
+static uint32_t const s_index_file_magic   = 0x6d747869;
+static uint32_t const s_index_file_version = 2;
+
+// Returns the modification time in the finest resolution the system
+// offers: nanoseconds on Unix, 100 nanosecond units on Windows. Only
+// compared for equality.
+static int64_t
+get_modification_time(std::string const &file_name) {
+#if defined(SYS_WINDOWS)
+  WIN32_FILE_ATTRIBUTE_DATA attributes;
+  if (!GetFileAttributesExW(to_wide(file_name).c_str(), GetFileExInfoStandard, &attributes))
+    return -1;
+
+  return (static_cast<int64_t>(attributes.ftLastWriteTime.dwHighDateTime) << 32) | attributes.ftLastWriteTime.dwLowDateTime;
+
+#else
+  struct stat st;
+  if (0 != stat(file_name.c_str(), &st))
+    return -1;
+
+# if defined(SYS_APPLE)
+  auto const &mtime = st.st_mtimespec;
+# else
+  auto const &mtime = st.st_mtim;
+# endif
+
+  return static_cast<int64_t>(mtime.tv_sec) * 1000000000ll + mtime.tv_nsec;
+#endif
+}
+
 bool
 operator <(const kax_analyzer_data_cptr &d1,
            const kax_analyzer_data_cptr &d2) {
@@ -66,7 +107,10 @@ kax_analyzer_c::kax_analyzer_c(std::string file_name)
   , m_file(nullptr)
   , m_close_file(true)
   , m_stream(nullptr)
+  , m_parse_mode{parse_mode_full}
+  , m_use_index_file{}
   , m_debugging_requested{"kax_analyzer"}
+  , m_debug_index_file{"kax_analyzer|kax_analyzer_index_file"}
 {
 }
 
@@ -75,7 +119,10 @@ kax_analyzer_c::kax_analyzer_c(mm_file_io_c *file)
   , m_file(file)
   , m_close_file(false)
   , m_stream(nullptr)
+  , m_parse_mode{parse_mode_full}
+  , m_use_index_file{}
   , m_debugging_requested{"kax_analyzer"}
+  , m_debug_index_file{"kax_analyzer|kax_analyzer_index_file"}
 {
 }
 
@@ -231,6 +278,13 @@ kax_analyzer_c::process_internal(kax_analyzer_c::parse_mode_e parse_mode,
   m_file->setFilePointer(0);
   m_stream = new EbmlStream(*m_file);
 
+  if (m_use_index_file && load_index_file(parse_mode)) {
+    show_progress_done();
+    return true;
+  }
+
+  m_parse_mode = parse_mode;
+
   // Find the EbmlHead element. Must be the first one.
   EbmlElement *l0 = m_stream->FindNextID(EBML_INFO(EbmlHead), 0xFFFFFFFFL);
   if (!l0)
@@ -291,6 +345,9 @@ kax_analyzer_c::process_internal(kax_analyzer_c::parse_mode_e parse_mode,
     if (parse_mode_full != parse_mode)
       fix_element_sizes(file_size);
 
+    if (m_use_index_file)
+      save_index_file();
+
     return true;
   }
 
@@ -361,6 +418,9 @@ kax_analyzer_c::update_element(EbmlElement *e,
     return uer_error_unknown;
   }
 
+  if (m_use_index_file)
+    save_index_file();
+
   return uer_success;
 }
 
@@ -380,6 +440,9 @@ kax_analyzer_c::remove_elements(EbmlId id) {
     return result;
   }
 
+  if (m_use_index_file)
+    save_index_file();
+
   return uer_success;
 }
 
@@ -1116,6 +1179,232 @@ kax_analyzer_c::fix_element_sizes(uint64_t file_size) {
       m_data[i]->m_size = ((i + 1) < m_data.size() ? m_data[i + 1]->m_pos : file_size) - m_data[i]->m_pos;
 }
 
+std::string
+kax_analyzer_c::get_index_file_name()
+  const {
+  return m_file_name + ".mtxindex";
+}
+
+std::string
+kax_analyzer_c::read_segment_uid() {
+  auto idx = find(EBML_ID(KaxInfo));
+  if (-1 == idx)
+    return {};
+
+  auto info = read_element(idx);
+  auto uid  = info ? FindChild<KaxSegmentUID>(static_cast<EbmlMaster *>(info.get())) : nullptr;
+
+  return uid ? std::string{reinterpret_cast<char const *>(uid->GetBuffer()), static_cast<std::string::size_type>(uid->GetSize())} : std::string{};
+}
+
+/** \brief Use the elements stored in the index file if it is current
+
+    The index file is only used if the file's size and modification
+    time match the values stored. The segment UID is compared as
+    well so that an index file belonging to a different file with the
+    same name isn't used. An index file created in the fast parse mode
+    isn't used if the full mode is requested.
+
+    Modification times aren't reliable on all file systems, and a file
+    may be modified in place without changing its size. Therefore the
+    elements listed in the index must still be present at their
+    positions, too (see verify_index_elements()).
+ */
+bool
+kax_analyzer_c::load_index_file(parse_mode_e parse_mode) {
+  auto index_file_name = get_index_file_name();
+  auto mtime           = get_modification_time(m_file_name);
+
+  if ((-1 == mtime) || !bfs::exists(bfs::path{index_file_name}))
+    return false;
+
+  auto ok = false;
+
+  try {
+    ok = read_index_file(index_file_name, mtime, parse_mode);
+  } catch (...) {
+  }
+
+  mxdebug_if(m_debug_index_file, boost::format("kax_analyzer: index file %1% used: %2% (%3% elements)\n") % index_file_name % ok % m_data.size());
+
+  if (ok)
+    return true;
+
+  m_segment.reset();
+  m_data.clear();
+
+  return false;
+}
+
+bool
+kax_analyzer_c::read_index_file(std::string const &index_file_name,
+                                int64_t mtime,
+                                parse_mode_e parse_mode) {
+  auto content = mm_file_io_c::slurp(index_file_name);
+  mm_mem_io_c in{*content};
+
+  if (   (in.read_uint32_be() != s_index_file_magic)
+      || (in.read_uint32_be() != s_index_file_version)
+      || (in.read_uint64_be() != m_file->get_size())
+      || (static_cast<int64_t>(in.read_uint64_be()) != mtime))
+    return false;
+
+  auto index_parse_mode = in.read_uint8() ? parse_mode_full : parse_mode_fast;
+  if ((parse_mode_full == parse_mode) && (parse_mode_full != index_parse_mode))
+    return false;
+
+  auto segment_pos = in.read_uint64_be();
+  auto uid         = std::string(in.read_uint32_be(), '\0');
+  if (!uid.empty() && (in.read(&uid[0], uid.size()) != uid.size()))
+    return false;
+
+  auto num_elements = in.read_uint32_be();
+  for (auto idx = 0u; idx < num_elements; ++idx) {
+    auto id_value  = in.read_uint32_be();
+    auto id_length = in.read_uint8();
+    auto pos       = in.read_uint64_be();
+    auto size      = static_cast<int64_t>(in.read_uint64_be());
+
+    m_data.push_back(kax_analyzer_data_c::create(EbmlId(id_value, id_length), pos, size));
+  }
+
+  // Only the segment's head is read. Its UID is read from the segment
+  // info element found via the index.
+  m_file->setFilePointer(segment_pos);
+  auto l0 = m_stream->FindNextID(EBML_INFO(KaxSegment), 0xFFFFFFFFFFFFFFFFLL);
+  if (!l0)
+    return false;
+
+  if (!Is<KaxSegment>(l0) || (l0->GetElementPosition() != segment_pos)) {
+    delete l0;
+    return false;
+  }
+
+  m_segment = std::shared_ptr<KaxSegment>(static_cast<KaxSegment *>(l0));
+  if (!verify_index_elements() || (read_segment_uid() != uid))
+    return false;
+
+  m_parse_mode = index_parse_mode;
+
+  return true;
+}
+
+/** \brief Check that the elements read from the index file are present
+
+    Reads the ID and size of each element at the position stored in
+    the index. Clusters are never modified in place, and verifying all
+    of them would cost as much as parsing the file. Therefore only the
+    first and the last cluster are checked.
+ */
+bool
+kax_analyzer_c::verify_index_elements() {
+  auto file_size     = m_file->get_size();
+  auto first_cluster = -1, last_cluster = -1;
+
+  for (auto idx = 0u; idx < m_data.size(); ++idx)
+    if (Is<KaxCluster>(m_data[idx]->m_id)) {
+      if (-1 == first_cluster)
+        first_cluster = idx;
+      last_cluster = idx;
+    }
+
+  for (auto idx = 0u; idx < m_data.size(); ++idx) {
+    auto &data = *m_data[idx];
+
+    if ((data.m_pos + data.m_size) > static_cast<uint64_t>(file_size))
+      return false;
+
+    if (   Is<KaxCluster>(data.m_id)
+        && (static_cast<int>(idx) != first_cluster)
+        && (static_cast<int>(idx) != last_cluster))
+      continue;
+
+    m_file->setFilePointer(data.m_pos);
+    auto id   = vint_c::read_ebml_id(m_file);
+    auto size = vint_c::read(m_file);
+
+    // Elements with an unknown size have been assigned one by
+    // fix_element_sizes().
+    auto matches = id.is_valid()
+                && size.is_valid()
+                && (id.m_value      == static_cast<int64_t>(EBML_ID_VALUE(data.m_id)))
+                && (id.m_coded_size == static_cast<int>(EBML_ID_LENGTH(data.m_id)))
+                && (size.is_unknown() || ((id.m_coded_size + size.m_coded_size + size.m_value) == data.m_size));
+
+    if (!matches) {
+      mxdebug_if(m_debug_index_file, boost::format("kax_analyzer: index file element mismatch: %1%\n") % data.to_string());
+      return false;
+    }
+  }
+
+  return true;
+}
+
+void
+kax_analyzer_c::save_index_file() {
+  if (!m_segment)
+    return;
+
+  auto index_file_name = get_index_file_name();
+  auto temp_file_name  = std::string{};
+
+  try {
+    // Everything written so far must have reached the file before its
+    // modification time is taken.
+    m_file->flush();
+
+    auto mtime = get_modification_time(m_file_name);
+    if (-1 == mtime)
+      return;
+
+    auto uid = read_segment_uid();
+    mm_mem_io_c out{nullptr, 0, 1024};
+
+    out.write_uint32_be(s_index_file_magic);
+    out.write_uint32_be(s_index_file_version);
+    out.write_uint64_be(m_file->get_size());
+    out.write_uint64_be(mtime);
+    out.write_uint8(parse_mode_full == m_parse_mode ? 1 : 0);
+    out.write_uint64_be(m_segment->GetElementPosition());
+    out.write_uint32_be(uid.size());
+    out.write(uid.c_str(), uid.size());
+    out.write_uint32_be(m_data.size());
+
+    for (auto const &data : m_data) {
+      out.write_uint32_be(EBML_ID_VALUE(data->m_id));
+      out.write_uint8(EBML_ID_LENGTH(data->m_id));
+      out.write_uint64_be(data->m_pos);
+      out.write_uint64_be(data->m_size);
+    }
+
+    // Other processes must never see a partially written index
+    // file. It is written to a temporary file that replaces the old
+    // index file afterwards.
+    temp_file_name = bfs::unique_path(bfs::path{index_file_name + ".%%%%-%%%%.tmp"}).string();
+
+    {
+      mm_file_io_c index_file{temp_file_name, MODE_CREATE};
+      index_file.write(out.get_buffer(), out.getFilePointer());
+    }
+
+    bfs::rename(bfs::path{temp_file_name}, bfs::path{index_file_name});
+    temp_file_name.clear();
+
+    mxdebug_if(m_debug_index_file, boost::format("kax_analyzer: wrote index file %1% with %2% elements\n") % index_file_name % m_data.size());
+
+  } catch (mtx::mm_io::exception &ex) {
+    mxdebug_if(m_debug_index_file, boost::format("kax_analyzer: writing index file %1% failed: %2%\n") % index_file_name % ex.what());
+
+  } catch (bfs::filesystem_error &ex) {
+    mxdebug_if(m_debug_index_file, boost::format("kax_analyzer: writing index file %1% failed: %2%\n") % index_file_name % ex.what());
+  }
+
+  if (!temp_file_name.empty()) {
+    boost::system::error_code ec;
+    bfs::remove(bfs::path{temp_file_name}, ec);
+  }
+}
+
 kax_analyzer_c::placement_strategy_e
 kax_analyzer_c::get_placement_strategy_for(EbmlElement *e) {
   return Is<KaxTags>(e) ? ps_end : ps_anywhere;
@@ -97,7 +97,9 @@ private:
   std::shared_ptr<KaxSegment> m_segment;
   std::map<int64_t, bool> m_meta_seeks_by_position;
   EbmlStream *m_stream;
-  debugging_option_c m_debugging_requested;
+  parse_mode_e m_parse_mode;
+  bool m_use_index_file;
+  debugging_option_c m_debugging_requested, m_debug_index_file;
 
 public:                         // Static functions
   static bool probe(std::string file_name);
@@ -137,6 +139,16 @@ public:
 
   virtual bool process(parse_mode_e parse_mode = parse_mode_full, const open_mode mode = MODE_WRITE, bool throw_on_error = false);
 
+  // The results of process() are stored in an index file next to the
+  // Matroska file. Later runs use them instead of scanning the file
+  // again as long as the file's size, modification time and segment
+  // UID haven't changed. The index file is updated after each
+  // successful modification.
+  virtual void set_use_index_file(bool use_index_file) {
+    m_use_index_file = use_index_file;
+  }
+  virtual std::string get_index_file_name() const;
+
   virtual void show_progress_start(int64_t /* size */) {
   }
   virtual bool show_progress_running(int /* percentage */) {
@@ -188,6 +200,12 @@ protected:
   virtual void read_meta_seek(uint64_t pos, std::map<int64_t, bool> &positions_found);
   virtual void fix_element_sizes(uint64_t file_size);
 
+  virtual bool load_index_file(parse_mode_e parse_mode);
+  virtual bool read_index_file(std::string const &index_file_name, int64_t mtime, parse_mode_e parse_mode);
+  virtual bool verify_index_elements();
+  virtual void save_index_file();
+  virtual std::string read_segment_uid();
+
 protected:
   virtual bool process_internal(parse_mode_e parse_mode, const open_mode mode);
 };
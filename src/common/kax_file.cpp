@@ -19,8 +19,12 @@
 #include <ebml/EbmlStream.h>
 #include <ebml/EbmlVoid.h>
 #include <ebml/StdIOCallback.h>
+#include <matroska/KaxBlock.h>
 
+#include "common/at_scope_exit.h"
+#include "common/checksums/crc.h"
 #include "common/ebml.h"
+#include "common/endian.h"
 #include "common/fs_sys_helpers.h"
 #include "common/kax_file.h"
 #include "common/mm_io_x.h"
@@ -36,6 +40,8 @@ kax_file_c::kax_file_c(mm_io_cptr &in)
   , m_es(new EbmlStream(*m_in))
   , m_debug_read_next{"kax_file|kax_file_read_next"}
   , m_debug_resync{   "kax_file|kax_file_resync"}
+  , m_debug_skip_blocks{"kax_file|kax_file_skip_blocks"}
+  , m_debug_crc32{"kax_file|kax_file_crc32"}
 {
 }
 
@@ -145,7 +151,8 @@ kax_file_c::read_one_element() {
 
   EbmlElement *l2 = nullptr;
   try {
-    l1->Read(*m_es.get(), EBML_INFO_CONTEXT(*callbacks), upper_lvl_el, l2, true);
+    if (!Is<KaxCluster>(l1) || !read_cluster_skipping_blocks(*static_cast<KaxCluster *>(l1)))
+      l1->Read(*m_es.get(), EBML_INFO_CONTEXT(*callbacks), upper_lvl_el, l2, true);
 
   } catch (libebml::CRTError &e) {
     mxdebug_if(m_debug_resync, boost::format("exception reading element data: %1% (%2%)\n") % e.what() % e.getError());
@@ -163,6 +170,124 @@ kax_file_c::read_one_element() {
   return l1;
 }
 
+bool
+kax_file_c::read_cluster_skipping_blocks(KaxCluster &cluster) {
+  if ((m_skipped_track_numbers.empty() && m_headers_only_track_numbers.empty()) || !cluster.IsFiniteSize())
+    return false;
+
+  // Only the IDs, sizes and block headers are parsed here. All other
+  // children are read normally; the blocks of headers-only tracks
+  // without their payload. On any structural error the collected
+  // children are dropped and the caller reads the whole cluster the
+  // usual way, including libebml's error handling.
+  uint64_t data_start_pos = cluster.GetElementPosition() + cluster.HeadSize();
+  uint64_t data_end_pos   = data_start_pos + cluster.GetSize();
+  uint64_t pos            = data_start_pos;
+  uint64_t skipped_bytes  = 0;
+  auto num_skipped        = 0u;
+  auto num_headers_only   = 0u;
+  auto ok                 = true;
+  auto children           = std::vector<EbmlElement *>{};
+
+  try {
+    while (ok && (pos < data_end_pos)) {
+      m_in->setFilePointer(pos, seek_beginning);
+
+      auto id   = vint_c::read_ebml_id(m_in);
+      auto size = vint_c::read(m_in);
+
+      if (!id.is_valid() || !size.is_valid() || size.is_unknown() || ((m_in->getFilePointer() + size.m_value) > data_end_pos)) {
+        ok = false;
+        break;
+      }
+
+      uint64_t element_end_pos = m_in->getFilePointer() + size.m_value;
+      auto handling            = get_block_handling(id.m_value, element_end_pos);
+
+      if (bh_skip == handling) {
+        skipped_bytes += element_end_pos - pos;
+        ++num_skipped;
+        pos            = element_end_pos;
+        continue;
+      }
+
+      m_in->setFilePointer(pos, seek_beginning);
+
+      int upper_lvl_el = 0;
+      auto child       = m_es->FindNextElement(EBML_CLASS_CONTEXT(KaxCluster), upper_lvl_el, 0xFFFFFFFFL, true);
+
+      if (!child || (0 != upper_lvl_el)) {
+        delete child;
+        ok = false;
+        break;
+      }
+
+      children.push_back(child);
+
+      if (bh_headers_only == handling)
+        ++num_headers_only;
+
+      EbmlElement *l3 = nullptr;
+      child->Read(*m_es.get(), EBML_CONTEXT(child), upper_lvl_el, l3, true, bh_headers_only == handling ? SCOPE_PARTIAL_DATA : SCOPE_ALL_DATA);
+
+      pos = element_end_pos;
+    }
+
+  } catch (...) {
+    ok = false;
+  }
+
+  mxdebug_if(m_debug_skip_blocks,
+             boost::format("kax_file::read_cluster_skipping_blocks(): cluster at %1% ok %2% children %3% skipped blocks %4% skipped bytes %5% blocks without payload %6%\n")
+             % cluster.GetElementPosition() % ok % children.size() % num_skipped % skipped_bytes % num_headers_only);
+
+  if (!ok) {
+    for (auto child : children)
+      delete child;
+    m_in->setFilePointer(data_start_pos, seek_beginning);
+
+    return false;
+  }
+
+  for (auto child : children)
+    cluster.PushElement(*child);
+
+  return true;
+}
+
+kax_file_c::block_handling_e
+kax_file_c::get_block_handling(uint64_t id,
+                               uint64_t data_end_pos) {
+  auto handling_for = [this](vint_c const &track_number) {
+    return !track_number.is_valid()                                  ? bh_read
+         : m_skipped_track_numbers.count(track_number.m_value)       ? bh_skip
+         : m_headers_only_track_numbers.count(track_number.m_value)  ? bh_headers_only
+         :                                                             bh_read;
+  };
+
+  if (EBML_ID_VALUE(EBML_ID(KaxSimpleBlock)) == id)
+    return handling_for(vint_c::read(m_in));
+
+  if (EBML_ID_VALUE(EBML_ID(KaxBlockGroup)) != id)
+    return bh_read;
+
+  // A block group's track number is found in its block's header.
+  while (m_in->getFilePointer() < data_end_pos) {
+    auto child_id   = vint_c::read_ebml_id(m_in);
+    auto child_size = vint_c::read(m_in);
+
+    if (!child_id.is_valid() || !child_size.is_valid() || child_size.is_unknown())
+      return bh_read;
+
+    if (EBML_ID_VALUE(EBML_ID(KaxBlock)) == child_id.m_value)
+      return handling_for(vint_c::read(m_in));
+
+    m_in->setFilePointer(m_in->getFilePointer() + child_size.m_value, seek_beginning);
+  }
+
+  return bh_read;
+}
+
 bool
 kax_file_c::is_level1_element_id(vint_c id) const {
   const EbmlSemanticContext &context = EBML_CLASS_CONTEXT(KaxSegment);
@@ -323,3 +448,54 @@ void
 kax_file_c::set_last_timecode(int64_t last_timecode) {
   m_last_timecode = last_timecode;
 }
+
+void
+kax_file_c::set_skipped_track_numbers(std::unordered_set<uint64_t> const &track_numbers) {
+  m_skipped_track_numbers = track_numbers;
+}
+
+void
+kax_file_c::set_headers_only_track_numbers(std::unordered_set<uint64_t> const &track_numbers) {
+  m_headers_only_track_numbers = track_numbers;
+}
+
+kax_file_c::crc32_status_e
+kax_file_c::verify_crc32(EbmlElement *e) {
+  if (!e->IsFiniteSize() || (6 > e->GetSize()))
+    return crc32_missing;
+
+  auto data_start = e->GetElementPosition() + e->HeadSize();
+  auto remaining  = e->GetSize() - 6;
+  unsigned char crc32_element[6];
+
+  m_in->save_pos(data_start);
+  at_scope_exit_c restore_pos([this]() { m_in->restore_pos(); });
+
+  if (   (m_in->read(crc32_element, 6) != 6)
+      || (EBML_ID_VALUE(EBML_ID(EbmlCrc32)) != crc32_element[0])
+      || (0x84                              != crc32_element[1]))
+    return crc32_missing;
+
+  auto crc = mtx::checksum::crc32_ieee_le_c{0xffffffff};
+  crc.set_xor_result(0xffffffff);
+
+  auto buffer = memory_c::alloc(std::max<uint64_t>(std::min<uint64_t>(remaining, 1024 * 1024), 1));
+
+  while (remaining) {
+    auto to_read = std::min<uint64_t>(remaining, buffer->get_size());
+    if (m_in->read(buffer->get_buffer(), to_read) != to_read)
+      return crc32_invalid;
+
+    crc.add(buffer->get_buffer(), to_read);
+    remaining -= to_read;
+  }
+
+  crc.finish();
+
+  auto expected = get_uint32_le(&crc32_element[2]);
+  auto actual   = static_cast<uint32_t>(crc.get_result_as_uint());
+
+  mxdebug_if(m_debug_crc32, boost::format("verify_crc32: element at %1% size %2% stored 0x%|3$08x| calculated 0x%|4$08x|\n") % e->GetElementPosition() % e->GetSize() % expected % actual);
+
+  return expected == actual ? crc32_valid : crc32_invalid;
+}
@@ -16,6 +16,8 @@
 
 #include "common/common_pch.h"
 
+#include <unordered_set>
+
 #include <matroska/KaxSegment.h>
 #include <matroska/KaxCluster.h>
 
@@ -25,14 +27,28 @@ using namespace libebml;
 using namespace libmatroska;
 
 class kax_file_c {
+public:
+  enum crc32_status_e {
+    crc32_missing,
+    crc32_valid,
+    crc32_invalid,
+  };
+
 protected:
+  enum block_handling_e {
+    bh_read,
+    bh_skip,
+    bh_headers_only,
+  };
+
   mm_io_cptr m_in;
   bool m_resynced;
   uint64_t m_resync_start_pos, m_file_size;
   int64_t m_timecode_scale, m_last_timecode;
   std::shared_ptr<EbmlStream> m_es;
+  std::unordered_set<uint64_t> m_skipped_track_numbers, m_headers_only_track_numbers;
 
-  debugging_option_c m_debug_read_next, m_debug_resync;
+  debugging_option_c m_debug_read_next, m_debug_resync, m_debug_skip_blocks, m_debug_crc32;
 
 public:
   kax_file_c(mm_io_cptr &in);
@@ -54,8 +70,25 @@ public:
   virtual void set_timecode_scale(int64_t timecode_scale);
   virtual void set_last_timecode(int64_t last_timecode);
 
+  // Blocks belonging to these track numbers are not read into the
+  // clusters returned by read_next_cluster(). Only their headers are
+  // parsed, their payload is skipped.
+  virtual void set_skipped_track_numbers(std::unordered_set<uint64_t> const &track_numbers);
+
+  // Blocks belonging to these track numbers are read without their
+  // payload. Only the block headers and the lace sizes are read so
+  // that the frames' positions and sizes are known.
+  virtual void set_headers_only_track_numbers(std::unordered_set<uint64_t> const &track_numbers);
+
+  // Verifies the CRC-32 element a master element starts with against
+  // the master's remaining content. The content is read straight from
+  // the file; the current file position is kept.
+  virtual crc32_status_e verify_crc32(EbmlElement *e);
+
 protected:
   virtual EbmlElement *read_one_element();
+  virtual bool read_cluster_skipping_blocks(KaxCluster &cluster);
+  virtual block_handling_e get_block_handling(uint64_t id, uint64_t data_end_pos);
 
   virtual EbmlElement *read_next_level1_element_internal(uint32_t wanted_id = 0);
   virtual EbmlElement *resync_to_level1_element_internal(uint32_t wanted_id = 0);
@@ -23,16 +23,37 @@ memory_c::resize(size_t new_size)
   if (!its_counter)
     its_counter = new counter(nullptr, 0, false);
 
-  if (its_counter->is_free) {
-    its_counter->ptr  = (X *)saferealloc(its_counter->ptr, new_size + its_counter->offset);
-    its_counter->size = new_size + its_counter->offset;
+  auto total_size = new_size + its_counter->offset;
+
+  if (its_counter->is_free && (total_size <= its_counter->capacity))
+    // The pooled buffer is large enough already.
+    its_counter->size = total_size;
+
+  else if (its_counter->is_free && its_counter->capacity && (total_size <= memory_pool_c::ms_max_class_size)) {
+    X *tmp = memory_pool_c::allocate(total_size);
+    memcpy(tmp, its_counter->ptr, its_counter->size);
+    memory_pool_c::release(its_counter->ptr, its_counter->capacity);
+
+    its_counter->ptr      = tmp;
+    its_counter->size     = total_size;
+    its_counter->capacity = memory_pool_c::get_capacity(total_size);
+
+  } else if (its_counter->is_free) {
+    // Pooled buffers are allocated with malloc() and can therefore be
+    // resized with realloc(), too. They won't be returned to the pool
+    // afterwards, though.
+    its_counter->ptr      = (X *)saferealloc(its_counter->ptr, total_size);
+    its_counter->size     = total_size;
+    its_counter->capacity = 0;
 
   } else {
-    X *tmp = (X *)safemalloc(new_size);
+    X *tmp = memory_pool_c::allocate(new_size);
     memcpy(tmp, its_counter->ptr + its_counter->offset, std::min(new_size, its_counter->size - its_counter->offset));
-    its_counter->ptr     = tmp;
-    its_counter->is_free = true;
-    its_counter->size    = new_size;
+    its_counter->ptr      = tmp;
+    its_counter->is_free  = true;
+    its_counter->size     = new_size;
+    its_counter->capacity = memory_pool_c::get_capacity(new_size);
+    its_counter->owner.reset();
   }
 }
 
@@ -18,6 +18,8 @@
 
 #include <deque>
 
+#include "common/memory_pool.h"
+
 namespace mtx {
   namespace mem {
     class exception: public mtx::exception {
@@ -95,8 +97,9 @@ public:
   }
 
   explicit memory_c(size_t s)
-    : its_counter(new counter(static_cast<unsigned char *>(safemalloc(s)), s, true))
+    : its_counter(new counter(memory_pool_c::allocate(s), s, true))
   {
+    its_counter->capacity = memory_pool_c::get_capacity(s);
   }
 
   ~memory_c() {
@@ -151,7 +154,9 @@ public:
   }
 
   void grab() {
-    if (!its_counter || its_counter->is_free)
+    // Views keep their owner and therefore their memory alive
+    // already. There's no need to copy them.
+    if (!its_counter || its_counter->is_free || its_counter->owner)
       return;
 
     its_counter->ptr      = static_cast<unsigned char *>(safememdup(get_buffer(), get_size()));
@@ -161,8 +166,10 @@ public:
   }
 
   void lock() {
-    if (its_counter)
-      its_counter->is_free = false;
+    if (its_counter) {
+      its_counter->is_free  = false;
+      its_counter->capacity = 0;
+    }
   }
 
   void resize(size_t new_size) throw();
@@ -200,13 +207,19 @@ public:
 public:
   static memory_cptr
   alloc(size_t size) {
-    return memory_cptr(new memory_c(static_cast<unsigned char *>(safemalloc(size)), size, true));
+    return std::allocate_shared<memory_c>(memory_pool_allocator_c<memory_c>{}, size);
   };
 
   static inline memory_cptr
   clone(const void *buffer,
         size_t size) {
-    return memory_cptr(new memory_c(static_cast<unsigned char *>(safememdup(buffer, size)), size, true));
+    if (!buffer)
+      return std::allocate_shared<memory_c>(memory_pool_allocator_c<memory_c>{});
+
+    auto mem = alloc(size);
+    memcpy(mem->get_buffer(), buffer, size);
+
+    return mem;
   }
 
   static inline memory_cptr
@@ -214,9 +227,33 @@ public:
     return clone(buffer.c_str(), buffer.length());
   }
 
+  // Returns an object referencing memory owned by someone else,
+  // e.g. a memory mapped file. 'owner' is kept alive for as long as
+  // the returned object references the buffer.
+  static inline memory_cptr
+  view(void *buffer,
+       size_t size,
+       std::shared_ptr<void> const &owner) {
+    auto mem = std::allocate_shared<memory_c>(memory_pool_allocator_c<memory_c>{}, buffer, size, false);
+    if (mem->its_counter)
+      mem->its_counter->owner = owner;
+
+    return mem;
+  }
+
   static inline memory_cptr
   point_to(std::string &buffer) {
-    return std::make_shared<memory_c>(reinterpret_cast<unsigned char *>(&buffer[0]), buffer.length(), false);
+    return std::allocate_shared<memory_c>(memory_pool_allocator_c<memory_c>{}, reinterpret_cast<unsigned char *>(&buffer[0]), buffer.length(), false);
+  }
+
+  // memory_c objects are often created with 'new' by the readers;
+  // let them come from the pool, too.
+  static void *operator new(size_t size) {
+    return memory_pool_c::allocate(size);
+  }
+
+  static void operator delete(void *p, size_t size) {
+    memory_pool_c::release(p, size);
   }
 
 private:
@@ -226,6 +263,8 @@ private:
     bool is_free;
     unsigned count;
     size_t offset;
+    size_t capacity; // != 0 if 'ptr' was obtained from memory_pool_c
+    std::shared_ptr<void> owner;
 
     counter(X *p = nullptr,
             size_t s = 0,
@@ -236,7 +275,16 @@ private:
       , is_free(f)
       , count(c)
       , offset(0)
+      , capacity(0)
     { }
+
+    static void *operator new(size_t size) {
+      return memory_pool_c::allocate(size);
+    }
+
+    static void operator delete(void *p, size_t size) {
+      memory_pool_c::release(p, size);
+    }
   } *its_counter;
 
   void acquire(counter *c) throw() { // increment the count
@@ -248,7 +296,9 @@ private:
   void release() { // decrement the count, delete if it is 0
     if (its_counter) {
       if (--its_counter->count == 0) {
-        if (its_counter->is_free)
+        if (its_counter->is_free && its_counter->capacity)
+          memory_pool_c::release(its_counter->ptr, its_counter->capacity);
+        else if (its_counter->is_free)
           free(its_counter->ptr);
         delete its_counter;
       }
@@ -0,0 +1,222 @@
+/*
+   mkvmerge -- utility for splicing together matroska files
+   from component media subtypes
+
+   Distributed under the GPL v2
+   see the file COPYING for details
+   or visit http://www.gnu.org/copyleft/gpl.html
+
+   size class based memory pool
+
+   Written by Moritz Bunkus <moritz@bunkus.org>.
+*/
+
+#include "common/common_pch.h"
+
+#include <atomic>
+
+#include "common/memory_pool.h"
+
+namespace {
+
+// Upper limit for the number of bytes kept in a single free list.
+size_t const s_max_cached_bytes_per_class = 1024 * 1024;
+size_t const s_min_cached_buffers         = 16;
+
+struct statistics_t {
+  uint64_t allocations, reused, allocated, released, cached, freed, oversized;
+
+  statistics_t()
+    : allocations{}
+    , reused{}
+    , allocated{}
+    , released{}
+    , cached{}
+    , freed{}
+    , oversized{}
+  {
+  }
+};
+
+struct thread_cache_t {
+  std::vector<void *> free_lists[memory_pool_c::ms_num_classes];
+  statistics_t stats;
+
+  ~thread_cache_t();
+};
+
+// Statistics of all threads that have already terminated.
+std::atomic<uint64_t> s_allocations{}, s_reused{}, s_allocated{}, s_released{}, s_cached{}, s_freed{}, s_oversized{};
+
+// The cache pointer and the flag are trivial and therefore remain
+// accessible during a thread's shutdown. The reaper's destructor
+// releases the cache; buffers released after that point (e.g. by
+// global destructors) are freed directly.
+thread_local thread_cache_t *tl_cache{};
+thread_local bool tl_cache_gone{};
+
+struct thread_cache_reaper_t {
+  ~thread_cache_reaper_t() {
+    delete tl_cache;
+    tl_cache      = nullptr;
+    tl_cache_gone = true;
+  }
+};
+
+thread_local thread_cache_reaper_t tl_reaper;
+
+thread_cache_t::~thread_cache_t() {
+  for (auto &free_list : free_lists)
+    for (auto buffer : free_list)
+      free(buffer);
+
+  s_allocations += stats.allocations;
+  s_reused      += stats.reused;
+  s_allocated   += stats.allocated;
+  s_released    += stats.released;
+  s_cached      += stats.cached;
+  s_freed       += stats.freed;
+  s_oversized   += stats.oversized;
+}
+
+thread_cache_t *
+get_thread_cache() {
+  if (tl_cache || tl_cache_gone)
+    return tl_cache;
+
+  // Referencing the reaper makes sure it is constructed in this
+  // thread and destroyed when the thread exits.
+  static_cast<void>(&tl_reaper);
+  tl_cache = new thread_cache_t;
+
+  return tl_cache;
+}
+
+size_t
+get_class_idx(size_t size) {
+  auto class_idx  = 0u;
+  auto class_size = memory_pool_c::ms_min_class_size;
+
+  while (class_size < size) {
+    class_size <<= 1;
+    ++class_idx;
+  }
+
+  return class_idx;
+}
+
+unsigned char *
+allocate_from_system(size_t size) {
+  auto buffer = reinterpret_cast<unsigned char *>(malloc(size));
+  if (!buffer)
+    mxerror(boost::format(Y("memory_pool.cpp/allocate() called: malloc() returned nullptr for a size of %1% bytes.\n")) % size);
+
+  return buffer;
+}
+
+}
+
+size_t const memory_pool_c::ms_min_class_size;
+size_t const memory_pool_c::ms_max_class_size;
+size_t const memory_pool_c::ms_num_classes;
+
+size_t
+memory_pool_c::get_capacity(size_t size) {
+  if (size > ms_max_class_size)
+    return size;
+
+  return ms_min_class_size << get_class_idx(size);
+}
+
+unsigned char *
+memory_pool_c::allocate(size_t size) {
+  auto cache = get_thread_cache();
+
+  if (size > ms_max_class_size) {
+    if (cache) {
+      ++cache->stats.allocations;
+      ++cache->stats.oversized;
+    }
+
+    return allocate_from_system(size);
+  }
+
+  auto class_idx = get_class_idx(size);
+
+  if (!cache)
+    return allocate_from_system(ms_min_class_size << class_idx);
+
+  ++cache->stats.allocations;
+
+  auto &free_list = cache->free_lists[class_idx];
+  if (free_list.empty()) {
+    ++cache->stats.allocated;
+    return allocate_from_system(ms_min_class_size << class_idx);
+  }
+
+  ++cache->stats.reused;
+
+  auto buffer = free_list.back();
+  free_list.pop_back();
+
+  return reinterpret_cast<unsigned char *>(buffer);
+}
+
+void
+memory_pool_c::release(void *buffer,
+                       size_t size) {
+  if (!buffer)
+    return;
+
+  auto cache = get_thread_cache();
+  if (cache)
+    ++cache->stats.released;
+
+  if (!cache || (size > ms_max_class_size)) {
+    if (cache)
+      ++cache->stats.freed;
+    free(buffer);
+    return;
+  }
+
+  auto class_idx  = get_class_idx(size);
+  auto class_size = ms_min_class_size << class_idx;
+  auto &free_list = cache->free_lists[class_idx];
+
+  if (free_list.size() >= std::max(s_min_cached_buffers, s_max_cached_bytes_per_class / class_size)) {
+    ++cache->stats.freed;
+    free(buffer);
+    return;
+  }
+
+  ++cache->stats.cached;
+  free_list.push_back(buffer);
+}
+
+void
+memory_pool_c::dump_statistics() {
+  static debugging_option_c s_debug{"memory_pool"};
+
+  if (!s_debug)
+    return;
+
+  auto stats   = statistics_t{};
+  auto cache   = get_thread_cache();
+  auto buffers = size_t{};
+  auto bytes   = size_t{};
+
+  if (cache) {
+    stats = cache->stats;
+
+    for (auto class_idx = 0u; class_idx < ms_num_classes; ++class_idx) {
+      buffers += cache->free_lists[class_idx].size();
+      bytes   += cache->free_lists[class_idx].size() * (ms_min_class_size << class_idx);
+    }
+  }
+
+  mxdebug(boost::format("memory_pool: allocations: %1% (reused from pool: %2%, new: %3%, larger than %4% bytes: %5%); "
+                        "releases: %6% (kept in pool: %7%, freed: %8%); pooled in main thread at exit: %9% buffers with %10% bytes\n")
+          % (stats.allocations + s_allocations) % (stats.reused + s_reused) % (stats.allocated + s_allocated) % ms_max_class_size % (stats.oversized + s_oversized)
+          % (stats.released    + s_released)    % (stats.cached + s_cached) % (stats.freed     + s_freed)
+          % buffers % bytes);
+}
@@ -0,0 +1,99 @@
+/*
+   mkvmerge -- utility for splicing together matroska files
+   from component media subtypes
+
+   Distributed under the GPL v2
+   see the file COPYING for details
+   or visit http://www.gnu.org/copyleft/gpl.html
+
+   definitions for the size class based memory pool
+
+   Written by Moritz Bunkus <moritz@bunkus.org>.
+*/
+
+#ifndef MTX_COMMON_MEMORY_POOL_H
+#define MTX_COMMON_MEMORY_POOL_H
+
+// This header is included by common/memory.h and must therefore not
+// include common/common_pch.h itself.
+#include <cstddef>
+
+// Small and medium sized allocations are rounded up to a power of
+// two ("size class"). Released buffers are kept in a free list per
+// size class and per thread and handed out again for the next
+// allocation of the same class instead of going through malloc() and
+// free() each time. Each free list is capped so that a thread that
+// only releases buffers allocated by other threads doesn't hoard
+// memory.
+//
+// All buffers are obtained from malloc(). Code that takes over a
+// buffer and releases it with free() later on is therefore still
+// correct; the buffer simply doesn't return to the pool.
+class memory_pool_c {
+public:
+  static size_t const ms_min_class_size = 16;
+  static size_t const ms_max_class_size = 64 * 1024;
+  static size_t const ms_num_classes    = 13;
+
+  // Returns a buffer of at least 'size' bytes. The buffer's actual
+  // size can be queried with get_capacity().
+  static unsigned char *allocate(size_t size);
+
+  // Returns a buffer allocated with allocate(size) to the pool.
+  static void release(void *buffer, size_t size);
+
+  // Returns the number of usable bytes in a buffer obtained via
+  // allocate(size).
+  static size_t get_capacity(size_t size);
+
+  // Outputs the collected statistics if the debugging option
+  // 'memory_pool' is active.
+  static void dump_statistics();
+};
+
+// Allocator for the STL containers and std::allocate_shared() that
+// draws from memory_pool_c.
+template<typename T>
+class memory_pool_allocator_c {
+public:
+  typedef T value_type;
+
+  memory_pool_allocator_c() {
+  }
+
+  template<typename U>
+  memory_pool_allocator_c(memory_pool_allocator_c<U> const &) {
+  }
+
+  T *
+  allocate(std::size_t n) {
+    return reinterpret_cast<T *>(memory_pool_c::allocate(n * sizeof(T)));
+  }
+
+  void
+  deallocate(T *p,
+             std::size_t n) {
+    memory_pool_c::release(p, n * sizeof(T));
+  }
+
+  template<typename U>
+  struct rebind {
+    typedef memory_pool_allocator_c<U> other;
+  };
+};
+
+template<typename T, typename U>
+bool
+operator ==(memory_pool_allocator_c<T> const &,
+            memory_pool_allocator_c<U> const &) {
+  return true;
+}
+
+template<typename T, typename U>
+bool
+operator !=(memory_pool_allocator_c<T> const &,
+            memory_pool_allocator_c<U> const &) {
+  return false;
+}
+
+#endif  // MTX_COMMON_MEMORY_POOL_H
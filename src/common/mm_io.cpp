@@ -22,8 +22,12 @@
 #ifdef HAVE_UNISTD_H
 #include <unistd.h>
 #endif
+#include <fcntl.h>
 #include <sys/stat.h>
 #include <sys/types.h>
+#if defined(HAVE_SYS_SENDFILE_H)
+#include <sys/sendfile.h>
+#endif
 
 #include "common/endian.h"
 #include "common/error.h"
@@ -43,6 +47,9 @@ mm_file_io_c::mm_file_io_c(const std::string &path,
                            const open_mode mode)
   : m_file_name(path)
   , m_file(nullptr)
+  , m_readahead_size{}
+  , m_readahead_end{}
+  , m_debug_readahead{"mm_io_readahead|readahead"}
 {
   const char *cmode;
 
@@ -88,6 +95,12 @@ mm_file_io_c::setFilePointer(int64 offset,
     throw mtx::mm_io::seek_x{mtx::mm_io::make_error_code()};
 
   m_current_position = ftello((FILE *)m_file);
+
+  // Start a new readahead window if the new position is outside of
+  // the current one.
+  if (   (static_cast<uint64_t>(m_current_position) > m_readahead_end)
+      || ((m_current_position + m_readahead_size) < m_readahead_end))
+    m_readahead_end = m_current_position;
 }
 
 size_t
@@ -110,9 +123,139 @@ mm_file_io_c::_read(void *buffer,
 
   m_current_position += bread;
 
+  if (m_readahead_size)
+    issue_readahead();
+
   return bread;
 }
 
+void
+mm_file_io_c::enable_readahead(uint64_t size) {
+#if defined(HAVE_POSIX_FADVISE)
+  if (!m_file)
+    return;
+
+  m_readahead_size = size;
+  m_readahead_end  = m_current_position;
+
+  posix_fadvise(fileno(static_cast<FILE *>(m_file)), 0, 0, size ? POSIX_FADV_SEQUENTIAL : POSIX_FADV_NORMAL);
+
+  if (size)
+    issue_readahead();
+#else
+  (void)size;
+#endif
+}
+
+void
+mm_file_io_c::issue_readahead() {
+#if defined(HAVE_POSIX_FADVISE)
+  // Only top up the window once half of it has been consumed so that
+  // the kernel gets requests of a sensible size.
+  if ((m_current_position + m_readahead_size / 2) < m_readahead_end)
+    return;
+
+  auto start = std::max<uint64_t>(m_current_position, m_readahead_end);
+  auto end   = m_current_position + m_readahead_size;
+
+  // POSIX_FADV_WILLNEED only queues the reads; it returns immediately.
+  auto result = posix_fadvise(fileno(static_cast<FILE *>(m_file)), start, end - start, POSIX_FADV_WILLNEED);
+
+  mxdebug_if(m_debug_readahead, boost::format("readahead: %1% from %2% to %3% result %4%\n") % m_file_name % start % end % result);
+
+  m_readahead_end = end;
+#endif
+}
+
+void
+mm_file_io_c::flush() {
+  if (m_file)
+    fflush(static_cast<FILE *>(m_file));
+}
+
+void
+mm_file_io_c::copy_from(mm_file_io_c &source,
+                        uint64_t source_position,
+                        uint64_t size) {
+  // The kernel functions bypass stdio. Anything still buffered for
+  // this file must be written before the copied data.
+  flush();
+
+  auto in_fd   = fileno(static_cast<FILE *>(source.m_file));
+  auto out_fd  = fileno(static_cast<FILE *>(m_file));
+  auto in_pos  = static_cast<off_t>(source_position);
+  auto out_pos = static_cast<off_t>(m_current_position);
+
+#if defined(HAVE_COPY_FILE_RANGE)
+  // Not supported by older kernels and for some file system
+  // combinations. sendfile() or a normal copy are used then.
+  static auto s_copy_file_range_works = true;
+
+  while (size && s_copy_file_range_works) {
+    auto result = copy_file_range(in_fd, &in_pos, out_fd, &out_pos, size, 0);
+
+    if (0 < result)
+      size -= result;
+
+    else if ((-1 == result) && (EINTR == errno))
+      continue;
+
+    else {
+      if ((-1 == result) && ((ENOSYS == errno) || (EXDEV == errno) || (EINVAL == errno) || (EOPNOTSUPP == errno)))
+        s_copy_file_range_works = false;
+      break;
+    }
+  }
+#endif
+
+#if defined(HAVE_SENDFILE) && defined(HAVE_SYS_SENDFILE_H)
+  // sendfile() writes at the file descriptor's position.
+  if (size && (lseek(out_fd, out_pos, SEEK_SET) == out_pos)) {
+    while (size) {
+      auto result = sendfile(out_fd, in_fd, &in_pos, size);
+
+      if (0 < result) {
+        size    -= result;
+        out_pos += result;
+
+      } else if ((-1 == result) && (EINTR == errno))
+        continue;
+
+      else
+        break;
+    }
+  }
+#endif
+
+  if (fseeko(static_cast<FILE *>(m_file), out_pos, SEEK_SET) != 0)
+    throw mtx::mm_io::seek_x{mtx::mm_io::make_error_code()};
+
+  m_current_position = out_pos;
+  m_cached_size      = -1;
+
+  if (!size)
+    return;
+
+  // Whatever's left is copied the normal way.
+  auto buffer = memory_c::alloc(std::min<uint64_t>(size, 1024 * 1024));
+
+  source.save_pos(in_pos);
+
+  while (size) {
+    auto chunk = std::min<uint64_t>(size, buffer->get_size());
+
+    if (source.read(buffer->get_buffer(), chunk) != chunk) {
+      source.restore_pos();
+      throw mtx::mm_io::end_of_file_x{mtx::mm_io::make_error_code()};
+    }
+
+    write(buffer->get_buffer(), chunk);
+    size -= chunk;
+  }
+
+  source.restore_pos();
+}
+
 void
 mm_file_io_c::close() {
   if (m_file) {
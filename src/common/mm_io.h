@@ -114,6 +114,13 @@ public:
   virtual void enable_buffering(bool /* enable */) {
   }
 
+  // Asks the operating system to read up to 'size' bytes ahead of the
+  // current position in the background. Meant for readers that
+  // process their files mostly sequentially. A size of 0 disables
+  // readahead.
+  virtual void enable_readahead(uint64_t /* size */) {
+  }
+
 protected:
   virtual uint32 _read(void *buffer, size_t size) = 0;
   virtual size_t _write(const void *buffer, size_t size) = 0;
@@ -123,6 +130,8 @@ class mm_file_io_c: public mm_io_c {
 protected:
   std::string m_file_name;
   void *m_file;
+  uint64_t m_readahead_size, m_readahead_end;
+  debugging_option_c m_debug_readahead;
 
 #if defined(SYS_WINDOWS)
   bool m_eof;
@@ -149,6 +158,16 @@ public:
   }
 
   virtual int truncate(int64_t pos);
+  virtual void enable_readahead(uint64_t size);
+  virtual void flush();
+
+#if !defined(SYS_WINDOWS)
+  // Appends 'size' bytes located at 'source_position' in 'source' at
+  // the current position. The kernel copies the data directly
+  // between the files if possible. The source's position is not
+  // changed.
+  virtual void copy_from(mm_file_io_c &source, uint64_t source_position, uint64_t size);
+#endif
 
   static void setup();
   static void cleanup();
@@ -157,6 +176,7 @@ public:
 protected:
   virtual uint32 _read(void *buffer, size_t size);
   virtual size_t _write(const void *buffer, size_t size);
+  void issue_readahead();
 };
 
 typedef std::shared_ptr<mm_file_io_c> mm_file_io_cptr;
@@ -195,6 +215,9 @@ public:
   virtual mm_io_c *get_proxied() const {
     return m_proxy_io;
   }
+  virtual void enable_readahead(uint64_t size) {
+    m_proxy_io->enable_readahead(size);
+  }
 
 protected:
   virtual uint32 _read(void *buffer, size_t size);
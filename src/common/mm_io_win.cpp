@@ -47,6 +47,9 @@ mm_file_io_c::mm_file_io_c(const std::string &path,
                            const open_mode mode)
   : m_file_name(path)
   , m_file(nullptr)
+  , m_readahead_size{}
+  , m_readahead_end{}
+  , m_debug_readahead{"mm_io_readahead|readahead"}
   , m_eof(false)
 {
   DWORD access_mode, share_mode, disposition;
@@ -181,6 +184,13 @@ mm_file_io_c::_write(const void *buffer,
   return bytes_written;
 }
 
+void
+mm_file_io_c::flush() {
+  // Data isn't buffered. Flushing makes Windows update the file's
+  // metadata such as the modification time, too.
+  FlushFileBuffers((HANDLE)m_file);
+}
+
 bool
 mm_file_io_c::eof() {
   return m_eof;
@@ -212,6 +222,11 @@ void
 mm_file_io_c::setup() {
 }
 
+void
+mm_file_io_c::enable_readahead(uint64_t) {
+  // Windows' cache manager detects sequential access on its own.
+}
+
 static bool s_stdout_binmode_set = false;
 
 size_t
@@ -0,0 +1,290 @@
+/*
+   mkvmerge -- utility for splicing together matroska files
+   from component media subtypes
+
+   Distributed under the GPL v2
+   see the file COPYING for details
+   or visit http://www.gnu.org/copyleft/gpl.html
+
+   IO callback class for memory mapped files
+
+   Written by Moritz Bunkus <moritz@bunkus.org>.
+*/
+
+#include "common/common_pch.h"
+
+#if defined(SYS_WINDOWS)
+# include <windows.h>
+#else
+# include <fcntl.h>
+# include <sys/mman.h>
+# include <sys/stat.h>
+# include <sys/types.h>
+# include <unistd.h>
+#endif
+
+#include "common/locale.h"
+#include "common/mm_io_x.h"
+#include "common/mm_mmap_io.h"
+
+#if defined(SYS_WINDOWS)
+HANDLE CreateFileUtf8(LPCSTR lpFileName, DWORD dwDesiredAccess, DWORD dwShareMode, LPSECURITY_ATTRIBUTES lpSecurityAttributes, DWORD dwCreationDisposition, DWORD dwFlagsAndAttributes, HANDLE hTemplateFile);
+#endif
+
+mm_mmap_io_c::mode_e mm_mmap_io_c::ms_mode = mm_mmap_io_c::MODE_NEVER;
+uint64_t mm_mmap_io_c::ms_auto_min_size    = 64 * 1024 * 1024;
+
+// Windows are only used if the address space is too small for
+// mapping big files completely.
+static uint64_t const s_window_size_32bit = 64 * 1024 * 1024;
+
+static uint64_t
+get_mapping_granularity() {
+  static uint64_t s_granularity = 0;
+
+  if (!s_granularity) {
+#if defined(SYS_WINDOWS)
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    s_granularity = info.dwAllocationGranularity;
+#else
+    s_granularity = sysconf(_SC_PAGESIZE);
+#endif
+  }
+
+  return s_granularity;
+}
+
+mm_mmap_io_c::window_t::~window_t() {
+  if (!m_data)
+    return;
+
+#if defined(SYS_WINDOWS)
+  UnmapViewOfFile(m_data);
+#else
+  munmap(m_data, m_size);
+#endif
+}
+
+mm_mmap_io_c::mm_mmap_io_c(std::string const &path)
+  : m_file_name(path)
+#if defined(SYS_WINDOWS)
+  , m_file{}
+  , m_mapping{}
+#else
+  , m_file{-1}
+#endif
+  , m_size{}
+  , m_window_size{sizeof(void *) >= 8 ? std::numeric_limits<uint64_t>::max() : s_window_size_32bit}
+  , m_eof{}
+{
+#if defined(SYS_WINDOWS)
+  m_file = CreateFileUtf8(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, OPEN_EXISTING, 0, nullptr);
+  if (static_cast<HANDLE>(m_file) == INVALID_HANDLE_VALUE) {
+    m_file = nullptr;
+    throw mtx::mm_io::open_x{mtx::mm_io::make_error_code()};
+  }
+
+  LARGE_INTEGER size;
+  if (!GetFileSizeEx(static_cast<HANDLE>(m_file), &size)) {
+    auto error = mtx::mm_io::make_error_code();
+    close();
+    throw mtx::mm_io::open_x{error};
+  }
+
+  m_size = size.QuadPart;
+
+  if (m_size) {
+    m_mapping = CreateFileMapping(static_cast<HANDLE>(m_file), nullptr, PAGE_WRITECOPY, 0, 0, nullptr);
+    if (!m_mapping) {
+      auto error = mtx::mm_io::make_error_code();
+      close();
+      throw mtx::mm_io::open_x{error};
+    }
+  }
+
+#else  // SYS_WINDOWS
+  m_file = ::open(g_cc_local_utf8->native(path).c_str(), O_RDONLY);
+  if (-1 == m_file)
+    throw mtx::mm_io::open_x{mtx::mm_io::make_error_code()};
+
+  struct stat st;
+  if ((0 != fstat(m_file, &st)) || S_ISDIR(st.st_mode)) {
+    auto error = S_ISDIR(st.st_mode) ? std::make_error_code(std::errc::is_a_directory) : mtx::mm_io::make_error_code();
+    close();
+    throw mtx::mm_io::open_x{error};
+  }
+
+  m_size = st.st_size;
+#endif // SYS_WINDOWS
+}
+
+mm_mmap_io_c::~mm_mmap_io_c() {
+  close();
+}
+
+void
+mm_mmap_io_c::close() {
+  m_window.reset();
+
+#if defined(SYS_WINDOWS)
+  if (m_mapping) {
+    CloseHandle(static_cast<HANDLE>(m_mapping));
+    m_mapping = nullptr;
+  }
+
+  if (m_file) {
+    CloseHandle(static_cast<HANDLE>(m_file));
+    m_file = nullptr;
+  }
+
+#else
+  if (-1 != m_file) {
+    ::close(m_file);
+    m_file = -1;
+  }
+#endif
+}
+
+void
+mm_mmap_io_c::map_window(uint64_t offset,
+                         uint64_t size) {
+  auto granularity    = get_mapping_granularity();
+  auto window         = std::make_shared<window_t>();
+  auto mapping_offset = offset - (offset % granularity);
+  auto mapping_end    = std::min(m_size, std::max(offset + size, mapping_offset + std::min(m_window_size, m_size)));
+
+  window->m_offset = mapping_offset;
+  window->m_size   = mapping_end - mapping_offset;
+
+#if defined(SYS_WINDOWS)
+  window->m_data = static_cast<unsigned char *>(MapViewOfFile(static_cast<HANDLE>(m_mapping), FILE_MAP_COPY, mapping_offset >> 32, mapping_offset & 0xffffffffull, window->m_size));
+  if (!window->m_data)
+    throw mtx::mm_io::read_write_x{mtx::mm_io::make_error_code()};
+
+#else
+  auto mapping = mmap(nullptr, window->m_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, m_file, mapping_offset);
+  if (MAP_FAILED == mapping)
+    throw mtx::mm_io::read_write_x{mtx::mm_io::make_error_code()};
+
+  window->m_data = static_cast<unsigned char *>(mapping);
+
+  madvise(mapping, window->m_size, MADV_SEQUENTIAL);
+#endif
+
+  m_window = window;
+}
+
+uint64
+mm_mmap_io_c::getFilePointer() {
+  return m_current_position;
+}
+
+void
+mm_mmap_io_c::setFilePointer(int64 offset,
+                             seek_mode mode) {
+  int64_t new_pos
+    = seek_beginning == mode ? offset
+    : seek_end       == mode ? static_cast<int64_t>(m_size) + offset // offsets from the end are negative already
+    :                          m_current_position + offset;
+
+  if (0 > new_pos)
+    throw mtx::mm_io::seek_x{std::make_error_code(std::errc::invalid_argument)};
+
+  m_current_position = new_pos;
+  m_eof              = false;
+}
+
+int64_t
+mm_mmap_io_c::get_size() {
+  return m_size;
+}
+
+bool
+mm_mmap_io_c::eof() {
+  return m_eof;
+}
+
+void
+mm_mmap_io_c::clear_eof() {
+  m_eof = false;
+}
+
+uint32
+mm_mmap_io_c::_read(void *buffer,
+                    size_t size) {
+  auto dst   = static_cast<unsigned char *>(buffer);
+  auto total = uint32_t{};
+
+  while (size && (static_cast<uint64_t>(m_current_position) < m_size)) {
+    uint64_t position = m_current_position;
+    if (!m_window || (position < m_window->m_offset) || (position >= (m_window->m_offset + m_window->m_size)))
+      map_window(position, std::min<uint64_t>(size, m_size - position));
+
+    auto num_bytes = std::min<uint64_t>(size, m_window->m_offset + m_window->m_size - position);
+    memcpy(dst, m_window->m_data + position - m_window->m_offset, num_bytes);
+
+    dst                += num_bytes;
+    total              += num_bytes;
+    size               -= num_bytes;
+    m_current_position += num_bytes;
+  }
+
+  if (size)
+    m_eof = true;
+
+  return total;
+}
+
+memory_cptr
+mm_mmap_io_c::read(size_t size) {
+  uint64_t position = m_current_position;
+
+  if ((position + size) > m_size) {
+    m_current_position = std::max<uint64_t>(position, m_size);
+    m_eof              = true;
+    throw mtx::mm_io::end_of_file_x{};
+  }
+
+  if (!size)
+    return memory_c::alloc(0);
+
+  if (!m_window || (position < m_window->m_offset) || ((position + size) > (m_window->m_offset + m_window->m_size)))
+    map_window(position, size);
+
+  m_current_position += size;
+
+  return memory_c::view(m_window->m_data + position - m_window->m_offset, size, m_window);
+}
+
+size_t
+mm_mmap_io_c::_write(const void *,
+                     size_t) {
+  throw mtx::mm_io::wrong_read_write_access_x();
+}
+
+void
+mm_mmap_io_c::set_mode(mode_e mode) {
+  ms_mode = mode;
+}
+
+bool
+mm_mmap_io_c::should_be_used_for(std::string const &path) {
+  if (MODE_NEVER == ms_mode)
+    return false;
+
+  if (MODE_ALWAYS == ms_mode)
+    return true;
+
+  // Only map big files automatically, and only if they can be mapped
+  // in one piece.
+  if (sizeof(void *) < 8)
+    return false;
+
+  boost::system::error_code ec;
+  auto file_path = bfs::path{path};
+
+  return bfs::is_regular_file(file_path, ec)
+      && (bfs::file_size(file_path, ec) >= ms_auto_min_size)
+      && !ec;
+}
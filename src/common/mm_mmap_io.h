@@ -0,0 +1,93 @@
+/*
+   mkvmerge -- utility for splicing together matroska files
+   from component media subtypes
+
+   Distributed under the GPL v2
+   see the file COPYING for details
+   or visit http://www.gnu.org/copyleft/gpl.html
+
+   IO callback class definitions for memory mapped files
+
+   Written by Moritz Bunkus <moritz@bunkus.org>.
+*/
+
+#ifndef MTX_COMMON_MM_MMAP_IO_H
+#define MTX_COMMON_MM_MMAP_IO_H
+
+#include "common/common_pch.h"
+
+#include "common/mm_io.h"
+
+// Read-only access to a file via memory mapping. The whole file is
+// mapped at once on 64-bit systems. With a 32-bit address space the
+// file is mapped in windows that are moved as needed.
+//
+// read(size_t) returns views into the mapping instead of copies. The
+// views keep the window they point into mapped. Pages are mapped
+// copy-on-write so that modifications by the consumers are private.
+class mm_mmap_io_c: public mm_io_c {
+public:
+  enum mode_e {
+    MODE_NEVER,
+    MODE_AUTO,
+    MODE_ALWAYS,
+  };
+
+protected:
+  struct window_t {
+    unsigned char *m_data;
+    uint64_t m_offset, m_size;
+
+    window_t()
+      : m_data{}
+      , m_offset{}
+      , m_size{}
+    {
+    }
+    ~window_t();
+  };
+  typedef std::shared_ptr<window_t> window_cptr;
+
+  std::string m_file_name;
+#if defined(SYS_WINDOWS)
+  void *m_file, *m_mapping;
+#else
+  int m_file;
+#endif
+  uint64_t m_size, m_window_size;
+  window_cptr m_window;
+  bool m_eof;
+
+  static mode_e ms_mode;
+  static uint64_t ms_auto_min_size;
+
+public:
+  mm_mmap_io_c(std::string const &path);
+  virtual ~mm_mmap_io_c();
+
+  virtual uint64 getFilePointer();
+  virtual void setFilePointer(int64 offset, seek_mode mode = seek_beginning);
+  virtual memory_cptr read(size_t size);
+  using mm_io_c::read;
+  virtual void close();
+  virtual bool eof();
+  virtual void clear_eof();
+  virtual int64_t get_size();
+
+  virtual std::string get_file_name() const {
+    return m_file_name;
+  }
+
+  static void set_mode(mode_e mode);
+  static bool should_be_used_for(std::string const &path);
+
+protected:
+  virtual uint32 _read(void *buffer, size_t size);
+  virtual size_t _write(const void *buffer, size_t size);
+
+  void map_window(uint64_t offset, uint64_t size);
+};
+
+typedef std::shared_ptr<mm_mmap_io_c> mm_mmap_io_cptr;
+
+#endif  // MTX_COMMON_MM_MMAP_IO_H
@@ -171,6 +171,12 @@ mm_multi_file_io_c::enable_buffering(bool enable) {
     file.m_file->enable_buffering(enable);
 }
 
+void
+mm_multi_file_io_c::enable_readahead(uint64_t size) {
+  for (auto &file : m_files)
+    file.m_file->enable_readahead(size);
+}
+
 struct path_sorter_t {
   bfs::path m_path;
   int m_number;
@@ -53,6 +53,7 @@ public:
   virtual void create_verbose_identification_info(std::vector<std::string> &verbose_info);
   virtual void display_other_file_info();
   virtual void enable_buffering(bool enable);
+  virtual void enable_readahead(uint64_t size);
 
   static mm_io_cptr open_multi(const std::string &display_file_name, bool single_only = false);
 
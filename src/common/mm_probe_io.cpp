@@ -0,0 +1,126 @@
+/*
+   mkvmerge -- utility for splicing together matroska files
+   from component media subtypes
+
+   Distributed under the GPL v2
+   see the file COPYING for details
+   or visit http://www.gnu.org/copyleft/gpl.html
+
+   IO class caching the start of a file during file type detection
+
+   Written by Moritz Bunkus <moritz@bunkus.org>.
+*/
+
+#include "common/common_pch.h"
+
+#include "common/mm_io_x.h"
+#include "common/mm_probe_io.h"
+
+mm_probe_io_c::mm_probe_io_c(mm_io_c *in,
+                             size_t head_size,
+                             bool delete_in,
+                             size_t max_head_size)
+  : mm_proxy_io_c{in, delete_in}
+  , m_max_head_size{std::max(head_size, max_head_size)}
+  , m_pos{}
+  , m_size{in->get_size()}
+  , m_eof{}
+  , m_debug{"probe_io"}
+{
+  auto to_read = static_cast<size_t>(std::min<int64_t>(std::max<int64_t>(m_size, 0), head_size));
+  m_head       = memory_c::alloc(to_read);
+
+  in->setFilePointer(0, seek_beginning);
+  auto num_read = to_read ? in->read(m_head->get_buffer(), to_read) : 0;
+  m_head->set_size(num_read);
+
+  mxdebug_if(m_debug, boost::format("cached %1% of %2% bytes at the start of %3%\n") % num_read % m_size % get_file_name());
+}
+
+mm_probe_io_c::~mm_probe_io_c() {
+  close();
+}
+
+uint64
+mm_probe_io_c::getFilePointer() {
+  return m_pos;
+}
+
+void
+mm_probe_io_c::setFilePointer(int64 offset,
+                              seek_mode mode) {
+  int64_t new_pos
+    = seek_beginning == mode ? offset
+    : seek_end       == mode ? m_size + offset // offsets from the end are negative already
+    :                          m_pos  + offset;
+
+  if (0 > new_pos)
+    throw mtx::mm_io::seek_x{std::make_error_code(std::errc::invalid_argument)};
+
+  m_pos = new_pos;
+  m_eof = false;
+}
+
+int64_t
+mm_probe_io_c::get_size() {
+  return m_size;
+}
+
+uint32
+mm_probe_io_c::_read(void *buffer,
+                     size_t size) {
+  auto buf       = static_cast<unsigned char *>(buffer);
+  auto num_read  = size_t{};
+
+  if (m_pos <= static_cast<int64_t>(m_head->get_size()))
+    grow_head(m_pos + size);
+
+  auto head_size = static_cast<int64_t>(m_head->get_size());
+
+  if (m_pos < head_size) {
+    num_read = std::min<size_t>(size, head_size - m_pos);
+    std::memcpy(buf, m_head->get_buffer() + m_pos, num_read);
+    m_pos   += num_read;
+  }
+
+  if ((num_read < size) && (m_pos < m_size)) {
+    mxdebug_if(m_debug, boost::format("physical read from position %1% for %2%\n") % m_pos % (size - num_read));
+
+    m_proxy_io->setFilePointer(m_pos, seek_beginning);
+    auto num_read_proxy  = m_proxy_io->read(buf + num_read, size - num_read);
+    m_pos               += num_read_proxy;
+    num_read            += num_read_proxy;
+  }
+
+  if (num_read < size)
+    m_eof = true;
+
+  return num_read;
+}
+
+void
+mm_probe_io_c::grow_head(int64_t wanted_end) {
+  auto head_size = static_cast<int64_t>(m_head->get_size());
+
+  if ((wanted_end <= head_size) || (head_size >= static_cast<int64_t>(m_max_head_size)) || (head_size >= m_size))
+    return;
+
+  // Grow at least by a factor of two so that sequential reads don't
+  // cause many small physical reads.
+  auto new_size = std::min<int64_t>({ std::max<int64_t>(wanted_end, head_size * 2), static_cast<int64_t>(m_max_head_size), m_size });
+
+  m_head->resize(new_size);
+
+  m_proxy_io->setFilePointer(head_size, seek_beginning);
+  auto num_read = m_proxy_io->read(m_head->get_buffer() + head_size, new_size - head_size);
+  m_head->set_size(head_size + num_read);
+
+  mxdebug_if(m_debug, boost::format("grew the cache from %1% to %2% bytes\n") % head_size % m_head->get_size());
+}
+
+size_t
+mm_probe_io_c::_write(const void *,
+                      size_t) {
+  throw mtx::mm_io::wrong_read_write_access_x();
+  return 0;
+}
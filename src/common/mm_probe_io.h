@@ -0,0 +1,67 @@
+/*
+   mkvmerge -- utility for splicing together matroska files
+   from component media subtypes
+
+   Distributed under the GPL v2
+   see the file COPYING for details
+   or visit http://www.gnu.org/copyleft/gpl.html
+
+   IO class caching the start of a file during file type detection
+
+   Written by Moritz Bunkus <moritz@bunkus.org>.
+*/
+
+#ifndef MTX_COMMON_MM_PROBE_IO_H
+#define MTX_COMMON_MM_PROBE_IO_H
+
+#include "common/common_pch.h"
+
+#include "common/mm_io.h"
+
+// Reads the first head_size bytes of the proxied file once upon
+// construction. All reads within that range are served from memory
+// so that the many probe_file() functions called one after the other
+// don't have to seek back to the start and re-read the same data
+// over and over again.
+//
+// Reads continuing past the end of the cached range let it grow up to
+// max_head_size bytes so that most files are detected with a single
+// small read. Other reads beyond the cached range are passed on to
+// the proxied file.
+class mm_probe_io_c: public mm_proxy_io_c {
+protected:
+  memory_cptr m_head;
+  size_t m_max_head_size;
+  int64_t m_pos, m_size;
+  bool m_eof;
+  debugging_option_c m_debug;
+
+public:
+  mm_probe_io_c(mm_io_c *in, size_t head_size, bool delete_in = true, size_t max_head_size = 0);
+  virtual ~mm_probe_io_c();
+
+  virtual uint64 getFilePointer();
+  virtual void setFilePointer(int64 offset, seek_mode mode = seek_beginning);
+  virtual int64_t get_size();
+  virtual bool eof() {
+    return m_eof;
+  }
+  virtual void clear_eof() {
+    m_eof = false;
+  }
+
+  // The currently cached start of the file. It's shorter than the
+  // requested head size if the file itself is shorter.
+  memory_c const &get_head() const {
+    return *m_head;
+  }
+
+protected:
+  virtual uint32 _read(void *buffer, size_t size);
+  void grow_head(int64_t wanted_end);
+  virtual size_t _write(const void *buffer, size_t size);
+};
+
+typedef std::shared_ptr<mm_probe_io_c> mm_probe_io_cptr;
+
+#endif // MTX_COMMON_MM_PROBE_IO_H
@@ -141,3 +141,208 @@ void
 mm_write_buffer_io_c::discard_buffer() {
   m_fill = 0;
 }
+
+// ------------------------------------------------------------
+
+mm_async_write_buffer_io_c::mm_async_write_buffer_io_c(mm_io_c *out,
+                                                       size_t buffer_size,
+                                                       bool delete_out)
+  : mm_write_buffer_io_c(out, buffer_size, delete_out)
+  , m_af_pending_buffer(memory_c::alloc(buffer_size))
+  , m_pending_fill{}
+  , m_pending_end_position{}
+  , m_write_pending{}
+  , m_job_available{}
+  , m_write_in_progress{}
+  , m_exiting{}
+{
+  m_thread = std::thread{[this]() { run(); }};
+}
+
+mm_async_write_buffer_io_c::~mm_async_write_buffer_io_c() {
+  // Errors must not escape from the destructor. Whoever cares about
+  // them has to call close() explicitly before.
+  try {
+    close();
+
+  } catch (mtx::mm_io::exception &ex) {
+    mxwarn(boost::format(Y("Writing to the file '%1%' failed: %2%\n")) % get_file_name() % ex);
+    mm_write_buffer_io_c::discard_buffer();
+
+  } catch (...) {
+    mm_write_buffer_io_c::discard_buffer();
+  }
+
+  {
+    std::lock_guard<std::mutex> lock{m_mutex};
+    m_exiting = true;
+  }
+
+  m_cond.notify_all();
+  m_thread.join();
+}
+
+mm_io_cptr
+mm_async_write_buffer_io_c::open(const std::string &file_name,
+                                 size_t buffer_size) {
+  return mm_io_cptr(new mm_async_write_buffer_io_c(new mm_file_io_c(file_name, MODE_CREATE), buffer_size));
+}
+
+uint64
+mm_async_write_buffer_io_c::getFilePointer() {
+  // The underlying file's position must not be queried while the
+  // background thread is writing to it.
+  return m_write_pending ? m_pending_end_position + m_fill : mm_write_buffer_io_c::getFilePointer();
+}
+
+void
+mm_async_write_buffer_io_c::setFilePointer(int64 offset,
+                                           seek_mode mode) {
+  if ((seek_end != mode) && (static_cast<int64_t>(getFilePointer()) == (seek_beginning == mode ? offset : static_cast<int64_t>(getFilePointer()) + offset)))
+    return;
+
+  wait_for_pending_write();
+  mm_write_buffer_io_c::setFilePointer(offset, mode);
+}
+
+void
+mm_async_write_buffer_io_c::flush() {
+  wait_for_pending_write();
+  mm_write_buffer_io_c::flush();
+}
+
+void
+mm_async_write_buffer_io_c::close() {
+  if (!m_proxy_io)
+    return;
+
+  wait_for_pending_write();
+  mm_write_buffer_io_c::close();
+}
+
+// A write that the background thread hasn't started yet is cancelled.
+// One already in progress cannot be interrupted; it is waited for, and
+// its errors are ignored as its data is being discarded anyway.
+void
+mm_async_write_buffer_io_c::discard_buffer() {
+  if (m_write_pending) {
+    std::unique_lock<std::mutex> lock{m_mutex};
+
+    if (!m_write_in_progress)
+      m_job_available = false;
+
+    m_cond.wait(lock, [this]() { return !m_job_available; });
+
+    m_write_pending = false;
+    m_write_error   = nullptr;
+  }
+
+  mm_write_buffer_io_c::discard_buffer();
+}
+
+uint32
+mm_async_write_buffer_io_c::_read(void *buffer,
+                                  size_t size) {
+  wait_for_pending_write();
+  return mm_write_buffer_io_c::_read(buffer, size);
+}
+
+size_t
+mm_async_write_buffer_io_c::_write(const void *buffer,
+                                   size_t size) {
+  auto buf    = static_cast<const unsigned char *>(buffer);
+  auto remain = size;
+
+  while (remain) {
+    auto to_copy = std::min(remain, m_size - m_fill);
+
+    memcpy(m_buffer + m_fill, buf, to_copy);
+    m_fill += to_copy;
+    remain -= to_copy;
+    buf    += to_copy;
+
+    if (m_fill == m_size)
+      submit_buffer();
+  }
+
+  return size;
+}
+
+void
+mm_async_write_buffer_io_c::flush_buffer() {
+  wait_for_pending_write();
+  mm_write_buffer_io_c::flush_buffer();
+}
+
+void
+mm_async_write_buffer_io_c::submit_buffer() {
+  wait_for_pending_write();
+
+  m_pending_end_position = mm_proxy_io_c::getFilePointer() + m_fill;
+  m_pending_fill         = m_fill;
+  m_fill                 = 0;
+
+  std::swap(m_af_buffer, m_af_pending_buffer);
+  m_buffer = m_af_buffer->get_buffer();
+
+  mxdebug_if(m_debug_write, boost::format("submit_buffer() at %1% for %2%\n") % (m_pending_end_position - m_pending_fill) % m_pending_fill);
+
+  {
+    std::lock_guard<std::mutex> lock{m_mutex};
+    m_job_available = true;
+  }
+
+  m_write_pending = true;
+  m_cond.notify_all();
+}
+
+void
+mm_async_write_buffer_io_c::wait_for_pending_write() {
+  if (!m_write_pending)
+    return;
+
+  std::unique_lock<std::mutex> lock{m_mutex};
+  m_cond.wait(lock, [this]() { return !m_job_available; });
+
+  m_write_pending = false;
+
+  if (!m_write_error)
+    return;
+
+  auto error    = m_write_error;
+  m_write_error = nullptr;
+
+  std::rethrow_exception(error);
+}
+
+void
+mm_async_write_buffer_io_c::run() {
+  std::unique_lock<std::mutex> lock{m_mutex};
+
+  while (true) {
+    m_cond.wait(lock, [this]() { return m_job_available || m_exiting; });
+
+    if (!m_job_available)
+      return;
+
+    m_write_in_progress = true;
+    lock.unlock();
+
+    auto error = std::exception_ptr{};
+
+    try {
+      if (mm_proxy_io_c::_write(m_af_pending_buffer->get_buffer(), m_pending_fill) != m_pending_fill)
+        throw mtx::mm_io::insufficient_space_x();
+
+    } catch (...) {
+      error = std::current_exception();
+    }
+
+    lock.lock();
+
+    m_write_error       = error;
+    m_job_available     = false;
+    m_write_in_progress = false;
+    m_cond.notify_all();
+  }
+}
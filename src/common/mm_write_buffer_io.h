@@ -17,6 +17,11 @@
 
 #include "common/common_pch.h"
 
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <thread>
+
 #include "common/mm_io.h"
 
 class mm_write_buffer_io_c: public mm_proxy_io_c {
@@ -46,4 +51,42 @@ protected:
 };
 typedef std::shared_ptr<mm_write_buffer_io_c> mm_write_buffer_io_cptr;
 
+// Writes full buffers in a background thread while the caller keeps
+// filling the second buffer. All other operations on the underlying
+// file (seeking, reading, flushing) wait for the pending write to
+// finish first.
+class mm_async_write_buffer_io_c: public mm_write_buffer_io_c {
+protected:
+  memory_cptr m_af_pending_buffer;
+  size_t m_pending_fill;
+  uint64_t m_pending_end_position;
+  bool m_write_pending, m_job_available, m_write_in_progress, m_exiting;
+  std::exception_ptr m_write_error;
+
+  std::thread m_thread;
+  std::mutex m_mutex;
+  std::condition_variable m_cond;
+
+public:
+  mm_async_write_buffer_io_c(mm_io_c *out, size_t buffer_size, bool delete_out = true);
+  virtual ~mm_async_write_buffer_io_c();
+
+  virtual uint64 getFilePointer();
+  virtual void setFilePointer(int64 offset, seek_mode mode = seek_beginning);
+  virtual void flush();
+  virtual void close();
+  virtual void discard_buffer();
+
+  static mm_io_cptr open(const std::string &file_name, size_t buffer_size);
+
+protected:
+  virtual uint32 _read(void *buffer, size_t size);
+  virtual size_t _write(const void *buffer, size_t size);
+  virtual void flush_buffer();
+
+  void submit_buffer();
+  void wait_for_pending_write();
+  void run();
+};
+
 #endif // MTX_COMMON_MM_BUFFERED_IO_H
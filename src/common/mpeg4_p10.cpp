@@ -29,6 +29,7 @@
 #include "common/math.h"
 #include "common/mm_io.h"
 #include "common/mpeg4_p10.h"
+#include "common/start_code.h"
 #include "common/strings/formatting.h"
 
 namespace mpeg4 {
@@ -429,47 +430,22 @@ mpeg4::p10::slice_info_t::dump()
 
 void
 mpeg4::p10::nalu_to_rbsp(memory_cptr &buffer) {
-  int pos, size = buffer->get_size();
-  mm_mem_io_c d(nullptr, size, 100);
-  unsigned char *b = buffer->get_buffer();
-
-  for (pos = 0; pos < size; ++pos) {
-    if (   ((pos + 2) < size)
-        && (0 == b[pos])
-        && (0 == b[pos + 1])
-        && (3 == b[pos + 2])) {
-      d.write_uint8(0);
-      d.write_uint8(0);
-      pos += 2;
+  auto size = buffer->get_size();
+  auto rbsp = memory_c::alloc(size);
 
-    } else
-      d.write_uint8(b[pos]);
-  }
+  rbsp->set_size(mtx::start_code::remove_emulation_prevention_bytes(buffer->get_buffer(), size, rbsp->get_buffer(), size));
 
-  buffer = memory_cptr(new memory_c(d.get_and_lock_buffer(), d.getFilePointer(), true));
+  buffer = rbsp;
 }
 
 void
 mpeg4::p10::rbsp_to_nalu(memory_cptr &buffer) {
-  int pos, size = buffer->get_size();
-  mm_mem_io_c d(nullptr, size, 100);
-  unsigned char *b = buffer->get_buffer();
-
-  for (pos = 0; pos < size; ++pos) {
-    if (   ((pos + 2) < size)
-        && (0 == b[pos])
-        && (0 == b[pos + 1])
-        && (3 >= b[pos + 2])) {
-      d.write_uint8(0);
-      d.write_uint8(0);
-      d.write_uint8(3);
-      ++pos;
+  auto size = buffer->get_size();
+  auto nalu = memory_c::alloc(mtx::start_code::max_size_with_emulation_prevention_bytes(size));
 
-    } else
-      d.write_uint8(b[pos]);
-  }
+  nalu->set_size(mtx::start_code::add_emulation_prevention_bytes(buffer->get_buffer(), size, nalu->get_buffer()));
 
-  buffer = memory_cptr(new memory_c(d.get_and_lock_buffer(), d.getFilePointer(), true));
+  buffer = nalu;
 }
 
 bool
@@ -948,6 +924,7 @@ mpeg4::p10::avc_es_parser_c::avc_es_parser_c()
   , m_previous_frame_start_in_display_order{}
   , m_stream_position(0)
   , m_parsed_position(0)
+  , m_unparsed_marker_size{}
   , m_have_incomplete_frame(false)
   , m_ignore_nalu_size_length_errors(false)
   , m_discard_actual_frames(false)
@@ -1019,75 +996,114 @@ mpeg4::p10::avc_es_parser_c::remove_trailing_zero_bytes(memory_c &memory) {
 void
 mpeg4::p10::avc_es_parser_c::add_bytes(unsigned char *buffer,
                                        size_t size) {
-  memory_slice_cursor_c cursor;
-  int marker_size              = 0;
-  int previous_marker_size     = 0;
-  int previous_pos             = -1;
-  uint64_t previous_parsed_pos = m_parsed_position;
-
-  if (m_unparsed_buffer && (0 != m_unparsed_buffer->get_size()))
-    cursor.add_slice(m_unparsed_buffer);
-  cursor.add_slice(buffer, size);
-
-  if (3 <= cursor.get_remaining_size()) {
-    uint32_t marker =                               1 << 24
-                    | (unsigned int)cursor.get_char() << 16
-                    | (unsigned int)cursor.get_char() <<  8
-                    | (unsigned int)cursor.get_char();
+  // NALUs located completely inside 'buffer' are handled as
+  // references to it without being copied. Only the payload of the
+  // NALU that hasn't been terminated yet is kept in the unparsed
+  // buffer; its start code of m_unparsed_marker_size bytes begins at
+  // m_parsed_position. Before the first start code has been found
+  // the unparsed buffer contains the data seen so far instead.
+  auto old_size    = m_unparsed_buffer ? m_unparsed_buffer->get_size() : size_t{};
+  auto marker_size = m_unparsed_marker_size;
+  auto buffer_pos  = m_parsed_position + marker_size + old_size;
+  auto nalu_start  = size_t{};
+  auto pos         = size_t{};
 
-    while (1) {
-      if (NALU_START_CODE == marker)
-        marker_size = 4;
-      else if (NALU_START_CODE == (marker & 0x00ffffff))
-        marker_size = 3;
-
-      if (0 != marker_size) {
-        if (-1 != previous_pos) {
-          int new_size = cursor.get_position() - marker_size - previous_pos - previous_marker_size;
-          memory_cptr nalu(new memory_c(safemalloc(new_size), new_size, true));
-          cursor.copy(nalu->get_buffer(), previous_pos + previous_marker_size, new_size);
-          m_parsed_position = previous_parsed_pos + previous_pos;
-          remove_trailing_zero_bytes(*nalu);
-          handle_nalu(nalu);
-        }
-        previous_pos         = cursor.get_position() - marker_size;
-        previous_marker_size = marker_size;
-        marker_size          = 0;
+  m_stream_position += size;
+
+  if (m_unparsed_buffer) {
+    // A start code may straddle the border between old and new
+    // data. Two bytes of the new data are enough for finding such a
+    // start code. Positions are relative to the old data here.
+    m_unparsed_buffer->add(buffer, std::min<size_t>(size, 2));
+
+    auto data       = m_unparsed_buffer->get_buffer();
+    auto data_size  = m_unparsed_buffer->get_size();
+    auto start      = old_size >= 2 ? old_size - 2 : 0;
+    auto found      = start + mtx::start_code::find(data + start, data_size - start);
+    auto marker_pos = size_t{};
+
+    if (found < data_size) {
+      marker_pos = found && !data[found - 1] ? found - 1 : found;
+      m_unparsed_buffer->set_size(marker_pos);
+
+    } else {
+      m_unparsed_buffer->set_size(old_size);
+
+      found = old_size + mtx::start_code::find(buffer, size);
+      if (found >= (old_size + size)) {
+        m_unparsed_buffer->add(buffer, size);
+        return;
       }
 
-      if (!cursor.char_available())
-        break;
+      // The zero byte of a four-byte start code may still be part of
+      // the old data.
+      if ((found == old_size) && old_size && !data[old_size - 1])
+        marker_pos = old_size - 1;
+      else
+        marker_pos = found > old_size && !buffer[found - old_size - 1] ? found - 1 : found;
+
+      if (marker_pos < old_size)
+        m_unparsed_buffer->set_size(marker_pos);
+      else
+        m_unparsed_buffer->add(buffer, marker_pos - old_size);
+    }
 
-      marker <<= 8;
-      marker  |= (unsigned int)cursor.get_char();
+    // The unparsed buffer now contains exactly the NALU's payload and
+    // can be handed on as it is.
+    if (marker_size) {
+      remove_trailing_zero_bytes(*m_unparsed_buffer);
+      handle_nalu(m_unparsed_buffer);
     }
+
+    m_unparsed_buffer.reset();
+
+    m_parsed_position += marker_size + marker_pos;
+    marker_size        = found + 3 - marker_pos;
+    nalu_start         = found + 3 - old_size;
+    pos                = nalu_start;
   }
 
-  if (-1 == previous_pos)
-    previous_pos = 0;
+  while (pos < size) {
+    auto found = pos + mtx::start_code::find(buffer + pos, size - pos);
+    if (found >= size)
+      break;
 
-  m_stream_position += size;
-  m_parsed_position  = previous_parsed_pos + previous_pos;
+    // 00 00 01 preceded by a zero byte is a four-byte start code.
+    auto marker_pos = found && !buffer[found - 1] ? found - 1 : found;
+
+    if (marker_size) {
+      auto nalu         = memory_c::view(buffer + nalu_start, marker_pos - nalu_start, std::shared_ptr<void>{});
+      m_parsed_position = buffer_pos + nalu_start - marker_size;
+      remove_trailing_zero_bytes(*nalu);
+      handle_nalu(nalu);
+    }
 
-  int new_size = cursor.get_size() - previous_pos;
-  if (0 != new_size) {
-    m_unparsed_buffer = memory_cptr(new memory_c(safemalloc(new_size), new_size, true));
-    cursor.copy(m_unparsed_buffer->get_buffer(), previous_pos, new_size);
+    marker_size = found + 3 - marker_pos;
+    nalu_start  = found + 3;
+    pos         = found + 3;
+  }
 
-  } else
-    m_unparsed_buffer.reset();
+  m_parsed_position      = buffer_pos + nalu_start - marker_size;
+  m_unparsed_marker_size = marker_size;
+  m_unparsed_buffer      = memory_c::clone(buffer + nalu_start, size - nalu_start);
+
+  // The caller's buffer is only valid during this call.
+  for (auto &slice : m_incomplete_frame_slices)
+    slice->grab();
 }
 
 void
 mpeg4::p10::avc_es_parser_c::flush() {
-  if (m_unparsed_buffer && (5 <= m_unparsed_buffer->get_size())) {
-    m_parsed_position += m_unparsed_buffer->get_size();
-    int marker_size = get_uint32_be(m_unparsed_buffer->get_buffer()) == NALU_START_CODE ? 4 : 3;
-    handle_nalu(memory_c::clone(m_unparsed_buffer->get_buffer() + marker_size, m_unparsed_buffer->get_size() - marker_size));
+  if (m_unparsed_buffer && m_unparsed_marker_size && (5 <= (m_unparsed_marker_size + m_unparsed_buffer->get_size()))) {
+    m_parsed_position += m_unparsed_marker_size + m_unparsed_buffer->get_size();
+    handle_nalu(m_unparsed_buffer);
   }
 
   m_unparsed_buffer.reset();
+  m_unparsed_marker_size = 0;
+
   if (m_have_incomplete_frame) {
+    assemble_incomplete_frame();
     m_frames.push_back(m_incomplete_frame);
     m_have_incomplete_frame = false;
   }
@@ -1165,11 +1181,43 @@ mpeg4::p10::avc_es_parser_c::flush_incomplete_frame() {
   if (!m_have_incomplete_frame || !m_avcc_ready)
     return;
 
+  assemble_incomplete_frame();
   m_frames.push_back(m_incomplete_frame);
   m_incomplete_frame.clear();
   m_have_incomplete_frame = false;
 }
 
+// Creates the frame's content from the extra data NALUs and the
+// slices collected for it with a single allocation.
+void
+mpeg4::p10::avc_es_parser_c::assemble_incomplete_frame() {
+  auto size = size_t{};
+
+  for (auto const &mem : m_incomplete_frame_extra_data)
+    size += mem->get_size();
+  for (auto const &slice : m_incomplete_frame_slices)
+    size += m_nalu_size_length + slice->get_size();
+
+  auto frame  = memory_c::alloc(size);
+  auto buffer = frame->get_buffer();
+
+  for (auto const &mem : m_incomplete_frame_extra_data) {
+    memcpy(buffer, mem->get_buffer(), mem->get_size());
+    buffer += mem->get_size();
+  }
+
+  for (auto const &slice : m_incomplete_frame_slices) {
+    write_nalu_size(buffer, slice->get_size());
+    memcpy(buffer + m_nalu_size_length, slice->get_buffer(), slice->get_size());
+    buffer += m_nalu_size_length + slice->get_size();
+  }
+
+  m_incomplete_frame.m_data = frame;
+
+  m_incomplete_frame_extra_data.clear();
+  m_incomplete_frame_slices.clear();
+}
+
 void
 mpeg4::p10::avc_es_parser_c::flush_unhandled_nalus() {
   std::deque<memory_cptr>::iterator nalu = m_unhandled_nalus.begin();
@@ -1185,6 +1233,7 @@ mpeg4::p10::avc_es_parser_c::flush_unhandled_nalus() {
 void
 mpeg4::p10::avc_es_parser_c::handle_slice_nalu(memory_cptr &nalu) {
   if (!m_avcc_ready) {
+    nalu->grab();
     m_unhandled_nalus.push_back(nalu);
     return;
   }
@@ -1197,12 +1246,7 @@ mpeg4::p10::avc_es_parser_c::handle_slice_nalu(memory_cptr &nalu) {
     flush_incomplete_frame();
 
   if (m_have_incomplete_frame) {
-    memory_c &mem = *(m_incomplete_frame.m_data.get());
-    int offset    = mem.get_size();
-    mem.resize(offset + m_nalu_size_length + nalu->get_size());
-    write_nalu_size(mem.get_buffer() + offset, nalu->get_size());
-    memcpy(mem.get_buffer() + offset + m_nalu_size_length, nalu->get_buffer(), nalu->get_size());
-
+    m_incomplete_frame_slices.push_back(nalu);
     return;
   }
 
@@ -1233,8 +1277,9 @@ mpeg4::p10::avc_es_parser_c::handle_slice_nalu(memory_cptr &nalu) {
   // else if (!si.field_pic_flag || !si.bottom_field_flag)
   //     cleanup();
 
-  m_incomplete_frame.m_data = create_nalu_with_size(nalu, true);
-  m_have_incomplete_frame   = true;
+  m_incomplete_frame_extra_data.swap(m_extra_data);
+  m_incomplete_frame_slices.push_back(nalu);
+  m_have_incomplete_frame = true;
 
   if (!m_provided_stream_positions.empty() && (m_parsed_position >= m_provided_stream_positions.front())) {
     m_incomplete_frame.m_has_provided_timecode = true;
@@ -1422,7 +1467,11 @@ bool
 mpeg4::p10::avc_es_parser_c::parse_slice(memory_cptr &buffer,
                                          slice_info_t &si) {
   try {
-    bit_reader_c r(buffer->get_buffer(), buffer->get_size());
+    // Only the slice header is parsed. Therefore only as much of the
+    // NALU is unescaped as the largest header that is parsed can take.
+    unsigned char header[AVC_SLICE_HEADER_MAX_SIZE];
+    auto header_size = mtx::start_code::remove_emulation_prevention_bytes(buffer->get_buffer(), buffer->get_size(), header, AVC_SLICE_HEADER_MAX_SIZE);
+    bit_reader_c r(header, header_size);
 
     memset(&si, 0, sizeof(si));
 
@@ -1706,30 +1755,14 @@ mpeg4::p10::avc_es_parser_c::cleanup() {
 }
 
 memory_cptr
-mpeg4::p10::avc_es_parser_c::create_nalu_with_size(const memory_cptr &src,
-                                                   bool add_extra_data) {
-  int final_size = m_nalu_size_length + src->get_size(), offset = 0, size;
-  unsigned char *buffer;
-
-  if (add_extra_data) {
-    for (auto &mem : m_extra_data)
-      final_size += mem->get_size();
-    buffer = (unsigned char *)safemalloc(final_size);
-
-    for (auto &mem : m_extra_data) {
-      memcpy(buffer + offset, mem->get_buffer(), mem->get_size());
-      offset += mem->get_size();
-    }
-
-    m_extra_data.clear();
-  } else
-    buffer = (unsigned char *)safemalloc(final_size);
+mpeg4::p10::avc_es_parser_c::create_nalu_with_size(const memory_cptr &src) {
+  auto size   = src->get_size();
+  auto buffer = memory_c::alloc(m_nalu_size_length + size);
 
-  size = src->get_size();
-  write_nalu_size(buffer + offset, size);
-  memcpy(buffer + offset + m_nalu_size_length, src->get_buffer(), size);
+  write_nalu_size(buffer->get_buffer(), size);
+  memcpy(buffer->get_buffer() + m_nalu_size_length, src->get_buffer(), size);
 
-  return memory_cptr(new memory_c(buffer, final_size, true));
+  return buffer;
 }
 
 memory_cptr
@@ -45,6 +45,9 @@
 #define AVC_SLICE_TYPE2_SP 8
 #define AVC_SLICE_TYPE2_SI 9
 
+// Upper limit for the part of a slice header the parser reads
+#define AVC_SLICE_HEADER_MAX_SIZE 128
+
 #define AVC_EXTENDED_SAR        0xff
 #define AVC_NUM_PREDEFINED_PARS   17
 
@@ -272,8 +275,10 @@ protected:
 
   memory_cptr m_unparsed_buffer;
   uint64_t m_stream_position, m_parsed_position;
+  size_t m_unparsed_marker_size;
 
   avc_frame_t m_incomplete_frame;
+  std::vector<memory_cptr> m_incomplete_frame_extra_data, m_incomplete_frame_slices;
   bool m_have_incomplete_frame;
   std::deque<memory_cptr> m_unhandled_nalus;
 
@@ -428,9 +433,10 @@ protected:
   void cleanup();
   bool flush_decision(slice_info_t &si, slice_info_t &ref);
   void flush_incomplete_frame();
+  void assemble_incomplete_frame();
   void flush_unhandled_nalus();
   void write_nalu_size(unsigned char *buffer, size_t size, int this_nalu_size_length = -1) const;
-  memory_cptr create_nalu_with_size(const memory_cptr &src, bool add_extra_data = false);
+  memory_cptr create_nalu_with_size(const memory_cptr &src);
   void remove_trailing_zero_bytes(memory_c &memory);
   void init_nalu_names();
   void calculate_frame_order();
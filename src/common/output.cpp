@@ -13,6 +13,7 @@
 
 #include "common/common_pch.h"
 
+#include <mutex>
 #include <sstream>
 
 #include "common/ebml.h"
@@ -32,6 +33,7 @@ charset_converter_cptr g_cc_stdio = charset_converter_cptr(new charset_converter
 std::shared_ptr<mm_io_c> g_mm_stdio   = std::shared_ptr<mm_io_c>(new mm_stdio_c);
 
 static mxmsg_handler_t s_mxmsg_info_handler, s_mxmsg_warning_handler, s_mxmsg_error_handler;
+static thread_local unsigned int s_throw_on_mxerror{};
 
 void
 redirect_stdio(const mm_io_cptr &stdio) {
@@ -62,10 +64,14 @@ void
 mxmsg(unsigned int level,
       std::string message) {
   static bool s_saw_cr_after_nl = false;
+  static std::mutex s_mutex;
 
   if (g_suppress_info && (MXMSG_INFO == level))
     return;
 
+  // Messages may be emitted by reader threads as well.
+  std::lock_guard<std::mutex> lock(s_mutex);
+
   if ('\n' == message[0]) {
     message.erase(0, 1);
     g_mm_stdio->puts("\n");
@@ -141,9 +147,31 @@ default_mxerror(unsigned int,
 
 void
 mxerror(std::string const &error) {
+  if (s_throw_on_mxerror)
+    throw mtx::output::error_x{error};
+
   s_mxmsg_error_handler(MXMSG_ERROR, error);
 }
 
+throw_on_mxerror_c::throw_on_mxerror_c() {
+  ++s_throw_on_mxerror;
+}
+
+throw_on_mxerror_c::~throw_on_mxerror_c() {
+  --s_throw_on_mxerror;
+}
+
+void
+rethrow_thread_exception(std::exception_ptr const &exception) {
+  try {
+    std::rethrow_exception(exception);
+
+  } catch (mtx::output::error_x &ex) {
+    mxerror(ex.error());
+    throw;
+  }
+}
+
 void
 mxinfo_fn(const std::string &file_name,
           const std::string &info) {
@@ -16,6 +16,7 @@
 
 #include "common/os.h"
 
+#include <exception>
 #include <functional>
 
 #include <ebml/EbmlElement.h>
@@ -68,6 +69,37 @@ mxerror(const boost::format &error) {
   mxerror(error.str());
 }
 
+namespace mtx { namespace output {
+
+class error_x: public mtx::exception {
+protected:
+  std::string m_message;
+public:
+  error_x(std::string const &message) : m_message{message} { }
+  virtual ~error_x() throw() { }
+
+  virtual const char *what() const throw() {
+    return m_message.c_str();
+  }
+};
+
+}}
+
+// While an instance exists mxerror() called from the same thread
+// throws mtx::output::error_x instead of terminating the
+// program. Meant for background threads: exiting from there would
+// tear down the process while other threads are still running.
+class throw_on_mxerror_c {
+public:
+  throw_on_mxerror_c();
+  ~throw_on_mxerror_c();
+};
+
+// Re-throws an exception caught in a background thread. Errors that
+// were raised there via mxerror() are reported by the calling thread
+// as if they had been raised there.
+void rethrow_thread_exception(std::exception_ptr const &exception);
+
 #define mxverb(level, message)        \
   if (verbose >= level)               \
     mxinfo(message);
@@ -0,0 +1,93 @@
+/*
+   mkvmerge -- utility for splicing together matroska files
+   from component media subtypes
+
+   Distributed under the GPL v2
+   see the file COPYING for details
+   or visit http://www.gnu.org/copyleft/gpl.html
+
+   a bounded single producer/single consumer queue
+
+   Written by Moritz Bunkus <moritz@bunkus.org>.
+*/
+
+#ifndef MTX_COMMON_SPSC_QUEUE_H
+#define MTX_COMMON_SPSC_QUEUE_H
+
+#include "common/common_pch.h"
+
+#include <atomic>
+
+// A queue with a fixed capacity based on a ring buffer. One thread
+// may add items with try_push() while another thread removes them
+// with try_pop() at the same time without any locking. Both return
+// false instead of blocking if the queue is full or empty
+// respectively; waiting is up to the caller.
+//
+// The read and write positions are counters that only ever
+// increase. Both are accessed with sequentially consistent ordering
+// so that callers can pair them with a flag of their own for
+// signalling the other side without lost wake-ups.
+template<typename T>
+class spsc_queue_c {
+protected:
+  std::vector<T> m_items;
+  std::atomic<size_t> m_read_pos, m_write_pos;
+
+public:
+  spsc_queue_c(size_t capacity)
+    : m_items(std::max<size_t>(capacity, 1))
+    , m_read_pos{}
+    , m_write_pos{}
+  {
+  }
+
+  spsc_queue_c(spsc_queue_c const &) = delete;
+  spsc_queue_c &operator =(spsc_queue_c const &) = delete;
+
+  // Producer side
+  bool try_push(T item) {
+    auto write_pos = m_write_pos.load();
+    if ((write_pos - m_read_pos.load()) >= m_items.size())
+      return false;
+
+    m_items[write_pos % m_items.size()] = std::move(item);
+    m_write_pos.store(write_pos + 1);
+
+    return true;
+  }
+
+  // Consumer side. The slot is reset so that the queue doesn't keep
+  // objects alive that have already been removed.
+  bool try_pop(T &item) {
+    auto read_pos = m_read_pos.load();
+    if (read_pos == m_write_pos.load())
+      return false;
+
+    auto &slot = m_items[read_pos % m_items.size()];
+    item       = std::move(slot);
+    slot       = T{};
+    m_read_pos.store(read_pos + 1);
+
+    return true;
+  }
+
+  // Exact only when called by the producer or the consumer while the
+  // other side is idle. Otherwise it's a snapshot that may already be
+  // outdated.
+  size_t size() const {
+    auto read_pos = m_read_pos.load();
+    return m_write_pos.load() - read_pos;
+  }
+  bool empty() const {
+    return !size();
+  }
+  bool full() const {
+    return size() >= m_items.size();
+  }
+  size_t capacity() const {
+    return m_items.size();
+  }
+};
+
+#endif  // MTX_COMMON_SPSC_QUEUE_H
@@ -0,0 +1,257 @@
+/*
+   mkvmerge -- utility for splicing together matroska files
+   from component media subtypes
+
+   Distributed under the GPL v2
+   see the file COPYING for details
+   or visit http://www.gnu.org/copyleft/gpl.html
+
+   start code finder and emulation prevention byte handling
+
+   Written by Moritz Bunkus <moritz@bunkus.org>.
+*/
+
+#include "common/common_pch.h"
+
+// The vectorized versions are compiled with function specific target
+// attributes so that the rest of the program doesn't require SSE2 or
+// AVX2. gcc only provides the intrinsics in such functions from v4.9
+// on.
+#if (defined(__x86_64__) || defined(__i386__)) \
+  && (defined(__clang__) || (defined(__GNUC__) && ((__GNUC__ > 4) || ((__GNUC__ == 4) && (__GNUC_MINOR__ >= 9)))))
+# define MTX_START_CODE_X86_SIMD 1
+# include <immintrin.h>
+#endif
+
+#include "common/start_code.h"
+
+namespace mtx { namespace start_code {
+
+typedef size_t (*finder_t)(unsigned char const *buffer, size_t size);
+
+// All finders look for the first occurrence of two zero bytes
+// followed by a byte in the range [min_third, max_third]: start codes
+// (00 00 01), emulation prevention bytes (00 00 03) and sequences that
+// require an emulation prevention byte (00 00 00..03).
+template<unsigned char min_third, unsigned char max_third>
+static size_t
+find_scalar(unsigned char const *buffer,
+            size_t size) {
+  size_t pos = 0;
+
+  // Look at the third byte of a potential match first. If it isn't 0
+  // then none of the two positions following the current one can
+  // start a match.
+  while ((pos + 2) < size) {
+    auto third = buffer[pos + 2];
+
+    if ((third >= min_third) && (third <= max_third) && !buffer[pos] && !buffer[pos + 1])
+      return pos;
+
+    pos += third ? 3 : 1;
+  }
+
+  return size;
+}
+
+#if defined(MTX_START_CODE_X86_SIMD)
+
+template<unsigned char min_third, unsigned char max_third>
+__attribute__((target("sse2")))
+static size_t
+find_sse2(unsigned char const *buffer,
+          size_t size) {
+  auto zero  = _mm_setzero_si128();
+  auto low   = _mm_set1_epi8(min_third);
+  auto high  = _mm_set1_epi8(max_third);
+  size_t pos = 0;
+
+  while ((pos + 16 + 2) <= size) {
+    auto first    = _mm_loadu_si128(reinterpret_cast<__m128i const *>(buffer + pos));
+    auto second   = _mm_loadu_si128(reinterpret_cast<__m128i const *>(buffer + pos + 1));
+    auto third    = _mm_loadu_si128(reinterpret_cast<__m128i const *>(buffer + pos + 2));
+    auto third_ok = min_third == max_third ? _mm_cmpeq_epi8(third, low) : _mm_cmpeq_epi8(_mm_min_epu8(_mm_max_epu8(third, low), high), third);
+    auto match    = _mm_and_si128(_mm_and_si128(_mm_cmpeq_epi8(first, zero), _mm_cmpeq_epi8(second, zero)), third_ok);
+    auto mask     = static_cast<unsigned int>(_mm_movemask_epi8(match));
+
+    if (mask)
+      return pos + __builtin_ctz(mask);
+
+    pos += 16;
+  }
+
+  return pos + find_scalar<min_third, max_third>(buffer + pos, size - pos);
+}
+
+template<unsigned char min_third, unsigned char max_third>
+__attribute__((target("avx2")))
+static size_t
+find_avx2(unsigned char const *buffer,
+          size_t size) {
+  auto zero  = _mm256_setzero_si256();
+  auto low   = _mm256_set1_epi8(min_third);
+  auto high  = _mm256_set1_epi8(max_third);
+  size_t pos = 0;
+
+  while ((pos + 32 + 2) <= size) {
+    auto first    = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(buffer + pos));
+    auto second   = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(buffer + pos + 1));
+    auto third    = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(buffer + pos + 2));
+    auto third_ok = min_third == max_third ? _mm256_cmpeq_epi8(third, low) : _mm256_cmpeq_epi8(_mm256_min_epu8(_mm256_max_epu8(third, low), high), third);
+    auto match    = _mm256_and_si256(_mm256_and_si256(_mm256_cmpeq_epi8(first, zero), _mm256_cmpeq_epi8(second, zero)), third_ok);
+    auto mask     = static_cast<unsigned int>(_mm256_movemask_epi8(match));
+
+    if (mask)
+      return pos + __builtin_ctz(mask);
+
+    pos += 32;
+  }
+
+  return pos + find_sse2<min_third, max_third>(buffer + pos, size - pos);
+}
+
+#endif  // MTX_START_CODE_X86_SIMD
+
+static implementation_e
+detect_implementation() {
+#if defined(MTX_START_CODE_X86_SIMD)
+  __builtin_cpu_init();
+
+  if (__builtin_cpu_supports("avx2"))
+    return IMPLEMENTATION_AVX2;
+
+  if (__builtin_cpu_supports("sse2"))
+    return IMPLEMENTATION_SSE2;
+#endif
+
+  return IMPLEMENTATION_SCALAR;
+}
+
+template<unsigned char min_third, unsigned char max_third>
+static finder_t
+get_finder(implementation_e implementation) {
+#if defined(MTX_START_CODE_X86_SIMD)
+  if (IMPLEMENTATION_AVX2 == implementation)
+    return find_avx2<min_third, max_third>;
+
+  if (IMPLEMENTATION_SSE2 == implementation)
+    return find_sse2<min_third, max_third>;
+#else
+  static_cast<void>(implementation);
+#endif
+
+  return find_scalar<min_third, max_third>;
+}
+
+static size_t
+remove_emulation_prevention_bytes(finder_t finder,
+                                  unsigned char const *src,
+                                  size_t src_size,
+                                  unsigned char *dest,
+                                  size_t dest_size) {
+  size_t src_pos = 0, dest_pos = 0;
+
+  while ((src_pos < src_size) && (dest_pos < dest_size)) {
+    // Don't search further than the bytes that still fit into the
+    // destination so that only a small part of large NALUs is looked
+    // at if only their beginning is needed.
+    auto room     = dest_size - dest_pos;
+    auto limit    = std::min(src_size - src_pos, room + 2);
+    auto found    = src_pos + finder(src + src_pos, limit);
+    auto num_copy = std::min(std::min(found + 2, src_size) - src_pos, room);
+
+    memcpy(dest + dest_pos, src + src_pos, num_copy);
+
+    dest_pos += num_copy;
+    src_pos   = found + 3;
+  }
+
+  return dest_pos;
+}
+
+static size_t
+add_emulation_prevention_bytes(finder_t finder,
+                               unsigned char const *src,
+                               size_t src_size,
+                               unsigned char *dest) {
+  size_t src_pos = 0, dest_pos = 0;
+
+  while (src_pos < src_size) {
+    auto found    = src_pos + finder(src + src_pos, src_size - src_pos);
+    auto num_copy = std::min(found + 2, src_size) - src_pos;
+
+    memcpy(dest + dest_pos, src + src_pos, num_copy);
+
+    dest_pos += num_copy;
+    src_pos  += num_copy;
+
+    if (found < src_size)
+      dest[dest_pos++] = 0x03;
+  }
+
+  return dest_pos;
+}
+
+implementation_e
+get_implementation() {
+  static auto s_implementation = detect_implementation();
+  return s_implementation;
+}
+
+bool
+is_available(implementation_e implementation) {
+  return implementation <= get_implementation();
+}
+
+size_t
+find(unsigned char const *buffer,
+     size_t size) {
+  static auto s_finder = get_finder<0x01, 0x01>(get_implementation());
+  return s_finder(buffer, size);
+}
+
+size_t
+find(implementation_e implementation,
+     unsigned char const *buffer,
+     size_t size) {
+  assert(is_available(implementation));
+  return get_finder<0x01, 0x01>(implementation)(buffer, size);
+}
+
+size_t
+remove_emulation_prevention_bytes(unsigned char const *src,
+                                  size_t src_size,
+                                  unsigned char *dest,
+                                  size_t dest_size) {
+  static auto s_finder = get_finder<0x03, 0x03>(get_implementation());
+  return remove_emulation_prevention_bytes(s_finder, src, src_size, dest, dest_size);
+}
+
+size_t
+remove_emulation_prevention_bytes(implementation_e implementation,
+                                  unsigned char const *src,
+                                  size_t src_size,
+                                  unsigned char *dest,
+                                  size_t dest_size) {
+  assert(is_available(implementation));
+  return remove_emulation_prevention_bytes(get_finder<0x03, 0x03>(implementation), src, src_size, dest, dest_size);
+}
+
+size_t
+add_emulation_prevention_bytes(unsigned char const *src,
+                               size_t src_size,
+                               unsigned char *dest) {
+  static auto s_finder = get_finder<0x00, 0x03>(get_implementation());
+  return add_emulation_prevention_bytes(s_finder, src, src_size, dest);
+}
+
+size_t
+add_emulation_prevention_bytes(implementation_e implementation,
+                               unsigned char const *src,
+                               size_t src_size,
+                               unsigned char *dest) {
+  assert(is_available(implementation));
+  return add_emulation_prevention_bytes(get_finder<0x00, 0x03>(implementation), src, src_size, dest);
+}
+
+}}
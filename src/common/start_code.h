@@ -0,0 +1,62 @@
+/*
+   mkvmerge -- utility for splicing together matroska files
+   from component media subtypes
+
+   Distributed under the GPL v2
+   see the file COPYING for details
+   or visit http://www.gnu.org/copyleft/gpl.html
+
+   definitions for the start code finder and emulation prevention byte handling
+
+   Written by Moritz Bunkus <moritz@bunkus.org>.
+*/
+
+#ifndef MTX_COMMON_START_CODE_H
+#define MTX_COMMON_START_CODE_H
+
+#include "common/common_pch.h"
+
+namespace mtx {
+  namespace start_code {
+    enum implementation_e {
+      IMPLEMENTATION_SCALAR,
+      IMPLEMENTATION_SSE2,
+      IMPLEMENTATION_AVX2,
+    };
+
+    // Returns the offset of the first occurrence of the byte sequence
+    // 00 00 01 in the buffer or 'size' if there is none. The fastest
+    // implementation supported by the CPU is selected at run time.
+    size_t find(unsigned char const *buffer, size_t size);
+
+    // The same as above but with a specific implementation. Only
+    // meant for testing and benchmarking; 'implementation' must be
+    // available.
+    size_t find(implementation_e implementation, unsigned char const *buffer, size_t size);
+
+    // Copies 'src' to 'dest' removing all emulation prevention bytes,
+    // turning 00 00 03 into 00 00. Stops once 'dest_size' bytes have
+    // been written so that e.g. only a slice header can be unescaped
+    // without looking at the whole NALU. Returns the number of bytes
+    // written to 'dest'.
+    size_t remove_emulation_prevention_bytes(unsigned char const *src, size_t src_size, unsigned char *dest, size_t dest_size);
+    size_t remove_emulation_prevention_bytes(implementation_e implementation, unsigned char const *src, size_t src_size, unsigned char *dest, size_t dest_size);
+
+    // Copies 'src' to 'dest' inserting an emulation prevention byte
+    // after each 00 00 followed by a byte <= 03. 'dest' must be able
+    // to hold max_size_with_emulation_prevention_bytes(src_size)
+    // bytes. Returns the number of bytes written to 'dest'.
+    size_t add_emulation_prevention_bytes(unsigned char const *src, size_t src_size, unsigned char *dest);
+    size_t add_emulation_prevention_bytes(implementation_e implementation, unsigned char const *src, size_t src_size, unsigned char *dest);
+
+    inline size_t
+    max_size_with_emulation_prevention_bytes(size_t size) {
+      return size + size / 2 + 1;
+    }
+
+    bool is_available(implementation_e implementation);
+    implementation_e get_implementation();
+  }
+}
+
+#endif  // MTX_COMMON_START_CODE_H
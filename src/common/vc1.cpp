@@ -16,6 +16,7 @@
 
 #include "common/bit_cursor.h"
 #include "common/endian.h"
+#include "common/start_code.h"
 #include "common/strings/formatting.h"
 #include "common/vc1.h"
 
@@ -299,52 +300,44 @@ vc1::es_parser_c::~es_parser_c() {
 void
 vc1::es_parser_c::add_bytes(unsigned char *buffer,
                             int size) {
-  memory_slice_cursor_c cursor;
-
-  int previous_pos            = -1;
-  int64_t previous_stream_pos = m_stream_pos;
-
-  if (m_unparsed_buffer && (0 != m_unparsed_buffer->get_size()))
-    cursor.add_slice(m_unparsed_buffer);
-  cursor.add_slice(buffer, size);
-
-  if (3 <= cursor.get_remaining_size()) {
-    uint32_t marker = (1 << 24) | ((unsigned int)cursor.get_char() << 16) | ((unsigned int)cursor.get_char() << 8) | (unsigned int)cursor.get_char();
-
-    while (1) {
-      if (vc1::is_marker(marker)) {
-        if (-1 != previous_pos) {
-          int new_size = cursor.get_position() - 4 - previous_pos;
-
-          memory_cptr packet(new memory_c(safemalloc(new_size), new_size, true));
-          cursor.copy(packet->get_buffer(), previous_pos, new_size);
-
-          handle_packet(packet);
-        }
-
-        previous_pos = cursor.get_position() - 4;
-        m_stream_pos = previous_stream_pos + previous_pos;
-      }
+  // The unparsed buffer starts either with the marker of the packet
+  // that hasn't been terminated yet or with the data preceding the
+  // first marker. A marker is only recognized once its fourth byte is
+  // available; therefore the last three bytes of the old data have to
+  // be searched again.
+  auto old_size = m_unparsed_buffer ? m_unparsed_buffer->get_size() : 0u;
+
+  if (!m_unparsed_buffer)
+    m_unparsed_buffer = memory_c::clone(buffer, size);
+  else
+    m_unparsed_buffer->add(buffer, size);
+
+  auto data       = m_unparsed_buffer->get_buffer();
+  auto data_size  = m_unparsed_buffer->get_size();
+  auto stream_pos = m_stream_pos;
+  auto packet_pos = (4 <= old_size) && vc1::is_marker(get_uint32_be(data)) ? 0 : -1;
+  auto pos        = std::max<size_t>(3, old_size) - 3;
+
+  while (true) {
+    auto found = pos + mtx::start_code::find(data + pos, data_size - pos);
+    if ((found + 3) >= data_size)
+      break;
 
-      if (!cursor.char_available())
-        break;
+    if (-1 != packet_pos)
+      handle_packet(memory_c::clone(data + packet_pos, found - packet_pos));
 
-      marker <<= 8;
-      marker  |= (unsigned int)cursor.get_char();
-    }
+    packet_pos   = found;
+    m_stream_pos = stream_pos + packet_pos;
+    pos          = found + 3;
   }
 
-  if (-1 == previous_pos)
-    previous_pos = 0;
-
-  int new_size = cursor.get_size() - previous_pos;
-  if (0 != new_size) {
-    memory_cptr new_unparsed_buffer = memory_c::alloc(new_size);
-    cursor.copy(new_unparsed_buffer->get_buffer(), previous_pos, new_size);
-    m_unparsed_buffer = new_unparsed_buffer;
-
-  } else
+  if (!data_size)
     m_unparsed_buffer.reset();
+
+  else if (0 < packet_pos) {
+    memmove(data, data + packet_pos, data_size - packet_pos);
+    m_unparsed_buffer->set_size(data_size - packet_pos);
+  }
 }
 
 void
@@ -59,6 +59,7 @@ extract_cli_parser_c::init_parser() {
 
   add_section_header(YT("Global options"));
   OPT("f|parse-fully",    set_parse_fully,      YT("Parse the whole file instead of relying on the index."));
+  OPT("use-index-file",   set_use_index_file,   YT("Keep the positions of the file's elements in an index file next to it and use them instead of analyzing the file as long as it hasn't been changed."));
 
   add_common_options();
 
@@ -69,6 +70,10 @@ extract_cli_parser_c::init_parser() {
   OPT("blockadd=level", set_blockadd, YT("Keep only the BlockAdditions up to this level (default: keep all levels)"));
   OPT("raw",            set_raw,      YT("Extract the data to a raw file."));
   OPT("fullraw",        set_fullraw,  YT("Extract the data to a raw file including the CodecPrivate as a header."));
+  OPT("start=timecode", set_start,    YT("Only extract blocks whose timecode is equal to or bigger than this one. Each track starts with its first key frame from there on."));
+  OPT("stop=timecode",  set_stop,     YT("Only extract blocks whose timecode is smaller than this one."));
+  OPT("parallel",       set_parallel, YT("Decode and write the tracks in background threads, one per output file."));
+  OPT("verify-crc32",   set_verify_crc32, YT("Verify the CRC-32 elements of the clusters and other level 1 elements read."));
   add_informational_option("TID:out", YT("Write track with the ID TID to the file 'out'."));
 
   add_section_header(YT("Example"));
@@ -145,6 +150,11 @@ extract_cli_parser_c::set_parse_fully() {
   m_options.m_parse_mode = kax_analyzer_c::parse_mode_full;
 }
 
+void
+extract_cli_parser_c::set_use_index_file() {
+  m_options.m_use_index_file = true;
+}
+
 void
 extract_cli_parser_c::set_charset() {
   assert_mode(options_c::em_tracks);
@@ -176,6 +186,40 @@ extract_cli_parser_c::set_fullraw() {
   m_target_mode = track_spec_t::tm_full_raw;
 }
 
+void
+extract_cli_parser_c::set_start() {
+  assert_mode(options_c::em_tracks);
+
+  int64_t timecode = 0;
+  if (!parse_timecode(m_next_arg, timecode))
+    mxerror(boost::format(Y("Invalid timecode in argument '%1%': %2%\n")) % m_next_arg % timecode_parser_error);
+
+  m_options.m_start = timecode_c::ns(timecode);
+}
+
+void
+extract_cli_parser_c::set_stop() {
+  assert_mode(options_c::em_tracks);
+
+  int64_t timecode = 0;
+  if (!parse_timecode(m_next_arg, timecode))
+    mxerror(boost::format(Y("Invalid timecode in argument '%1%': %2%\n")) % m_next_arg % timecode_parser_error);
+
+  m_options.m_stop = timecode_c::ns(timecode);
+}
+
+void
+extract_cli_parser_c::set_parallel() {
+  assert_mode(options_c::em_tracks);
+  m_options.m_use_workers = true;
+}
+
+void
+extract_cli_parser_c::set_verify_crc32() {
+  assert_mode(options_c::em_tracks);
+  m_options.m_verify_crc32 = true;
+}
+
 void
 extract_cli_parser_c::set_simple() {
   assert_mode(options_c::em_chapters);
@@ -275,5 +319,8 @@ extract_cli_parser_c::run() {
 
   parse_args();
 
+  if (m_options.m_start.valid() && m_options.m_stop.valid() && (m_options.m_start >= m_options.m_stop))
+    mxerror(Y("The start timecode must be smaller than the stop timecode.\n"));
+
   return m_options;
 }
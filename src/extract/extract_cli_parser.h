@@ -43,11 +43,16 @@ protected:
   void assert_mode(options_c::extraction_mode_e mode);
 
   void set_parse_fully();
+  void set_use_index_file();
   void set_charset();
   void set_cuesheet();
   void set_blockadd();
   void set_raw();
   void set_fullraw();
+  void set_start();
+  void set_stop();
+  void set_parallel();
+  void set_verify_crc32();
   void set_simple();
   void set_mode_or_extraction_spec();
   void set_extraction_mode();
@@ -39,6 +39,8 @@ enum operation_mode_e {
   MODE_TIMECODES_V2,
 };
 
+static bool s_use_index_file = false;
+
 kax_analyzer_cptr
 open_and_analyze(std::string const &file_name,
                  kax_analyzer_c::parse_mode_e parse_mode,
@@ -46,7 +48,9 @@ open_and_analyze(std::string const &file_name,
   // open input file
   try {
     auto analyzer = std::make_shared<kax_analyzer_c>(file_name);
-    auto ok       = analyzer->process(parse_mode, MODE_READ, exit_on_error);
+
+    analyzer->set_use_index_file(s_use_index_file);
+    auto ok = analyzer->process(parse_mode, MODE_READ, exit_on_error);
 
     return ok ? analyzer : kax_analyzer_cptr{};
 
@@ -107,9 +111,10 @@ main(int argc,
   setup(argv);
 
   options_c options = extract_cli_parser_c(command_line_utf8(argc, argv)).run();
+  s_use_index_file  = options.m_use_index_file;
 
   if (options_c::em_tracks == options.m_extraction_mode) {
-    extract_tracks(options.m_file_name, options.m_tracks, options.m_parse_mode);
+    extract_tracks(options.m_file_name, options.m_tracks, options.m_parse_mode, options.m_start, options.m_stop, options.m_use_workers, options.m_verify_crc32);
 
     if (0 == verbose)
       mxinfo(Y("Progress: 100%\n"));
@@ -17,6 +17,9 @@
 
 options_c::options_c()
   : m_simple_chapter_format(false)
+  , m_use_workers(false)
+  , m_use_index_file(false)
+  , m_verify_crc32(false)
   , m_parse_mode(kax_analyzer_c::parse_mode_fast)
   , m_extraction_mode(options_c::em_unknown)
 {
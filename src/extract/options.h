@@ -13,6 +13,8 @@
 
 #include "common/common_pch.h"
 
+#include "common/timecode.h"
+
 class options_c {
 public:
   enum extraction_mode_e {
@@ -27,9 +29,10 @@ public:
   };
 
   std::string m_file_name;
-  bool m_simple_chapter_format;
+  bool m_simple_chapter_format, m_use_workers, m_use_index_file, m_verify_crc32;
   kax_analyzer_c::parse_mode_e m_parse_mode;
   extraction_mode_e m_extraction_mode;
+  timecode_c m_start, m_stop;
 
   std::vector<track_spec_t> m_tracks;
 
@@ -13,6 +13,8 @@
 #include "common/common_pch.h"
 
 #include <cassert>
+#include <unordered_map>
+#include <unordered_set>
 
 #include <ebml/EbmlHead.h>
 #include <ebml/EbmlSubHead.h>
@@ -24,6 +26,7 @@
 #include <matroska/KaxBlockData.h>
 #include <matroska/KaxCluster.h>
 #include <matroska/KaxClusterData.h>
+#include <matroska/KaxCues.h>
 #include <matroska/KaxInfo.h>
 #include <matroska/KaxInfoData.h>
 #include <matroska/KaxSegment.h>
@@ -38,10 +41,16 @@
 #include "common/mm_write_buffer_io.h"
 #include "extract/mkvextract.h"
 #include "extract/xtr_base.h"
+#include "extract/xtr_worker.h"
 
 using namespace libmatroska;
 
 static std::vector<xtr_base_c *> extractors;
+static timecode_c s_start, s_stop;
+static std::unordered_map<xtr_base_c *, bool> s_start_reached;
+static bool s_use_workers = false;
+static std::vector<xtr_worker_cptr> s_workers;
+static std::unordered_map<xtr_base_c *, xtr_worker_c *> s_worker_by_extractor;
 
 // ------------------------------------------------------------------------
 
@@ -108,6 +117,15 @@ create_extractors(KaxTracks &kax_tracks,
     // Let the extractor create the file.
     extractor->create_file(master, track);
 
+    // Extractors writing to the same file share a worker.
+    if (s_use_workers) {
+      if (!master) {
+        s_workers.push_back(std::make_shared<xtr_worker_c>());
+        s_workers.back()->start();
+      }
+      s_worker_by_extractor[extractor] = master ? s_worker_by_extractor[master] : s_workers.back().get();
+    }
+
     // We're done.
     extractors.push_back(extractor);
 
@@ -120,6 +138,74 @@ create_extractors(KaxTracks &kax_tracks,
     extractors[i]->headers_done();
 }
 
+// Extractors writing the frames unchanged have them copied from the
+// source file directly. Their blocks are read without the payload,
+// and the blocks of tracks not being extracted are skipped entirely.
+static void
+setup_block_reading(KaxTracks &kax_tracks,
+                    kax_file_c &file,
+                    mm_io_c *in) {
+  auto skipped_track_numbers      = std::unordered_set<uint64_t>{};
+  auto headers_only_track_numbers = std::unordered_set<uint64_t>{};
+  auto num_extractors_per_file    = std::unordered_map<std::string, int>{};
+  auto extracted_track_numbers    = std::unordered_set<uint64_t>{};
+
+  for (auto extractor : extractors) {
+    ++num_extractors_per_file[extractor->m_file_name];
+    extracted_track_numbers.insert(extractor->m_track_num);
+  }
+
+  // The frames would have to be copied in the workers' order, and
+  // frames from other tracks written to the same file would end up
+  // in the wrong place.
+  if (!s_use_workers)
+    for (auto extractor : extractors)
+      if ((1 == num_extractors_per_file[extractor->m_file_name]) && extractor->enable_direct_copying(in))
+        headers_only_track_numbers.insert(extractor->m_track_num);
+
+  for (auto i = 0u; i < kax_tracks.ListSize(); ++i) {
+    if (!Is<KaxTrackEntry>(kax_tracks[i]))
+      continue;
+
+    auto track_number = kt_get_number(*static_cast<KaxTrackEntry *>(kax_tracks[i]));
+    if (!extracted_track_numbers.count(track_number))
+      skipped_track_numbers.insert(track_number);
+  }
+
+  file.set_skipped_track_numbers(skipped_track_numbers);
+  file.set_headers_only_track_numbers(headers_only_track_numbers);
+}
+
+// Determines whether or not a frame lies within the range requested
+// with '--start' and '--stop'. The extraction of each track starts
+// with its first key frame at or after the start timecode.
+static bool
+is_frame_in_range(xtr_base_c *extractor,
+                  int64_t timecode,
+                  bool keyframe) {
+  if (s_stop.valid() && (timecode >= s_stop.to_ns()))
+    return false;
+
+  if (!s_start.valid() || s_start_reached[extractor])
+    return true;
+
+  if ((timecode < s_start.to_ns()) || !keyframe)
+    return false;
+
+  s_start_reached[extractor] = true;
+
+  return true;
+}
+
+static void
+handle_frame(xtr_base_c *extractor,
+             xtr_frame_t &f) {
+  if (s_use_workers)
+    s_worker_by_extractor[extractor]->add_frame(extractor, f);
+  else
+    extractor->decode_and_handle_frame(f);
+}
+
 static int64_t
 handle_blockgroup(KaxBlockGroup &blockgroup,
                   KaxCluster &cluster,
@@ -168,7 +254,10 @@ handle_blockgroup(KaxBlockGroup &blockgroup,
   KaxCodecState *kcstate = FindChild<KaxCodecState>(&blockgroup);
   if (kcstate) {
     memory_cptr codec_state(new memory_c(kcstate->GetBuffer(), kcstate->GetSize(), false));
-    extractor->handle_codec_state(codec_state);
+    if (s_use_workers)
+      s_worker_by_extractor[extractor]->add_codec_state(extractor, codec_state);
+    else
+      extractor->handle_codec_state(codec_state);
   }
 
   for (i = 0; i < block->NumberFrames(); i++) {
@@ -188,12 +277,20 @@ handle_blockgroup(KaxBlockGroup &blockgroup,
     if (kdiscard_padding)
       discard_padding = timecode_c::ns(kdiscard_padding->GetValue());
 
+    max_timecode = std::max(max_timecode, this_timecode);
+
+    if (!is_frame_in_range(extractor, this_timecode, !bref && !fref))
+      continue;
+
+    if (extractor->is_copying_directly()) {
+      extractor->copy_frame(block->GetDataPosition(i), block->GetFrameSize(i));
+      continue;
+    }
+
     auto &data = block->GetBuffer(i);
     auto frame = std::make_shared<memory_c>(data.Buffer(), data.Size(), false);
     auto f     = xtr_frame_t{frame, kadditions, this_timecode, this_duration, bref, fref, false, false, true, discard_padding};
-    extractor->decode_and_handle_frame(f);
-
-    max_timecode = std::max(max_timecode, this_timecode);
+    handle_frame(extractor, f);
   }
 
   return max_timecode;
@@ -233,12 +330,20 @@ handle_simpleblock(KaxSimpleBlock &simpleblock,
       this_duration = duration / simpleblock.NumberFrames();
     }
 
+    max_timecode = std::max(max_timecode, this_timecode);
+
+    if (!is_frame_in_range(extractor, this_timecode, simpleblock.IsKeyframe()))
+      continue;
+
+    if (extractor->is_copying_directly()) {
+      extractor->copy_frame(simpleblock.GetDataPosition(i), simpleblock.GetFrameSize(i));
+      continue;
+    }
+
     auto &data = simpleblock.GetBuffer(i);
     auto frame = std::make_shared<memory_c>(data.Buffer(), data.Size(), false);
     auto f     = xtr_frame_t{frame, nullptr, this_timecode, this_duration, -1, -1, simpleblock.IsKeyframe(), simpleblock.IsDiscardable(), false, timecode_c::ns(0)};
-    extractor->decode_and_handle_frame(f);
-
-    max_timecode = std::max(max_timecode, this_timecode);
+    handle_frame(extractor, f);
   }
 
   return max_timecode;
@@ -248,6 +353,12 @@ static void
 close_extractors() {
   size_t i;
 
+  for (auto &worker : s_workers)
+    worker->finish();
+
+  s_workers.clear();
+  s_worker_by_extractor.clear();
+
   for (i = 0; i < extractors.size(); i++)
     extractors[i]->finish_track();
 
@@ -262,6 +373,7 @@ close_extractors() {
   }
 
   extractors.clear();
+  s_start_reached.clear();
 }
 
 static void
@@ -329,6 +441,50 @@ find_and_verify_track_uids(KaxTracks &tracks,
       mxerror(boost::format(Y("No track with the ID %1% was found in the source file.\n")) % tspec.tid);
 }
 
+static void
+collect_chapters(KaxChapters &chapters,
+                 KaxChapters &all_chapters) {
+  while (chapters.ListSize() > 0) {
+    if (Is<KaxEditionEntry>(chapters[0])) {
+      KaxEditionEntry &entry = *static_cast<KaxEditionEntry *>(chapters[0]);
+      while (entry.ListSize() > 0) {
+        if (Is<KaxChapterAtom>(entry[0]))
+          all_chapters.PushElement(*entry[0]);
+        entry.Remove(0);
+      }
+    }
+    chapters.Remove(0);
+  }
+}
+
+static void
+collect_tags(KaxTags &tags,
+             KaxTags &all_tags) {
+  while (tags.ListSize() > 0) {
+    all_tags.PushElement(*tags[0]);
+    tags.Remove(0);
+  }
+}
+
+static bool
+seek_to_start(kax_analyzer_c &analyzer,
+              mm_io_c &in,
+              uint64_t tc_scale) {
+  auto cues_m = analyzer.read_all(EBML_INFO(KaxCues));
+  auto cues   = dynamic_cast<KaxCues *>(cues_m.get());
+
+  if (!cues)
+    return false;
+
+  auto position = find_cluster_position_in_cues(*cues, s_start.to_ns(), tc_scale);
+  if (-1 == position)
+    return false;
+
+  in.setFilePointer(analyzer.get_segment_data_start_pos() + position);
+
+  return true;
+}
+
 static void
 handle_segment_info(EbmlMaster *info,
                     kax_file_c *file,
@@ -344,16 +500,26 @@ handle_segment_info(EbmlMaster *info,
 bool
 extract_tracks(const std::string &file_name,
                std::vector<track_spec_t> &tspecs,
-               kax_analyzer_c::parse_mode_e parse_mode) {
+               kax_analyzer_c::parse_mode_e parse_mode,
+               timecode_c const &start,
+               timecode_c const &stop,
+               bool use_workers,
+               bool verify_crc32) {
   if (tspecs.empty())
     mxerror(Y("Nothing to do.\n"));
 
+  s_start       = start;
+  s_stop        = stop;
+  s_use_workers = use_workers;
+
   // open input file
   mm_io_cptr in;
   kax_file_cptr file;
   try {
     in   = mm_file_io_c::open(file_name);
     file = kax_file_cptr(new kax_file_c(in));
+
+    in->enable_readahead(8 * 1024 * 1024);
   } catch (mtx::mm_io::exception &ex) {
     show_error(boost::format(Y("The file '%1%' could not be opened for reading: %2%.\n")) % file_name % ex);
     return false;
@@ -379,6 +545,7 @@ extract_tracks(const std::string &file_name,
       tracks_found = true;
       find_and_verify_track_uids(*tracks, tspecs);
       create_extractors(*tracks, tspecs);
+      setup_block_reading(*tracks, *file, in.get());
     }
   }
 
@@ -422,7 +589,43 @@ extract_tracks(const std::string &file_name,
     KaxChapters all_chapters;
     KaxTags all_tags;
 
+    // With a time range not all level 1 elements are read. The
+    // chapters and tags needed for the CUE sheets are taken from the
+    // analyzer then, and reading starts at the cluster the cues
+    // point to.
+    auto use_analyzer = analyzer && (start.valid() || stop.valid());
+
+    if (use_analyzer) {
+      auto chapters_m = analyzer->read_all(EBML_INFO(KaxChapters));
+      auto chapters   = dynamic_cast<KaxChapters *>(chapters_m.get());
+      if (chapters)
+        collect_chapters(*chapters, all_chapters);
+
+      auto tags_m = analyzer->read_all(EBML_INFO(KaxTags));
+      auto tags   = dynamic_cast<KaxTags *>(tags_m.get());
+      if (tags)
+        collect_tags(*tags, all_tags);
+
+      if (start.valid() && tracks_found && !seek_to_start(*analyzer, *in, tc_scale))
+        mxinfo(Y("No cues were found for the start timecode. The file will be read from the start.\n"));
+    }
+
+    auto num_crc32_checked = 0u, num_crc32_errors = 0u;
+
     while ((l1 = file->read_next_level1_element())) {
+      auto stop_reached = false;
+
+      if (verify_crc32) {
+        auto status = file->verify_crc32(l1);
+        if (kax_file_c::crc32_missing != status)
+          ++num_crc32_checked;
+
+        if (kax_file_c::crc32_invalid == status) {
+          ++num_crc32_errors;
+          mxwarn(boost::format(Y("The CRC-32 of the element at %1% does not match its content.\n")) % l1->GetElementPosition());
+        }
+      }
+
       if (Is<KaxInfo>(l1) && !segment_info_found) {
         segment_info_found = true;
         handle_segment_info(static_cast<EbmlMaster *>(l1), file.get(), tc_scale);
@@ -431,6 +634,7 @@ extract_tracks(const std::string &file_name,
         tracks_found = true;
         find_and_verify_track_uids(*dynamic_cast<KaxTracks *>(l1), tspecs);
         create_extractors(*dynamic_cast<KaxTracks *>(l1), tspecs);
+        setup_block_reading(*dynamic_cast<KaxTracks *>(l1), *file, in.get());
 
       } else if (Is<KaxCluster>(l1)) {
         show_element(l1, 1, Y("Cluster"));
@@ -469,38 +673,29 @@ extract_tracks(const std::string &file_name,
         if (-1 != max_timecode)
           file->set_last_timecode(max_timecode);
 
-      } else if (Is<KaxChapters>(l1)) {
-        KaxChapters &chapters = *static_cast<KaxChapters *>(l1);
-
-        while (chapters.ListSize() > 0) {
-          if (Is<KaxEditionEntry>(chapters[0])) {
-            KaxEditionEntry &entry = *static_cast<KaxEditionEntry *>(chapters[0]);
-            while (entry.ListSize() > 0) {
-              if (Is<KaxChapterAtom>(entry[0]))
-                all_chapters.PushElement(*entry[0]);
-              entry.Remove(0);
-            }
-          }
-          chapters.Remove(0);
-        }
-
-      } else if (Is<KaxTags>(l1)) {
-        KaxTags &tags = *static_cast<KaxTags *>(l1);
+        // Clusters are stored in ascending order. Blocks in later
+        // clusters lie behind the stop timecode.
+        stop_reached = stop.valid() && (cluster->GlobalTimecode() >= static_cast<uint64_t>(stop.to_ns()));
 
-        while (tags.ListSize() > 0) {
-          all_tags.PushElement(*tags[0]);
-          tags.Remove(0);
-        }
+      } else if (Is<KaxChapters>(l1) && !use_analyzer)
+        collect_chapters(*static_cast<KaxChapters *>(l1), all_chapters);
 
-      }
+      else if (Is<KaxTags>(l1) && !use_analyzer)
+        collect_tags(*static_cast<KaxTags *>(l1), all_tags);
 
       delete l1;
 
+      if (stop_reached)
+        break;
+
     } // while (l1)
 
     delete l0;
     delete es;
 
+    if (verify_crc32)
+      mxinfo(boost::format(Y("CRC-32 verification: %1% element(s) checked, %2% mismatch(es) found.\n")) % num_crc32_checked % num_crc32_errors);
+
     write_all_cuesheets(all_chapters, all_tags, tspecs);
 
     // Now just close the files and go to sleep. Mummy will sing you a
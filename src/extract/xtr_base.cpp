@@ -12,6 +12,8 @@
 
 #include "common/common_pch.h"
 
+#include <typeinfo>
+
 #include <matroska/KaxTracks.h>
 #include <matroska/KaxTrackEntryData.h>
 #include <matroska/KaxTrackAudio.h>
@@ -53,6 +55,9 @@ xtr_base_c::xtr_base_c(const std::string &codec_id,
   , m_default_duration(0)
   , m_bytes_written(0)
   , m_content_decoder_initialized(false)
+  , m_copy_source{}
+  , m_pending_copy_position{}
+  , m_pending_copy_size{}
   , m_debug{}
 {
 }
@@ -92,6 +97,7 @@ xtr_base_c::handle_frame(xtr_frame_t &f) {
 
 void
 xtr_base_c::finish_track() {
+  flush_copied_frames();
 }
 
 void
@@ -121,6 +127,60 @@ xtr_base_c::init_content_decoder(KaxTrackEntry &track) {
   m_content_decoder_initialized = true;
 }
 
+bool
+xtr_base_c::enable_direct_copying(mm_io_c *source) {
+#if defined(SYS_WINDOWS)
+  (void)source;
+  return false;
+
+#else
+  // Derived classes modify the frames or add their own headers.
+  auto &type = typeid(*this);
+  if ((type != typeid(xtr_base_c)) && (type != typeid(xtr_fullraw_c)))
+    return false;
+
+  if (m_master || m_content_decoder.has_encodings() || !dynamic_cast<mm_file_io_c *>(source))
+    return false;
+
+  auto proxy = dynamic_cast<mm_proxy_io_c *>(m_out.get());
+  if (!proxy || !dynamic_cast<mm_file_io_c *>(proxy->get_proxied()))
+    return false;
+
+  m_copy_source = source;
+
+  return true;
+#endif
+}
+
+// Contiguous frames are collected and copied in one go.
+void
+xtr_base_c::copy_frame(uint64_t position,
+                       uint64_t size) {
+  if (m_pending_copy_size && ((m_pending_copy_position + m_pending_copy_size) != position))
+    flush_copied_frames();
+
+  if (!m_pending_copy_size)
+    m_pending_copy_position = position;
+
+  m_pending_copy_size += size;
+  m_bytes_written     += size;
+}
+
+void
+xtr_base_c::flush_copied_frames() {
+#if !defined(SYS_WINDOWS)
+  if (!m_pending_copy_size)
+    return;
+
+  m_out->flush();
+
+  auto out = static_cast<mm_file_io_c *>(static_cast<mm_proxy_io_c *>(m_out.get())->get_proxied());
+  out->copy_from(*static_cast<mm_file_io_c *>(m_copy_source), m_pending_copy_position, m_pending_copy_size);
+
+  m_pending_copy_size = 0;
+#endif
+}
+
 xtr_base_c *
 xtr_base_c::create_extractor(const std::string &new_codec_id,
                              int64_t new_tid,
@@ -212,6 +272,7 @@ xtr_fullraw_c::create_file(xtr_base_c *master,
 
 void
 xtr_fullraw_c::handle_codec_state(memory_cptr &codec_state) {
+  flush_copied_frames();
   m_content_decoder.reverse(codec_state, CONTENT_ENCODING_SCOPE_CODECPRIVATE);
   m_out->write(codec_state);
 }
@@ -45,6 +45,9 @@ public:
   content_decoder_c m_content_decoder;
   bool m_content_decoder_initialized;
 
+  mm_io_c *m_copy_source;
+  uint64_t m_pending_copy_position, m_pending_copy_size;
+
   bool m_debug;
 
 public:
@@ -69,6 +72,16 @@ public:
   virtual void init_content_decoder(KaxTrackEntry &track);
   virtual memory_cptr decode_codec_private(KaxCodecPrivate *priv);
 
+  // Extractors that write the frames exactly as they're stored in the
+  // source file can have them copied from the source file directly.
+  // Returns false if that isn't possible for this extractor.
+  virtual bool enable_direct_copying(mm_io_c *source);
+  bool is_copying_directly() const {
+    return !!m_copy_source;
+  }
+  void copy_frame(uint64_t position, uint64_t size);
+  void flush_copied_frames();
+
   static xtr_base_c *create_extractor(const std::string &new_codec_id, int64_t new_tid, track_spec_t &tspec);
 };
 
@@ -0,0 +1,169 @@
+/*
+   mkvextract -- extract tracks from Matroska files into other files
+
+   Distributed under the GPL v2
+   see the file COPYING for details
+   or visit http://www.gnu.org/copyleft/gpl.html
+
+   decoding and writing frames in background threads
+
+   Written by Moritz Bunkus <moritz@bunkus.org>.
+*/
+
+#include "common/common_pch.h"
+
+#include "common/ebml.h"
+#include "extract/xtr_worker.h"
+
+xtr_worker_c::xtr_worker_c(size_t max_queued_items)
+  : m_max_queued_items{std::max<size_t>(max_queued_items, 1)}
+  , m_started{}
+  , m_finish_requested{}
+  , m_debug{"xtr_worker|extract_threads"}
+{
+}
+
+xtr_worker_c::~xtr_worker_c() {
+  if (!m_thread.joinable())
+    return;
+
+  // Errors raised in this thread are reported by the main
+  // thread. This only happens if code running here terminates the
+  // process directly.
+  if (std::this_thread::get_id() == m_thread.get_id()) {
+    m_thread.detach();
+    return;
+  }
+
+  // Only reached if finish() hasn't been called, e.g. when the
+  // process exits due to an error. Queued items are dropped.
+  {
+    std::lock_guard<std::mutex> lock{m_mutex};
+    m_items.clear();
+    m_finish_requested = true;
+  }
+
+  m_worker_cond.notify_all();
+  m_thread.join();
+}
+
+void
+xtr_worker_c::start() {
+  if (m_started)
+    return;
+
+  m_started = true;
+  m_thread  = std::thread{[this]() { run(); }};
+}
+
+void
+xtr_worker_c::add_frame(xtr_base_c *extractor,
+                        xtr_frame_t const &f) {
+  auto item               = item_t{};
+  item.m_extractor        = extractor;
+  item.m_frame            = f.frame->clone();
+  item.m_additions        = f.additions ? clone(f.additions) : std::shared_ptr<KaxBlockAdditions>{};
+  item.m_timecode         = f.timecode;
+  item.m_duration         = f.duration;
+  item.m_bref             = f.bref;
+  item.m_fref             = f.fref;
+  item.m_keyframe         = f.keyframe;
+  item.m_discardable      = f.discardable;
+  item.m_references_valid = f.references_valid;
+  item.m_discard_duration = f.discard_duration;
+
+  add_item(std::move(item));
+}
+
+void
+xtr_worker_c::add_codec_state(xtr_base_c *extractor,
+                              memory_cptr const &codec_state) {
+  auto item          = item_t{};
+  item.m_extractor   = extractor;
+  item.m_codec_state = codec_state->clone();
+
+  add_item(std::move(item));
+}
+
+void
+xtr_worker_c::add_item(item_t &&item) {
+  std::unique_lock<std::mutex> lock{m_mutex};
+
+  while (!m_exception && (m_items.size() >= m_max_queued_items))
+    m_producer_cond.wait(lock);
+
+  if (m_exception) {
+    auto exception = m_exception;
+    lock.unlock();
+
+    rethrow_thread_exception(exception);
+  }
+
+  m_items.push_back(std::move(item));
+  m_worker_cond.notify_one();
+}
+
+void
+xtr_worker_c::finish() {
+  if (m_thread.joinable()) {
+    {
+      std::lock_guard<std::mutex> lock{m_mutex};
+      m_finish_requested = true;
+    }
+
+    m_worker_cond.notify_all();
+    m_thread.join();
+  }
+
+  if (m_exception)
+    rethrow_thread_exception(m_exception);
+}
+
+void
+xtr_worker_c::run() {
+  // Errors are reported by the main thread in add_item() or finish().
+  throw_on_mxerror_c throw_on_mxerror;
+
+  std::unique_lock<std::mutex> lock{m_mutex};
+
+  while (true) {
+    if (m_items.empty()) {
+      if (m_finish_requested)
+        break;
+
+      m_worker_cond.wait(lock);
+      continue;
+    }
+
+    auto item = std::move(m_items.front());
+    m_items.pop_front();
+    m_producer_cond.notify_one();
+
+    lock.unlock();
+
+    try {
+      process(item);
+
+    } catch (...) {
+      lock.lock();
+      m_exception = std::current_exception();
+      m_producer_cond.notify_all();
+      break;
+    }
+
+    lock.lock();
+  }
+}
+
+void
+xtr_worker_c::process(item_t &item) {
+  if (item.m_codec_state) {
+    mxdebug_if(m_debug, boost::format("xtr_worker: track %1%: codec state of %2% bytes\n") % item.m_extractor->m_tid % item.m_codec_state->get_size());
+    item.m_extractor->handle_codec_state(item.m_codec_state);
+    return;
+  }
+
+  auto f = xtr_frame_t{item.m_frame, item.m_additions.get(), item.m_timecode, item.m_duration, item.m_bref, item.m_fref,
+                       item.m_keyframe, item.m_discardable, item.m_references_valid, item.m_discard_duration};
+  item.m_extractor->decode_and_handle_frame(f);
+}
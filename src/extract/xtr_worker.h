@@ -0,0 +1,77 @@
+/*
+   mkvextract -- extract tracks from Matroska files into other files
+
+   Distributed under the GPL v2
+   see the file COPYING for details
+   or visit http://www.gnu.org/copyleft/gpl.html
+
+   decoding and writing frames in background threads
+
+   Written by Moritz Bunkus <moritz@bunkus.org>.
+*/
+
+#ifndef MTX_XTR_WORKER_H
+#define MTX_XTR_WORKER_H
+
+#include "common/common_pch.h"
+
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <thread>
+
+#include "extract/xtr_base.h"
+
+class xtr_worker_c;
+typedef std::shared_ptr<xtr_worker_c> xtr_worker_cptr;
+
+// A worker runs decode_and_handle_frame() and handle_codec_state()
+// for the extractors of one output file in a background thread. The
+// frames are handed over via a bounded queue. Extractors writing to
+// the same file (masters and their slaves) must share one worker as
+// the order of their frames matters.
+class xtr_worker_c {
+protected:
+  struct item_t {
+    xtr_base_c *m_extractor;
+    memory_cptr m_frame, m_codec_state;
+    std::shared_ptr<KaxBlockAdditions> m_additions;
+    int64_t m_timecode, m_duration, m_bref, m_fref;
+    bool m_keyframe, m_discardable, m_references_valid;
+    timecode_c m_discard_duration;
+  };
+
+  std::deque<item_t> m_items;
+  size_t m_max_queued_items;
+
+  std::thread m_thread;
+  std::mutex m_mutex;
+  std::condition_variable m_worker_cond, m_producer_cond;
+  bool m_started, m_finish_requested;
+  std::exception_ptr m_exception;
+
+  debugging_option_c m_debug;
+
+public:
+  xtr_worker_c(size_t max_queued_items = 256);
+  ~xtr_worker_c();
+
+  void start();
+
+  // The frame's data and block additions are copied as they usually
+  // belong to the block currently being processed.
+  void add_frame(xtr_base_c *extractor, xtr_frame_t const &f);
+  void add_codec_state(xtr_base_c *extractor, memory_cptr const &codec_state);
+
+  // Waits until all queued items have been processed and stops the
+  // thread. Exceptions that occurred in the thread are re-thrown, and
+  // errors raised via mxerror() are reported.
+  void finish();
+
+protected:
+  void add_item(item_t &&item);
+  void run();
+  void process(item_t &item);
+};
+
+#endif  // MTX_XTR_WORKER_H
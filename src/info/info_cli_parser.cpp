@@ -44,6 +44,7 @@ info_cli_parser_c::init_parser() {
   OPT("x|hexdump",      set_hexdump,      YT("Show the first 16 bytes of each frame as a hex dump."));
   OPT("X|full-hexdump", set_full_hexdump, YT("Show all bytes of each frame as a hex dump."));
   OPT("z|size",         set_size,         YT("Show the size of each element including its header."));
+  OPT("verify-crc32",   set_verify_crc32, YT("Verify the CRC-32 elements of clusters and other level 1 elements."));
 
   add_common_options();
 
@@ -101,6 +102,11 @@ info_cli_parser_c::set_track_info() {
     verbose = 1;
 }
 
+void
+info_cli_parser_c::set_verify_crc32() {
+  m_options.m_verify_crc32 = true;
+}
+
 void
 info_cli_parser_c::set_file_name() {
   if (!m_options.m_file_name.empty())
@@ -143,6 +143,7 @@ options_c g_options;
 static uint64_t s_tc_scale = TIMECODE_SCALE;
 std::vector<boost::format> g_common_boost_formats;
 size_t s_mkvmerge_track_id = 0;
+static unsigned int s_num_crc32_checked = 0, s_num_crc32_errors = 0;
 
 #define BF_DO(n)                             g_common_boost_formats[n]
 #define BF_ADD(s)                            g_common_boost_formats.push_back(boost::format(s))
@@ -1601,6 +1602,32 @@ display_track_info() {
   }
 }
 
+void
+verify_crc32(kax_file_c &kax_file,
+             EbmlElement *l1) {
+  auto status = kax_file.verify_crc32(l1);
+  if (kax_file_c::crc32_missing == status)
+    return;
+
+  ++s_num_crc32_checked;
+
+  if (kax_file_c::crc32_valid == status)
+    return;
+
+  ++s_num_crc32_errors;
+  show_warning(1, (boost::format(Y("(The CRC-32 of the element at %1% does not match its content.)")) % l1->GetElementPosition()).str());
+}
+
+void
+show_crc32_verification_summary() {
+  auto text = (boost::format(Y("CRC-32 verification: %1% element(s) checked, %2% mismatch(es) found.")) % s_num_crc32_checked % s_num_crc32_errors).str();
+
+  if (g_options.m_use_gui)
+    show_warning(0, text);
+  else
+    mxinfo(text + "\n");
+}
+
 bool
 process_file(const std::string &file_name) {
   int upper_lvl_el;
@@ -1611,6 +1638,8 @@ process_file(const std::string &file_name) {
   s_tracks.clear();
   s_tracks_by_number.clear();
   s_track_info.clear();
+  s_num_crc32_checked = 0;
+  s_num_crc32_errors  = 0;
 
   // open input file
   mm_io_cptr in;
@@ -1668,9 +1697,14 @@ process_file(const std::string &file_name) {
     // Prevent reporting "first timecode after resync":
     kax_file->set_timecode_scale(-1);
 
+    auto cluster_shown = false;
+
     while ((l1 = kax_file->read_next_level1_element())) {
       std::shared_ptr<EbmlElement> af_l1(l1);
 
+      if (g_options.m_verify_crc32)
+        verify_crc32(*kax_file, l1);
+
       if (Is<KaxInfo>(l1))
         handle_info(es, upper_lvl_el, l1);
 
@@ -1681,14 +1715,21 @@ process_file(const std::string &file_name) {
         handle_seek_head(es, upper_lvl_el, l1);
 
       else if (Is<KaxCluster>(l1)) {
-        show_element(l1, 1, Y("Cluster"));
-        if ((g_options.m_verbose == 0) && !g_options.m_show_summary) {
+        auto show_contents = (g_options.m_verbose != 0) || g_options.m_show_summary;
+
+        if (show_contents || !cluster_shown)
+          show_element(l1, 1, Y("Cluster"));
+        cluster_shown = true;
+
+        if (!show_contents && !g_options.m_verify_crc32) {
           delete l0;
           delete es;
 
           return true;
         }
-        handle_cluster(es, upper_lvl_el, l1, file_size);
+
+        if (show_contents)
+          handle_cluster(es, upper_lvl_el, l1, file_size);
 
       } else if (Is<KaxCues>(l1))
         handle_cues(es, upper_lvl_el, l1);
@@ -1719,6 +1760,11 @@ process_file(const std::string &file_name) {
     if (!g_options.m_use_gui && g_options.m_show_track_info)
       display_track_info();
 
+    if (g_options.m_verify_crc32) {
+      show_crc32_verification_summary();
+      return !s_num_crc32_errors;
+    }
+
     return true;
   } catch (...) {
     show_error(Y("Caught exception"));
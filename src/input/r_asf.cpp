@@ -17,8 +17,6 @@
 #include "input/r_asf.h"
 #include "merge/id_result.h"
 
-#define MAGIC_ASF_WMV 0x3026b275
-
 int
 asf_reader_c::probe_file(mm_io_c *in,
                          uint64_t size) {
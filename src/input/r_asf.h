@@ -18,6 +18,9 @@
 
 #include "common/mm_io.h"
 
+// The first four bytes of the ASF header object's GUID
+#define MAGIC_ASF_WMV 0x3026b275
+
 class asf_reader_c {
 public:
   static int probe_file(mm_io_c *in, uint64_t size);
@@ -52,6 +52,15 @@
 
 #define AVI_MAX_AUDIO_CHUNK_SIZE (10 * 1024 * 1024)
 
+// Well interleaved files are read in file order through a buffer of
+// this size instead of seeking to each stream's chunks individually.
+#define AVI_READ_BUFFER_SIZE     (8 * 1024 * 1024)
+// Reading in file order keeps the chunks of all other streams in
+// memory while a stream's next chunk hasn't been reached yet. Files
+// are only read that way if the distance between consecutive chunks
+// of each stream doesn't exceed this value.
+#define AVI_MAX_INTERLEAVING_GAP (16 * 1024 * 1024)
+
 #define GAB2_TAG                 FOURCC('G', 'A', 'B', '2')
 #define GAB2_ID_LANGUAGE         0x0000
 #define GAB2_ID_LANGUAGE_UNICODE 0x0002
@@ -96,6 +105,9 @@ avi_reader_c::avi_reader_c(const track_info_c &ti,
   , m_bytes_to_process(0)
   , m_bytes_processed(0)
   , m_video_track_ok(false)
+  , m_read_in_file_order(false)
+  , m_read_buffer_pos(0)
+  , m_debug_interleaving{"avi|avi_interleaving"}
 {
 }
 
@@ -384,6 +396,78 @@ avi_reader_c::create_packetizers() {
 
   for (i = 0; static_cast<int>(m_subtitle_demuxers.size()) > i; ++i)
     create_subs_packetizer(i);
+
+  detect_interleaving();
+}
+
+void
+avi_reader_c::detect_interleaving() {
+  // Comparing the ranges of file positions the streams are spread
+  // over isn't enough: streams stored back to back in separate
+  // regions of equal size cover ranges of equal width, too. What
+  // matters is how much data of other streams has to be read before
+  // a stream's next chunk is reached.
+  std::vector<std::pair<std::string, std::vector<int64_t> > > streams;
+
+  auto add_stream = [&streams](std::string const &name, std::vector<int64_t> &&positions) {
+    if (!positions.empty())
+      streams.emplace_back(name, std::move(positions));
+  };
+
+  if ((-1 != m_vptzr) && (1 < m_max_video_frames)) {
+    auto positions = std::vector<int64_t>{};
+    for (auto frame = 0u; frame < m_max_video_frames; ++frame)
+      if (m_avi->video_index[frame].len)
+        positions.push_back(m_avi->video_index[frame].pos);
+
+    add_stream("video", std::move(positions));
+  }
+
+  for (auto &demuxer : m_audio_demuxers) {
+    auto &track = m_avi->track[demuxer.m_aid];
+    if (!track.audio_index || (2 > track.audio_chunks))
+      continue;
+
+    auto positions = std::vector<int64_t>{};
+    for (auto chunk = 0; chunk < track.audio_chunks; ++chunk)
+      positions.push_back(track.audio_index[chunk].pos);
+
+    add_stream((boost::format("audio track %1%") % (demuxer.m_aid + 1)).str(), std::move(positions));
+  }
+
+  if (2 > streams.size()) {
+    mxdebug_if(m_debug_interleaving, boost::format("Interleaving: Not enough tracks to care about interleaving.\n"));
+    return;
+  }
+
+  auto data_start = std::numeric_limits<int64_t>::max();
+  for (auto &stream : streams) {
+    brng::sort(stream.second);
+    data_start = std::min(data_start, stream.second.front());
+  }
+
+  auto max_gap = int64_t{};
+
+  for (auto const &stream : streams) {
+    auto previous_pos = data_start;
+    auto stream_gap   = int64_t{};
+
+    for (auto pos : stream.second) {
+      stream_gap   = std::max(stream_gap, pos - previous_pos);
+      previous_pos = pos;
+    }
+
+    max_gap = std::max(max_gap, stream_gap);
+
+    mxdebug_if(m_debug_interleaving, boost::format("Interleaving: %1% first %2% last %3% largest gap %4%\n") % stream.first % stream.second.front() % stream.second.back() % stream_gap);
+  }
+
+  m_read_in_file_order = AVI_MAX_INTERLEAVING_GAP >= max_gap;
+
+  mxdebug_if(m_debug_interleaving, boost::format("Interleaving: largest gap %1% (%2%)\n") % max_gap % (m_read_in_file_order ? "ok, reading in file order" : "badly interleaved"));
+
+  if (m_read_in_file_order)
+    m_in->enable_buffering(false);
 }
 
 void
@@ -433,7 +517,7 @@ avi_reader_c::create_ssa_packetizer(int idx) {
                                  :                                                  g_cc_local_utf8;
 
   parser->set_charset_converter(cc_utf8);
-  parser->set_attachment_id_base(g_attachments.size());
+  parser->set_attachment_id_base(get_attachment_id_base());
   parser->parse();
 
   m_ti.m_private_data = memory_c::clone(parser->get_global());
@@ -731,6 +815,19 @@ avi_reader_c::read_video() {
 
   m_dropped_video_frames += dropped_frames_here;
 
+  chunk->set_size(num_read);
+  process_video_frame(chunk, timestamp, duration, key);
+
+  return m_video_frames_read >= m_max_video_frames ? flush_packetizer(m_vptzr) :  FILE_STATUS_MOREDATA;
+}
+
+void
+avi_reader_c::process_video_frame(memory_cptr const &chunk,
+                                  int64_t timestamp,
+                                  int64_t duration,
+                                  bool key) {
+  int num_read = chunk->get_size();
+
   // AVC with framed packets (without NALU start codes but with length fields)
   // or non-AVC video track?
   if (0 >= m_avc_nal_size_size)
@@ -757,8 +854,6 @@ avi_reader_c::read_video() {
   }
 
   m_bytes_processed += num_read;
-
-  return m_video_frames_read >= m_max_video_frames ? flush_packetizer(m_vptzr) :  FILE_STATUS_MOREDATA;
 }
 
 file_status_e
@@ -786,15 +881,140 @@ avi_reader_c::read_audio(avi_demuxer_t &demuxer) {
     if (0 >= size)
       continue;
 
-    PTZR(demuxer.m_ptzr)->add_avi_block_size(size);
-    PTZR(demuxer.m_ptzr)->process(new packet_t(chunk));
-
-    m_bytes_processed += size;
+    process_audio_chunk(demuxer, chunk);
 
     return AVI_get_audio_position_index(m_avi) < AVI_max_audio_chunk(m_avi) ? FILE_STATUS_MOREDATA : flush_packetizer(demuxer.m_ptzr);
   }
 }
 
+void
+avi_reader_c::process_audio_chunk(avi_demuxer_t &demuxer,
+                                  memory_cptr const &chunk) {
+  PTZR(demuxer.m_ptzr)->add_avi_block_size(chunk->get_size());
+  PTZR(demuxer.m_ptzr)->process(new packet_t(chunk));
+
+  m_bytes_processed += chunk->get_size();
+}
+
+unsigned int
+avi_reader_c::find_next_video_frame(unsigned int frame)
+  const {
+  while ((frame < m_max_video_frames) && !m_avi->video_index[frame].len)
+    ++frame;
+
+  return frame;
+}
+
+int
+avi_reader_c::find_next_audio_chunk(avi_demuxer_t &demuxer) {
+  // Skips the chunks that read_audio() ignores, too. Returns -1 if
+  // there are no more chunks.
+  AVI_set_audio_track(m_avi, demuxer.m_aid);
+
+  while (true) {
+    auto chunk = AVI_get_audio_position_index(m_avi);
+    auto size  = AVI_audio_size(m_avi, chunk);
+
+    if ((0 > chunk) || (-1 == size))
+      return -1;
+
+    if (size && (size <= AVI_MAX_AUDIO_CHUNK_SIZE))
+      return chunk;
+
+    AVI_set_audio_position_index(m_avi, chunk + 1);
+  }
+}
+
+memory_cptr
+avi_reader_c::read_chunk(int64_t pos,
+                         size_t size) {
+  auto buffer_end = m_read_buffer_pos + static_cast<int64_t>(m_read_buffer ? m_read_buffer->get_size() : 0);
+
+  if (!m_read_buffer || (pos < m_read_buffer_pos) || ((pos + static_cast<int64_t>(size)) > buffer_end)) {
+    auto buffer_size = std::max<uint64_t>(size, std::min<uint64_t>(AVI_READ_BUFFER_SIZE, m_size - std::min<uint64_t>(pos, m_size)));
+
+    m_read_buffer     = memory_c::alloc(buffer_size);
+    m_read_buffer_pos = pos;
+
+    m_in->setFilePointer(pos);
+    m_read_buffer->set_size(m_in->read(m_read_buffer->get_buffer(), buffer_size));
+
+    if (m_read_buffer->get_size() < size)
+      return memory_cptr{};
+  }
+
+  return memory_c::clone(m_read_buffer->get_buffer() + (pos - m_read_buffer_pos), size);
+}
+
+file_status_e
+avi_reader_c::read_in_file_order(generic_packetizer_c *requested_ptzr) {
+  // The chunk located first in the file among the next chunks of all
+  // streams is read and handed to its packetizer no matter which
+  // packetizer has requested data. Each stream's chunks are still
+  // processed in the order of its index.
+  auto video_frame      = -1 != m_vptzr ? find_next_video_frame(m_video_frames_read) : m_max_video_frames;
+  auto next_pos         = std::numeric_limits<int64_t>::max();
+  auto next_audio_chunk = -1;
+  avi_demuxer_t *next_audio_demuxer = nullptr;
+
+  if ((-1 != m_vptzr) && (PTZR(m_vptzr) == requested_ptzr) && (video_frame >= m_max_video_frames))
+    return flush_packetizer(m_vptzr);
+
+  if (video_frame < m_max_video_frames)
+    next_pos = m_avi->video_index[video_frame].pos;
+
+  for (auto &demuxer : m_audio_demuxers) {
+    if (-1 == demuxer.m_ptzr)
+      continue;
+
+    auto chunk = find_next_audio_chunk(demuxer);
+
+    if ((-1 == chunk) && (PTZR(demuxer.m_ptzr) == requested_ptzr))
+      return flush_packetizer(demuxer.m_ptzr);
+
+    if ((-1 != chunk) && (m_avi->track[demuxer.m_aid].audio_index[chunk].pos < next_pos)) {
+      next_pos           = m_avi->track[demuxer.m_aid].audio_index[chunk].pos;
+      next_audio_chunk   = chunk;
+      next_audio_demuxer = &demuxer;
+    }
+  }
+
+  if (std::numeric_limits<int64_t>::max() == next_pos)
+    return flush_packetizer(requested_ptzr);
+
+  if (next_audio_demuxer) {
+    auto chunk = read_chunk(next_pos, m_avi->track[next_audio_demuxer->m_aid].audio_index[next_audio_chunk].len);
+
+    AVI_set_audio_track(m_avi, next_audio_demuxer->m_aid);
+    AVI_set_audio_position_index(m_avi, chunk ? next_audio_chunk + 1 : AVI_max_audio_chunk(m_avi));
+
+    if (chunk)
+      process_audio_chunk(*next_audio_demuxer, chunk);
+
+    return FILE_STATUS_MOREDATA;
+  }
+
+  // Empty frames following this one are dropped frames. They're
+  // covered by this frame's duration like in read_video().
+  auto next_frame = find_next_video_frame(video_frame + 1);
+  auto chunk      = read_chunk(next_pos, m_avi->video_index[video_frame].len);
+
+  if (!chunk) {
+    m_video_frames_read = m_max_video_frames;
+    return FILE_STATUS_MOREDATA;
+  }
+
+  int64_t timestamp       = static_cast<int64_t>(static_cast<int64_t>(m_video_frames_read)              * 1000000000ll / m_fps);
+  int64_t duration        = static_cast<int64_t>(static_cast<int64_t>(next_frame - m_video_frames_read) * 1000000000ll / m_fps);
+
+  m_dropped_video_frames += next_frame - m_video_frames_read - 1;
+  m_video_frames_read     = next_frame;
+
+  process_video_frame(chunk, timestamp, duration, 0x10 == m_avi->video_index[video_frame].key);
+
+  return FILE_STATUS_MOREDATA;
+}
+
 file_status_e
 avi_reader_c::read_subtitles(avi_subs_demuxer_t &demuxer) {
   if (!demuxer.m_subs->empty())
@@ -806,6 +1026,13 @@ avi_reader_c::read_subtitles(avi_subs_demuxer_t &demuxer) {
 file_status_e
 avi_reader_c::read(generic_packetizer_c *ptzr,
                    bool) {
+  for (auto &subs_demuxer : m_subtitle_demuxers)
+    if ((-1 != subs_demuxer.m_ptzr) && (PTZR(subs_demuxer.m_ptzr) == ptzr))
+      return read_subtitles(subs_demuxer);
+
+  if (m_read_in_file_order)
+    return read_in_file_order(ptzr);
+
   if ((-1 != m_vptzr) && (PTZR(m_vptzr) == ptzr))
     return read_video();
 
@@ -813,10 +1040,6 @@ avi_reader_c::read(generic_packetizer_c *ptzr,
     if ((-1 != demuxer.m_ptzr) && (PTZR(demuxer.m_ptzr) == ptzr))
       return read_audio(demuxer);
 
-  for (auto &subs_demuxer : m_subtitle_demuxers)
-    if ((-1 != subs_demuxer.m_ptzr) && (PTZR(subs_demuxer.m_ptzr) == ptzr))
-      return read_subtitles(subs_demuxer);
-
   return flush_packetizers();
 }
 
@@ -922,15 +1145,15 @@ avi_reader_c::identify_attachments() {
       mm_text_io_c text_io(new mm_mem_io_c(demuxer.m_subtitles->get_buffer(), demuxer.m_subtitles->get_size()));
       ssa_parser_c parser(this, &text_io, m_ti.m_fname, i + 1 + AVI_audio_tracks(m_avi));
 
-      parser.set_attachment_id_base(g_attachments.size());
+      parser.set_attachment_id_base(get_attachment_id_base());
       parser.parse();
 
     } catch (...) {
     }
   }
 
-  for (i = 0; i < g_attachments.size(); i++)
-    id_result_attachment(g_attachments[i].ui_id, g_attachments[i].mime_type, g_attachments[i].data->get_size(), g_attachments[i].name, g_attachments[i].description);
+  for (auto &attachment : m_identified_attachments)
+    id_result_attachment(attachment.ui_id, attachment.mime_type, attachment.data->get_size(), attachment.name, attachment.description);
 }
 
 void
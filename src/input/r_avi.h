@@ -78,6 +78,12 @@ private:
   uint64_t m_bytes_to_process, m_bytes_processed;
   bool m_video_track_ok;
 
+  bool m_read_in_file_order;
+  memory_cptr m_read_buffer;
+  int64_t m_read_buffer_pos;
+
+  debugging_option_c m_debug_interleaving;
+
 public:
   avi_reader_c(const track_info_c &ti, const mm_io_cptr &in);
   virtual ~avi_reader_c();
@@ -101,6 +107,16 @@ protected:
   virtual file_status_e read_video();
   virtual file_status_e read_audio(avi_demuxer_t &demuxer);
   virtual file_status_e read_subtitles(avi_subs_demuxer_t &demuxer);
+  virtual file_status_e read_in_file_order(generic_packetizer_c *requested_ptzr);
+
+  virtual void process_video_frame(memory_cptr const &chunk, int64_t timestamp, int64_t duration, bool key);
+  virtual void process_audio_chunk(avi_demuxer_t &demuxer, memory_cptr const &chunk);
+
+  unsigned int find_next_video_frame(unsigned int frame) const;
+  int find_next_audio_chunk(avi_demuxer_t &demuxer);
+  memory_cptr read_chunk(int64_t pos, size_t size);
+
+  void detect_interleaving();
 
   virtual generic_packetizer_c *create_aac_packetizer(int aid, avi_demuxer_t &demuxer);
   virtual generic_packetizer_c *create_dts_packetizer(int aid);
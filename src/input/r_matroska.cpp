@@ -31,6 +31,8 @@
 #include <matroska/KaxCluster.h>
 #include <matroska/KaxClusterData.h>
 #include <matroska/KaxContexts.h>
+#include <matroska/KaxCues.h>
+#include <matroska/KaxCuesData.h>
 #include <matroska/KaxInfo.h>
 #include <matroska/KaxInfoData.h>
 #include <matroska/KaxSeekHead.h>
@@ -107,8 +109,6 @@ using namespace libmatroska;
 
 #define is_ebmlvoid(e) (Is<EbmlVoid>(e))
 
-#define MAGIC_MKV 0x1a45dfa3
-
 void
 kax_track_t::handle_packetizer_display_dimensions() {
   // If user hasn't set an aspect ratio via the command line and the
@@ -228,6 +228,7 @@ kax_reader_c::kax_reader_c(const track_info_c &ti,
   , m_segment_duration(0)
   , m_last_timecode(0)
   , m_first_timecode(-1)
+  , m_segment_data_start(0)
   , m_writing_app_ver(-1)
   , m_attachment_id(0)
   , m_file_status(FILE_STATUS_MOREDATA)
@@ -247,6 +248,7 @@ kax_reader_c::init_l1_position_storage(deferred_positions_t &storage) {
   storage[dl1t_tags]        = std::vector<int64_t>();
   storage[dl1t_tracks]      = std::vector<int64_t>();
   storage[dl1t_seek_head]   = std::vector<int64_t>();
+  storage[dl1t_cues]        = std::vector<int64_t>();
 }
 
 bool
@@ -672,7 +674,7 @@ kax_reader_c::handle_attachments(mm_io_c *io,
     matt.ui_id          = m_attachment_id;
     matt.to_all_files   = ATTACH_MODE_TO_ALL_FILES == attach_mode;
 
-    add_attachment(matt);
+    add_attachment_from_file(matt);
   }
 }
 
@@ -1096,6 +1098,7 @@ kax_reader_c::handle_seek_head(mm_io_c *io,
         :                       Is<KaxTracks>(id)      ? dl1t_tracks
         :                       Is<KaxSeekHead>(id)    ? dl1t_seek_head
         :                       Is<KaxInfo>(id)        ? dl1t_info
+        :                       Is<KaxCues>(id)        ? dl1t_cues
         :                                                dl1t_unknown;
 
       if (dl1t_unknown == type)
@@ -1133,6 +1136,8 @@ kax_reader_c::read_headers_internal() {
     m_es        = std::shared_ptr<EbmlStream>(new EbmlStream(*m_in));
     m_in_file   = kax_file_cptr(new kax_file_c(m_in));
 
+    m_in->enable_readahead(8 * 1024 * 1024);
+
     // Find the EbmlHead element. Must be the first one.
     EbmlElement *l0 = m_es->FindNextID(EBML_INFO(EbmlHead), 0xFFFFFFFFFFFFFFFFLL);
     if (!l0) {
@@ -1158,6 +1163,8 @@ kax_reader_c::read_headers_internal() {
       return false;
     }
 
+    m_segment_data_start = static_cast<KaxSegment *>(l0)->GetGlobalPosition(0);
+
     // We've got our segment, so let's find the m_tracks
     int upper_lvl_el = 0;
     m_tc_scale         = TIMECODE_SCALE;
@@ -1179,6 +1186,9 @@ kax_reader_c::read_headers_internal() {
       else if (Is<KaxTags>(l1))
         m_deferred_l1_positions[dl1t_tags].push_back(l1->GetElementPosition());
 
+      else if (Is<KaxCues>(l1))
+        m_deferred_l1_positions[dl1t_cues].push_back(l1->GetElementPosition());
+
       else if (Is<KaxSeekHead>(l1))
         handle_seek_head(m_in.get(), l0, l1->GetElementPosition());
 
@@ -1739,7 +1749,20 @@ kax_reader_c::create_packetizers() {
   for (auto &track : m_tracks)
     create_packetizer(track->tnum);
 
-  if (!g_segment_title_set) {
+  // The payload of blocks for tracks that aren't muxed doesn't have
+  // to be read at all.
+  auto skipped_track_numbers = std::unordered_set<uint64_t>{};
+  for (auto &track : m_tracks)
+    if (-1 == track->ptzr)
+      skipped_track_numbers.insert(track->track_number);
+
+  for (auto &track : m_tracks)
+    if (-1 != track->ptzr)
+      skipped_track_numbers.erase(track->track_number);
+
+  m_in_file->set_skipped_track_numbers(skipped_track_numbers);
+
+  if (!g_segment_title_set && !g_identifying) {
     g_segment_title     = m_title;
     g_segment_title_set = true;
   }
@@ -2101,7 +2124,7 @@ kax_reader_c::process_block_group(KaxCluster *cluster,
       auto data         = std::make_shared<memory_c>(data_buffer.Buffer(), data_buffer.Size(), false);
       block_track->content_decoder.reverse(data, CONTENT_ENCODING_SCOPE_BLOCK);
 
-      auto packet                = std::make_shared<packet_t>(data, m_last_timecode + i * frame_duration, block_duration, block_bref, block_fref);
+      auto packet                = packet_t::create(data, m_last_timecode + i * frame_duration, block_duration, block_bref, block_fref);
       packet->duration_mandatory = duration;
 
       process_block_group_common(block_group, packet.get());
@@ -2124,7 +2147,7 @@ kax_reader_c::process_block_group(KaxCluster *cluster,
 
     if (('s' == block_track->type) && ('t' == block_track->sub_type)) {
       if ((2 < data->get_size()) || ((0 < data->get_size()) && (' ' != *data->get_buffer()) && (0 != *data->get_buffer()) && !iscr(*data->get_buffer()))) {
-        auto packet = std::make_shared<packet_t>(data, m_last_timecode, block_duration, block_bref, block_fref);
+        auto packet = packet_t::create(data, m_last_timecode, block_duration, block_bref, block_fref);
 
         process_block_group_common(block_group, packet.get());
 
@@ -2132,7 +2155,7 @@ kax_reader_c::process_block_group(KaxCluster *cluster,
       }
 
     } else {
-      auto packet = std::make_shared<packet_t>(data, m_last_timecode + block_idx * frame_duration, block_duration, block_bref, block_fref);
+      auto packet = packet_t::create(data, m_last_timecode + block_idx * frame_duration, block_duration, block_bref, block_fref);
 
       if ((duration) && !duration->GetValue())
         packet->duration_mandatory = true;
@@ -2274,7 +2297,7 @@ kax_reader_c::identify() {
                     info, verbose_info);
   }
 
-  for (auto &attachment : g_attachments)
+  for (auto &attachment : m_identified_attachments)
     id_result_attachment(attachment.ui_id, attachment.mime_type, attachment.data->get_size(), attachment.name, attachment.description, attachment.id);
 
   if (m_chapters)
@@ -2294,6 +2317,50 @@ kax_reader_c::add_available_track_ids() {
     add_available_track_id(track->tnum);
 }
 
+bool
+kax_reader_c::seek_to_timecode(int64_t timecode) {
+  static debugging_option_c s_debug{"kax_reader|kax_reader_seek"};
+
+  if (m_appending || m_deferred_l1_positions[dl1t_cues].empty())
+    return false;
+
+  // The cluster positions are relative to the start of the segment's
+  // data.
+  auto best_position = int64_t{-1};
+
+  for (auto cues_position : m_deferred_l1_positions[dl1t_cues]) {
+    m_in->save_pos(cues_position);
+    at_scope_exit_c restore([this]() { m_in->restore_pos(); });
+
+    try {
+      int upper_lvl_el = 0;
+      std::shared_ptr<EbmlElement> l1(m_es->FindNextElement(EBML_CLASS_CONTEXT(KaxSegment), upper_lvl_el, 0xFFFFFFFFL, true));
+      auto cues = dynamic_cast<KaxCues *>(l1.get());
+
+      if (!cues)
+        continue;
+
+      EbmlElement *l2 = nullptr;
+      upper_lvl_el    = 0;
+      cues->Read(*m_es, EBML_CLASS_CONTEXT(KaxCues), upper_lvl_el, l2, true);
+
+      best_position = std::max(best_position, find_cluster_position_in_cues(*cues, timecode, m_tc_scale));
+
+    } catch (...) {
+      mxdebug_if(s_debug, boost::format("kax_reader_seek: exception while reading the cues at %1%\n") % cues_position);
+    }
+  }
+
+  mxdebug_if(s_debug, boost::format("kax_reader_seek: requested %1% cluster position %2%\n") % format_timecode(timecode) % best_position);
+
+  if (-1 == best_position)
+    return false;
+
+  m_in->setFilePointer(m_segment_data_start + best_position, seek_beginning);
+
+  return true;
+}
+
 void
 kax_reader_c::set_track_packetizer(kax_track_t *t,
                                    generic_packetizer_c *ptzr) {
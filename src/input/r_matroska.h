@@ -34,6 +34,9 @@
 using namespace libebml;
 using namespace libmatroska;
 
+// The EBML head's ID
+#define MAGIC_MKV 0x1a45dfa3
+
 struct kax_track_t {
   uint64_t tnum, track_number, track_uid;
 
@@ -168,6 +171,7 @@ private:
     dl1t_tracks,
     dl1t_seek_head,
     dl1t_info,
+    dl1t_cues,
   };
 
   std::vector<kax_track_cptr> m_tracks;
@@ -179,7 +183,7 @@ private:
 
   std::shared_ptr<EbmlStream> m_es;
 
-  int64_t m_segment_duration, m_last_timecode, m_first_timecode;
+  int64_t m_segment_duration, m_last_timecode, m_first_timecode, m_segment_data_start;
   std::string m_title;
 
   typedef std::map<deferred_l1_type_e, std::vector<int64_t> > deferred_positions_t;
@@ -215,6 +219,7 @@ public:
   virtual void create_packetizers();
   virtual void create_packetizer(int64_t tid);
   virtual void add_available_track_ids();
+  virtual bool seek_to_timecode(int64_t timecode);
 
   static int probe_file(mm_io_c *in, uint64_t size);
 
@@ -51,6 +51,8 @@
 #define TS_PIDS_DETECT_SIZE    10 * 1024 * 1024
 #define TS_PACKET_SIZE         188
 #define TS_MAX_PACKET_SIZE     204
+#define TS_READ_BUFFER_PACKETS 256
+#define TS_RESYNC_BUFFER_SIZE  (64 * 1024)
 
 int mpeg_ts_reader_c::potential_packet_sizes[] = { 188, 192, 204, 0 };
 
@@ -88,7 +90,7 @@ mpeg_ts_track_c::send_to_packetizer() {
 
   if (use_packet) {
     auto bytes_to_skip = std::min<size_t>(pes_payload->get_size(), skip_packet_data_bytes);
-    process(std::make_shared<packet_t>(memory_c::clone(pes_payload->get_buffer() + bytes_to_skip, pes_payload->get_size() - bytes_to_skip), timecode_to_use.to_ns(-1)));
+    process(packet_t::create(memory_c::clone(pes_payload->get_buffer() + bytes_to_skip, pes_payload->get_size() - bytes_to_skip), timecode_to_use.to_ns(-1)));
   }
 
   pes_payload->remove(pes_payload->get_size());
@@ -589,9 +591,12 @@ mpeg_ts_reader_c::detect_packet_size(mm_io_c *in,
     size = in->read(mem, size);
 
     std::vector<int> positions;
-    for (size_t i = 0; i < size; ++i)
-      if (0x47 == mem[i])
-        positions.push_back(i);
+    for (auto pos = mem, end = mem + size; pos < end; ++pos) {
+      pos = static_cast<unsigned char *>(memchr(pos, 0x47, end - pos));
+      if (!pos)
+        break;
+      positions.push_back(pos - mem);
+    }
 
     for (size_t i = 0; positions.size() > i; ++i) {
       for (size_t k = 0; 0 != potential_packet_sizes[k]; ++k) {
@@ -640,6 +645,9 @@ mpeg_ts_reader_c::mpeg_ts_reader_c(const track_info_c &ti,
   , m_num_pmt_crc_errors{}
   , m_validate_pat_crc{true}
   , m_validate_pmt_crc{true}
+  , m_read_buffer_pos{}
+  , m_read_buffer_fill{}
+  , m_read_buffer_file_pos{}
 {
   auto mpls_in = dynamic_cast<mm_mpls_multi_file_io_c *>(get_underlying_input());
   if (mpls_in)
@@ -653,6 +661,7 @@ mpeg_ts_reader_c::read_headers() {
 
     m_detected_packet_size = detect_packet_size(m_in.get(), size_to_probe);
     m_in->setFilePointer(0);
+    m_in->enable_readahead(16 * 1024 * 1024);
 
     mxdebug_if(m_debug_headers, boost::format("mpeg_ts_reader_c::read_headers: Starting to build PID list. (packet size: %1%)\n") % m_detected_packet_size);
 
@@ -1137,6 +1146,15 @@ bool
 mpeg_ts_reader_c::parse_packet(unsigned char *buf) {
   mpeg_ts_packet_header_t *hdr = (mpeg_ts_packet_header_t *)buf;
   uint16_t table_pid           = hdr->get_pid();
+  size_t tidx                  = 0;
+
+  // Fast path while muxing: skip packets for PIDs that aren't muxed
+  // without looking at them any further.
+  if (!m_track_idx_by_pid.empty()) {
+    if (-1 == m_track_idx_by_pid[table_pid])
+      return false;
+    tidx = m_track_idx_by_pid[table_pid];
+  }
 
   if (hdr->get_transport_error_indicator()) //corrupted packet
     return false;
@@ -1144,10 +1162,10 @@ mpeg_ts_reader_c::parse_packet(unsigned char *buf) {
   if (!(hdr->get_adaptation_field_control() & 0x01)) //no ts_payload
     return false;
 
-  size_t tidx;
-  for (tidx = 0; tracks.size() > tidx; ++tidx)
-    if ((tracks[tidx]->pid == table_pid) && (m_probing || (-1 != tracks[tidx]->ptzr)))
-      break;
+  if (m_track_idx_by_pid.empty())
+    for (tidx = 0; tracks.size() > tidx; ++tidx)
+      if ((tracks[tidx]->pid == table_pid) && (m_probing || (-1 != tracks[tidx]->ptzr)))
+        break;
 
   if ((tidx >= tracks.size()) || tracks[tidx]->processed)
     return false;
@@ -1574,7 +1592,7 @@ mpeg_ts_reader_c::finish() {
   for (auto &track : tracks)
     if ((-1 != track->ptzr) && (0 < track->pes_payload->get_size())) {
       auto bytes_to_skip = std::min<size_t>(track->pes_payload->get_size(), track->skip_packet_data_bytes);
-      track->process(std::make_shared<packet_t>(memory_c::clone(track->pes_payload->get_buffer() + bytes_to_skip, track->pes_payload->get_size() - bytes_to_skip)));
+      track->process(packet_t::create(memory_c::clone(track->pes_payload->get_buffer() + bytes_to_skip, track->pes_payload->get_size() - bytes_to_skip)));
     }
 
   file_done = true;
@@ -1592,22 +1610,18 @@ mpeg_ts_reader_c::read(generic_packetizer_c *requested_ptzr,
       return FILE_STATUS_HOLDING;
   }
 
-  unsigned char buf[TS_MAX_PACKET_SIZE + 1];
-
   track_buffer_ready = -1;
 
   if (file_done)
     return flush_packetizers();
 
-  while (true) {
-    if (m_in->read(buf, m_detected_packet_size) != static_cast<unsigned int>(m_detected_packet_size))
-      return finish();
+  if (m_track_idx_by_pid.empty())
+    build_track_idx_by_pid();
 
-    if (buf[0] != 0x47) {
-      if (resync(m_in->getFilePointer() - m_detected_packet_size))
-        continue;
+  while (true) {
+    auto buf = get_next_packet();
+    if (!buf)
       return finish();
-    }
 
     parse_packet(buf);
 
@@ -1688,33 +1702,95 @@ mpeg_ts_reader_c::parse_clip_info_file() {
   }
 }
 
+void
+mpeg_ts_reader_c::build_track_idx_by_pid() {
+  m_track_idx_by_pid.assign(0x2000, -1);
+
+  // Iterate backwards so that the first matching track wins just like
+  // in the linear search done during probing.
+  for (auto idx = static_cast<int>(tracks.size()) - 1; 0 <= idx; --idx)
+    if (-1 != tracks[idx]->ptzr)
+      m_track_idx_by_pid[tracks[idx]->pid & 0x1fff] = idx;
+}
+
+bool
+mpeg_ts_reader_c::fill_read_buffer() {
+  auto capacity = TS_READ_BUFFER_PACKETS * m_detected_packet_size;
+  if (!m_read_buffer)
+    m_read_buffer = memory_c::alloc(capacity);
+
+  auto buffer    = m_read_buffer->get_buffer();
+  auto remaining = m_read_buffer_fill - m_read_buffer_pos;
+
+  if (remaining)
+    memmove(buffer, buffer + m_read_buffer_pos, remaining);
+
+  m_read_buffer_pos      = 0;
+  m_read_buffer_fill     = remaining + m_in->read(buffer + remaining, capacity - remaining);
+  m_read_buffer_file_pos = m_in->getFilePointer() - m_read_buffer_fill;
+
+  return m_read_buffer_fill >= m_detected_packet_size;
+}
+
+unsigned char *
+mpeg_ts_reader_c::get_next_packet() {
+  while (true) {
+    if (((m_read_buffer_fill - m_read_buffer_pos) < m_detected_packet_size) && !fill_read_buffer())
+      return nullptr;
+
+    auto packet = m_read_buffer->get_buffer() + m_read_buffer_pos;
+
+    if (0x47 == packet[0]) {
+      m_read_buffer_pos += m_detected_packet_size;
+      return packet;
+    }
+
+    if (!resync(m_read_buffer_file_pos + m_read_buffer_pos))
+      return nullptr;
+
+    // resync() has positioned the file at the next valid packet.
+    m_read_buffer_pos  = 0;
+    m_read_buffer_fill = 0;
+  }
+}
+
 bool
 mpeg_ts_reader_c::resync(int64_t start_at) {
   try {
     mxdebug_if(m_debug_resync, boost::format("mpeg_ts_reader_c::resync: Start resync for data from %1%\n") % start_at);
-    m_in->setFilePointer(start_at);
 
-    unsigned char buf[TS_MAX_PACKET_SIZE + 1];
+    // Scan whole chunks for a sync byte that is followed by another
+    // one exactly one packet later.
+    auto buffer     = memory_c::alloc(TS_RESYNC_BUFFER_SIZE);
+    auto buf        = buffer->get_buffer();
+    auto buffer_pos = start_at;
 
-    while (!m_in->eof()) {
-      int64_t curr_pos = m_in->getFilePointer();
-      buf[0] = m_in->read_uint8();
-
-      if (0x47 != buf[0])
-        continue;
+    while (true) {
+      m_in->setFilePointer(buffer_pos);
 
-      if (m_in->read(&buf[1], m_detected_packet_size) != static_cast<unsigned int>(m_detected_packet_size))
+      auto num_read = m_in->read(buf, TS_RESYNC_BUFFER_SIZE);
+      if (num_read <= m_detected_packet_size)
         return false;
 
-      if (0x47 != buf[m_detected_packet_size]) {
-        m_in->setFilePointer(curr_pos + 1);
-        continue;
-      }
+      auto end = buf + num_read - m_detected_packet_size;
+
+      for (auto pos = buf; pos < end; ++pos) {
+        pos = static_cast<unsigned char *>(memchr(pos, 0x47, end - pos));
+        if (!pos)
+          break;
 
-      mxdebug_if(m_debug_resync, boost::format("mpeg_ts_reader_c::resync: Re-established at %1%\n") % curr_pos);
+        if (0x47 != pos[m_detected_packet_size])
+          continue;
+
+        int64_t curr_pos = buffer_pos + (pos - buf);
+
+        mxdebug_if(m_debug_resync, boost::format("mpeg_ts_reader_c::resync: Re-established at %1%\n") % curr_pos);
+
+        m_in->setFilePointer(curr_pos);
+        return true;
+      }
 
-      m_in->setFilePointer(curr_pos);
-      return true;
+      buffer_pos += end - buf;
     }
 
   } catch (...) {
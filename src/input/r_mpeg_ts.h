@@ -405,6 +405,15 @@ protected:
   unsigned int m_detected_packet_size, m_num_pat_crc_errors, m_num_pmt_crc_errors;
   bool m_validate_pat_crc, m_validate_pmt_crc;
 
+  // While muxing whole chunks of packets are read at once.
+  memory_cptr m_read_buffer;
+  size_t m_read_buffer_pos, m_read_buffer_fill;
+  int64_t m_read_buffer_file_pos;
+
+  // Maps PIDs to indexes into 'tracks' for all tracks that are being
+  // muxed; -1 for all other PIDs. Only used once probing is done.
+  std::vector<int> m_track_idx_by_pid;
+
 protected:
   static int potential_packet_sizes[];
 
@@ -438,6 +447,10 @@ private:
   int determine_track_parameters(mpeg_ts_track_ptr const &track);
 
   file_status_e finish();
+
+  unsigned char *get_next_packet();
+  bool fill_read_buffer();
+  void build_track_idx_by_pid();
   int send_to_packetizer(mpeg_ts_track_ptr &track);
   void create_mpeg1_2_video_packetizer(mpeg_ts_track_ptr &track);
   void create_mpeg4_p10_es_video_packetizer(mpeg_ts_track_ptr &track);
@@ -55,6 +55,14 @@ using namespace libmatroska;
 
 #define MAX_INTERLEAVING_BADNESS 0.4
 
+// Settings for the read planner used for badly interleaved files: the
+// maximum size of a single read, the maximum gap between two samples
+// of the same track still read together and the maximum amount of
+// data kept for tracks other than the one being read.
+#define READ_PLANNER_MAX_RANGE_SIZE  (8 * 1024 * 1024)
+#define READ_PLANNER_MAX_GAP_SIZE    (512 * 1024)
+#define READ_PLANNER_MEMORY_BUDGET   (64 * 1024 * 1024)
+
 static std::string
 space(int num) {
   return std::string(num, ' ');
@@ -133,11 +141,14 @@ qtmp4_reader_c::qtmp4_reader_c(const track_info_c &ti,
   , m_fragment{}
   , m_track_for_fragment{}
   , m_timecodes_calculated{}
+  , m_use_read_planner{}
+  , m_planned_bytes{}
   , m_debug_chapters{    "qtmp4|qtmp4_full|qtmp4_chapters"}
   , m_debug_headers{     "qtmp4|qtmp4_full|qtmp4_headers"}
   , m_debug_tables{            "qtmp4_full|qtmp4_tables"}
   , m_debug_interleaving{"qtmp4|qtmp4_full|qtmp4_interleaving"}
   , m_debug_resync{      "qtmp4|qtmp4_full|qtmp4_resync"}
+  , m_debug_read_planner{"qtmp4|qtmp4_full|qtmp4_read_planner"}
 {
 }
 
@@ -1380,9 +1391,7 @@ qtmp4_reader_c::read(generic_packetizer_c *ptzr,
     return flush_packetizers();
 
   qtmp4_demuxer_cptr &dmx = m_demuxers[dmx_idx];
-  qt_index_t &index       = dmx->m_index[dmx->pos];
-
-  m_in->setFilePointer(index.file_pos);
+  auto index              = dmx->m_index[dmx->pos];
 
   int buffer_offset = 0;
   memory_cptr buffer;
@@ -1396,12 +1405,30 @@ qtmp4_reader_c::read(generic_packetizer_c *ptzr,
     buffer_offset = dmx->esds.decoder_config->get_size();
 
     memcpy(buffer->get_buffer(), dmx->esds.decoder_config->get_buffer(), dmx->esds.decoder_config->get_size());
-
-  } else {
-    buffer = memory_c::alloc(index.size);
   }
 
-  if (m_in->read(buffer->get_buffer() + buffer_offset, index.size) != index.size) {
+  try {
+    if (m_use_read_planner) {
+      auto data = read_planned_sample(*dmx);
+
+      if (!buffer)
+        buffer = data;
+      else
+        memcpy(buffer->get_buffer() + buffer_offset, data->get_buffer(), index.size);
+
+    } else {
+      m_in->setFilePointer(index.file_pos);
+
+      // Let the I/O class decide how to provide the data, e.g. as a
+      // view into a memory mapped file.
+      if (!buffer)
+        buffer = m_in->read(index.size);
+
+      else if (m_in->read(buffer->get_buffer() + buffer_offset, index.size) != index.size)
+        throw mtx::mm_io::end_of_file_x{};
+    }
+
+  } catch (mtx::mm_io::exception &) {
     mxwarn(boost::format(Y("Quicktime/MP4 reader: Could not read chunk number %1%/%2% with size %3% from position %4%. Aborting.\n"))
            % dmx->pos % dmx->m_index.size() % index.size % index.file_pos);
     return flush_packetizers();
@@ -1740,6 +1767,10 @@ qtmp4_reader_c::create_packetizers() {
 
   for (i = 0; i < m_demuxers.size(); ++i)
     create_packetizer(m_demuxers[i]->id);
+
+  // From here on only the index is needed for reading.
+  for (auto &dmx : m_demuxers)
+    dmx->release_tables();
 }
 
 int
@@ -1748,9 +1779,8 @@ qtmp4_reader_c::get_progress() {
     return 100;
 
   qtmp4_demuxer_cptr &dmx = m_demuxers[m_main_dmx];
-  unsigned int max_chunks = (0 == dmx->sample_size) ? dmx->sample_table.size() : dmx->chunk_table.size();
 
-  return 100 * dmx->pos / max_chunks;
+  return 100 * dmx->pos / dmx->m_index.size();
 }
 
 void
@@ -1860,8 +1890,111 @@ qtmp4_reader_c::detect_interleaving() {
   double badness = *boost::max_element(gradients) - *boost::min_element(gradients);
   mxdebug_if(m_debug_interleaving, boost::format("Interleaving: Badness: %1% (%2%)\n") % badness % (MAX_INTERLEAVING_BADNESS < badness ? "badly interleaved" : "ok"));
 
-  if (MAX_INTERLEAVING_BADNESS < badness)
+  if (MAX_INTERLEAVING_BADNESS < badness) {
     m_in->enable_buffering(false);
+    m_use_read_planner = true;
+  }
+}
+
+memory_cptr
+qtmp4_reader_c::read_planned_sample(qtmp4_demuxer_c &dmx) {
+  if (dmx.m_planned_samples.empty())
+    read_planned_range(dmx);
+
+  auto data = dmx.m_planned_samples.front();
+  dmx.m_planned_samples.pop_front();
+  m_planned_bytes -= data->get_size();
+
+  return data;
+}
+
+/** \brief Read the data for the track's next samples in one go
+
+   Starting with the track's next sample, the track's following samples
+   are added to the range to read as long as they're stored in
+   ascending order without big gaps in between. All samples of other
+   tracks located in the range are kept for later as well as long as
+   the memory budget allows it. That way a badly interleaved file is
+   read in large sequential chunks instead of seeking back and forth
+   for each sample.
+*/
+void
+qtmp4_reader_c::read_planned_range(qtmp4_demuxer_c &dmx) {
+  auto const first  = dmx.m_index[dmx.pos];
+  uint64_t start    = first.file_pos;
+  uint64_t end      = first.file_pos + first.size;
+
+  for (auto idx = dmx.pos + 1; idx < dmx.m_index.size(); ++idx) {
+    auto const sample  = dmx.m_index[idx];
+    uint64_t pos       = sample.file_pos;
+
+    if ((pos < end) || ((pos - end) > READ_PLANNER_MAX_GAP_SIZE) || ((pos + sample.size - start) > READ_PLANNER_MAX_RANGE_SIZE))
+      break;
+
+    end = pos + sample.size;
+  }
+
+  m_in->setFilePointer(start);
+  auto range = m_in->read(end - start);
+
+  auto num_samples = 0u;
+
+  for (auto &other : m_demuxers) {
+    if (-1 == other->ptzr)
+      continue;
+
+    auto is_requested_track = other.get() == &dmx;
+
+    for (auto idx = other->pos + other->m_planned_samples.size(); idx < other->m_index.size(); ++idx) {
+      auto const sample  = other->m_index[idx];
+      uint64_t pos       = sample.file_pos;
+
+      if ((pos < start) || ((pos + sample.size) > end))
+        break;
+
+      if (!is_requested_track && ((m_planned_bytes + sample.size) > READ_PLANNER_MEMORY_BUDGET))
+        break;
+
+      other->m_planned_samples.push_back(memory_c::clone(range->get_buffer() + pos - start, sample.size));
+      m_planned_bytes += sample.size;
+      ++num_samples;
+    }
+  }
+
+  mxdebug_if(m_debug_read_planner, boost::format("read planner: track %1% range %2%-%3% (%4% bytes) samples for all tracks %5% buffered bytes %6%\n")
+             % dmx.id % start % end % (end - start) % num_samples % m_planned_bytes);
+}
+
+// ----------------------------------------------------------------------
+
+void
+qt_index_c::push_back(qt_index_t const &entry) {
+  m_file_positions.push_back(entry.file_pos);
+  m_sizes.push_back(entry.size);
+  m_timecodes.push_back(entry.timecode);
+  m_durations.push_back(entry.duration);
+  m_keyframes.push_back(entry.is_keyframe);
+}
+
+qt_index_t
+qt_index_c::operator [](size_t idx)
+  const {
+  return qt_index_t{m_file_positions[idx], m_sizes[idx], m_timecodes[idx], m_durations[idx], m_keyframes[idx]};
+}
+
+void
+qt_index_c::shrink_to_fit() {
+  m_file_positions.shrink_to_fit();
+  m_sizes.shrink_to_fit();
+  m_timecodes.shrink_to_fit();
+  m_durations.shrink_to_fit();
+  m_keyframes.shrink_to_fit();
+}
+
+size_t
+qt_index_c::get_memory_usage()
+  const {
+  return m_file_positions.get_memory_usage() + m_sizes.get_memory_usage() + m_timecodes.get_memory_usage() + m_durations.get_memory_usage() + m_keyframes.capacity() / 8;
 }
 
 // ----------------------------------------------------------------------
@@ -2191,10 +2324,54 @@ qtmp4_demuxer_c::update_editlist_table() {
 
 void
 qtmp4_demuxer_c::build_index() {
+  auto tables_memory_usage = get_tables_memory_usage();
+
   if (sample_size != 0)
     build_index_constant_sample_size_mode();
   else
     build_index_chunk_mode();
+
+  m_index.shrink_to_fit();
+
+  // The timecodes and durations are part of the index now.
+  std::vector<int64_t>{}.swap(timecodes);
+  std::vector<int64_t>{}.swap(durations);
+  std::vector<int64_t>{}.swap(frame_indices);
+
+  mxdebug_if(m_debug_index_memory,
+             boost::format("Track ID %1%: index with %2% entries uses %3% bytes instead of %4% bytes; sample tables used %5% bytes before and %6% bytes after building it\n")
+             % id % m_index.size() % m_index.get_memory_usage() % (m_index.size() * sizeof(qt_index_t)) % tables_memory_usage % get_tables_memory_usage());
+}
+
+void
+qtmp4_demuxer_c::release_tables() {
+  std::vector<qt_sample_t>{}.swap(sample_table);
+  std::vector<qt_chunk_t>{}.swap(chunk_table);
+  std::vector<qt_chunkmap_t>{}.swap(chunkmap_table);
+  std::vector<qt_durmap_t>{}.swap(durmap_table);
+  std::vector<uint32_t>{}.swap(keyframe_table);
+  std::vector<qt_frame_offset_t>{}.swap(raw_frame_offset_table);
+  std::vector<int32_t>{}.swap(frame_offset_table);
+  std::vector<int64_t>{}.swap(timecodes);
+  std::vector<int64_t>{}.swap(durations);
+  std::vector<int64_t>{}.swap(frame_indices);
+
+  mxdebug_if(m_debug_index_memory, boost::format("Track ID %1%: sample tables released; index with %2% entries uses %3% bytes\n") % id % m_index.size() % m_index.get_memory_usage());
+}
+
+size_t
+qtmp4_demuxer_c::get_tables_memory_usage()
+  const {
+  return sample_table.capacity()           * sizeof(qt_sample_t)
+       + chunk_table.capacity()            * sizeof(qt_chunk_t)
+       + chunkmap_table.capacity()         * sizeof(qt_chunkmap_t)
+       + durmap_table.capacity()           * sizeof(qt_durmap_t)
+       + keyframe_table.capacity()         * sizeof(uint32_t)
+       + raw_frame_offset_table.capacity() * sizeof(qt_frame_offset_t)
+       + frame_offset_table.capacity()     * sizeof(int32_t)
+       + timecodes.capacity()              * sizeof(int64_t)
+       + durations.capacity()              * sizeof(int64_t)
+       + frame_indices.capacity()          * sizeof(int64_t);
 }
 
 void
@@ -2267,7 +2444,7 @@ qtmp4_demuxer_c::read_first_bytes(int num_bytes) {
   size_t idx_pos = 0;
 
   while ((0 < num_bytes) && (idx_pos < m_index.size())) {
-    qt_index_t &index          = m_index[idx_pos];
+    auto index                 = m_index[idx_pos];
     uint64_t num_bytes_to_read = std::min((int64_t)num_bytes, index.size);
 
     m_reader.m_in->setFilePointer(index.file_pos);
@@ -18,6 +18,7 @@
 
 #include "common/ac3.h"
 #include "common/codec.h"
+#include "common/delta_coded_vector.h"
 #include "common/dts.h"
 #include "common/fourcc.h"
 #include "common/mm_io.h"
@@ -179,6 +180,32 @@ struct qt_index_t {
   }
 };
 
+// The index of all samples a track consists of. It is kept for the
+// whole time the file is read, and files with a lot of samples may
+// contain several million entries. Therefore each member is stored
+// separately and delta coded instead of keeping a vector of
+// qt_index_t. Sequential access is cheap; random access decodes up to
+// a couple of dozen values per member.
+class qt_index_c {
+protected:
+  delta_coded_vector_c m_file_positions, m_sizes, m_timecodes, m_durations;
+  std::vector<bool> m_keyframes;
+
+public:
+  void push_back(qt_index_t const &entry);
+  qt_index_t operator [](size_t idx) const;
+
+  size_t size() const {
+    return m_keyframes.size();
+  }
+  bool empty() const {
+    return m_keyframes.empty();
+  }
+
+  void shrink_to_fit();
+  size_t get_memory_usage() const;
+};
+
 struct qt_track_defaults_t {
   unsigned int sample_description_id, sample_duration, sample_size, sample_flags;
 
@@ -236,9 +263,13 @@ struct qtmp4_demuxer_c {
 
   std::vector<int64_t> timecodes, durations, frame_indices;
 
-  std::vector<qt_index_t> m_index;
+  qt_index_c m_index;
   std::vector<qt_fragment_t> m_fragments;
 
+  // Data of the samples following 'pos' that has already been read
+  // by the read planner.
+  std::deque<memory_cptr> m_planned_samples;
+
   double fps;
 
   esds_t esds;
@@ -263,7 +294,7 @@ struct qtmp4_demuxer_c {
 
   std::string language;
 
-  debugging_option_c m_debug_tables, m_debug_fps, m_debug_headers, m_debug_editlists;
+  debugging_option_c m_debug_tables, m_debug_fps, m_debug_headers, m_debug_editlists, m_debug_index_memory;
 
   qtmp4_demuxer_c(qtmp4_reader_c &reader)
     : m_reader(reader)
@@ -299,6 +330,7 @@ struct qtmp4_demuxer_c {
     , m_debug_fps{      "qtmp4|qtmp4_full|qtmp4_fps"}
     , m_debug_headers{  "qtmp4|qtmp4_full|qtmp4_headers"}
     , m_debug_editlists{"qtmp4|qtmp4_full|qtmp4_editlists"}
+    , m_debug_index_memory{"qtmp4_full|qtmp4_index_memory"}
   {
     memset(&esds, 0, sizeof(esds_t));
   }
@@ -315,6 +347,7 @@ struct qtmp4_demuxer_c {
   void update_editlist_table();
 
   void build_index();
+  void release_tables();
 
   memory_cptr read_first_bytes(int num_bytes);
 
@@ -355,6 +388,8 @@ private:
   void build_index_chunk_mode();
   void build_index_constant_sample_size_mode();
 
+  size_t get_tables_memory_usage() const;
+
   void calculate_timecodes_constant_sample_size();
   void calculate_timecodes_variable_sample_size();
 
@@ -433,7 +468,10 @@ private:
 
   bool m_timecodes_calculated;
 
-  debugging_option_c m_debug_chapters, m_debug_headers, m_debug_tables, m_debug_interleaving, m_debug_resync;
+  bool m_use_read_planner;
+  uint64_t m_planned_bytes;
+
+  debugging_option_c m_debug_chapters, m_debug_headers, m_debug_tables, m_debug_interleaving, m_debug_resync, m_debug_read_planner;
 
   friend class qtmp4_demuxer_c;
 
@@ -526,6 +564,8 @@ protected:
   virtual void process_chapter_entries(int level, std::vector<qtmp4_chapter_entry_t> &entries);
 
   virtual void detect_interleaving();
+  virtual memory_cptr read_planned_sample(qtmp4_demuxer_c &dmx);
+  virtual void read_planned_range(qtmp4_demuxer_c &dmx);
 
   virtual std::string read_string_atom(qt_atom_t atom, size_t num_skipped);
 };
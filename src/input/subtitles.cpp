@@ -549,7 +549,7 @@ ssa_parser_c::add_attachment_maybe(std::string &name,
   if (attachment.mime_type == "")
     attachment.mime_type = "application/octet-stream";
 
-  add_attachment(attachment);
+  m_reader->add_attachment_from_file(attachment);
 
   name    = "";
   data_uu = "";
@@ -269,7 +269,7 @@ teletext_to_srt_packet_converter_c::process_ttx_packet(packet_cptr const &packet
 
     if (!m_previous_content.empty()) {
       m_previous_timecode = std::max<int64_t>(m_previous_timecode, 0);
-      auto new_packet     = std::make_shared<packet_t>(memory_c::clone(m_previous_content), m_previous_timecode, std::abs(packet->timecode - m_previous_timecode));
+      auto new_packet     = packet_t::create(memory_c::clone(m_previous_content), m_previous_timecode, std::abs(packet->timecode - m_previous_timecode));
 
       mxdebug_if(m_debug, boost::format("  WILL DELIVER at %1% duration %2% content %3%\n") % format_timecode(m_previous_timecode) % format_timecode(new_packet->duration) % m_previous_content);
 
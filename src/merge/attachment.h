@@ -0,0 +1,41 @@
+/*
+   mkvmerge -- utility for splicing together matroska files
+   from component media subtypes
+
+   Distributed under the GPL v2
+   see the file COPYING for details
+   or visit http://www.gnu.org/copyleft/gpl.html
+
+   attachment definitions
+
+   Written by Moritz Bunkus <moritz@bunkus.org>.
+*/
+
+#ifndef MTX_MERGE_ATTACHMENT_H
+#define MTX_MERGE_ATTACHMENT_H
+
+#include "common/common_pch.h"
+
+struct attachment_t {
+  std::string name, stored_name, mime_type, description;
+  uint64_t id;
+  bool to_all_files;
+  memory_cptr data;
+  int64_t ui_id;
+
+  attachment_t() {
+    clear();
+  }
+  void clear() {
+    name         = "";
+    stored_name  = "";
+    mime_type    = "";
+    description  = "";
+    id           = 0;
+    ui_id        = 0;
+    to_all_files = false;
+    data.reset();
+  }
+};
+
+#endif // MTX_MERGE_ATTACHMENT_H
@@ -14,7 +14,12 @@
 
 #include "common/common_pch.h"
 
+#include <ebml/EbmlCrc32.h>
+
+#include "common/at_scope_exit.h"
+#include "common/checksums/crc.h"
 #include "common/date_time.h"
+#include "common/endian.h"
 #include "common/ebml.h"
 #include "common/hacks.h"
 #include "common/math.h"
@@ -32,6 +37,43 @@
 #include <matroska/KaxCuesData.h>
 #include <matroska/KaxSeekHead.h>
 
+namespace {
+
+// Collects a rendered cluster in memory. The file positions
+// reported are the ones the data will have in the output file so that
+// the positions libebml stores in the elements are correct. This
+// allows calculating and inserting the cluster's CRC-32 before the
+// cluster is written to the output file in one go.
+class cluster_render_buffer_io_c: public mm_mem_io_c {
+protected:
+  uint64_t m_base;
+
+public:
+  cluster_render_buffer_io_c(uint64_t base)
+    : mm_mem_io_c{nullptr, 0, 1024 * 1024}
+    , m_base{base}
+  {
+  }
+
+  virtual uint64
+  getFilePointer() {
+    return m_base + mm_mem_io_c::getFilePointer();
+  }
+
+  virtual void
+  setFilePointer(int64 offset,
+                 seek_mode mode = seek_beginning) {
+    mm_mem_io_c::setFilePointer(seek_beginning == mode ? offset - m_base : offset, mode);
+  }
+
+  uint64_t
+  get_num_written() {
+    return mm_mem_io_c::getFilePointer();
+  }
+};
+
+}
+
 cluster_helper_c::impl_t::impl_t()
   : cluster{}
   , cluster_content_size{}
@@ -391,6 +433,10 @@ cluster_helper_c::must_duration_be_set(render_groups_c *rg,
 
 int
 cluster_helper_c::render() {
+  // The track entries are accessed while rendering.
+  pause_reader_threads();
+  at_scope_exit_c resume_reader_threads_at_exit{[]() { resume_reader_threads(); }};
+
   std::vector<render_groups_cptr> render_groups;
   KaxCues cues;
   cues.SetGlobalTimecodeScale(g_timecode_scale);
@@ -446,8 +492,6 @@ cluster_helper_c::render() {
     min_cl_timecode                        = std::min(pack->assigned_timecode, min_cl_timecode);
     max_cl_timecode                        = std::max(pack->assigned_timecode, max_cl_timecode);
 
-    DataBuffer *data_buffer                = new DataBuffer((binary *)pack->data->get_buffer(), pack->data->get_size());
-
     KaxTrackEntry &track_entry             = static_cast<KaxTrackEntry &>(*source->get_track_entry());
 
     kax_block_blob_c *previous_block_group = !render_group->m_groups.empty() ? render_group->m_groups.back().get() : nullptr;
@@ -477,10 +521,21 @@ cluster_helper_c::render() {
       added_to_cues = false;
     }
 
-    // Now put the packet into the cluster.
-    render_group->m_more_data = new_block_group->add_frame_auto(track_entry, pack->assigned_timecode - timecode_offset, *data_buffer, lacing_type,
-                                                                pack->has_bref() ? pack->bref - timecode_offset : -1,
-                                                                pack->has_fref() ? pack->fref - timecode_offset : -1);
+    // Now put the packet into the cluster. Frames that end up alone in
+    // a SimpleBlock are rendered straight from the packet's buffer
+    // without building a DataBuffer.
+    if (new_block_group->can_add_frame_directly() && !track_entry.LacingEnabled()) {
+      new_block_group->add_frame_directly(pack->data, source->get_track_num(), pack->assigned_timecode - timecode_offset,
+                                          pack->has_bref() ? pack->bref - timecode_offset : -1,
+                                          pack->has_fref() ? pack->fref - timecode_offset : -1);
+      render_group->m_more_data = false;
+
+    } else {
+      DataBuffer *data_buffer   = new DataBuffer((binary *)pack->data->get_buffer(), pack->data->get_size());
+      render_group->m_more_data = new_block_group->add_frame_auto(track_entry, pack->assigned_timecode - timecode_offset, *data_buffer, lacing_type,
+                                                                  pack->has_bref() ? pack->bref - timecode_offset : -1,
+                                                                  pack->has_fref() ? pack->fref - timecode_offset : -1);
+    }
 
     if (has_codec_state) {
       KaxBlockGroup &bgroup = (KaxBlockGroup &)*new_block_group;
@@ -552,7 +607,10 @@ cluster_helper_c::render() {
       m->cluster->set_min_timecode(min_cl_timecode - timecode_offset);
       m->cluster->set_max_timecode(max_cl_timecode - timecode_offset);
 
-      m->cluster->Render(*m->out, cues);
+      if (g_write_cluster_crc32)
+        render_cluster_with_crc32(cues);
+      else
+        m->cluster->Render(*m->out, cues);
       m->bytes_in_file += m->cluster->ElementSize();
 
       if (g_kax_sh_cues)
@@ -574,6 +632,40 @@ cluster_helper_c::render() {
   return 1;
 }
 
+// The CRC-32 element is rendered with a dummy value first as its
+// value depends on the cluster's content. The cluster is rendered into
+// memory so that the correct value can be inserted before the cluster
+// is written to the output file. Seeking back in the output file
+// afterwards would force the write buffer to be flushed for each
+// cluster.
+void
+cluster_helper_c::render_cluster_with_crc32(KaxCues &cues) {
+  auto crc32_element = new EbmlCrc32;
+  crc32_element->ForceCrc32(0);
+  m->cluster->InsertElement(*crc32_element, 0);
+
+  auto base = m->out->getFilePointer();
+  cluster_render_buffer_io_c buffer{base};
+  m->cluster->Render(buffer, cues);
+
+  auto data          = buffer.get_buffer();
+  auto size          = buffer.get_num_written();
+  auto value_offset  = crc32_element->GetElementPosition() + crc32_element->HeadSize() - base;
+  auto content_start = value_offset + 4;
+
+  mtx::checksum::crc32_ieee_le_c crc{0xffffffff};
+  crc.set_xor_result(0xffffffff);
+  crc.add(data + content_start, size - content_start);
+  crc.finish();
+
+  auto crc32 = crc.get_result_as_uint();
+  put_uint32_le(data + value_offset, crc32);
+
+  m->out->write(data, size);
+
+  mxdebug_if(m->debug_rendering, boost::format("cluster at %1%: CRC-32 0x%|2$08x|\n") % m->cluster->GetElementPosition() % crc32);
+}
+
 bool
 cluster_helper_c::add_to_cues_maybe(packet_cptr &pack) {
   auto &source  = *pack->source;
@@ -661,6 +753,22 @@ cluster_helper_c::add_split_point(const split_point_c &split_point) {
     ++m->current_split_point;
 }
 
+std::vector<split_point_c> const &
+cluster_helper_c::get_split_points()
+  const {
+  return m->split_points;
+}
+
+void
+cluster_helper_c::set_split_points(std::vector<split_point_c> const &split_points) {
+  m->split_points.clear();
+  m->current_split_point = m->split_points.begin();
+  m->discarding          = false;
+
+  for (auto const &split_point : split_points)
+    add_split_point(split_point);
+}
+
 bool
 cluster_helper_c::split_mode_produces_many_files()
   const {
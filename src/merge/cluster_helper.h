@@ -55,6 +55,8 @@ public:
   void handle_discarded_duration(bool create_new_file, bool previously_discarding);
 
   void add_split_point(split_point_c const &split_point);
+  std::vector<split_point_c> const &get_split_points() const;
+  void set_split_points(std::vector<split_point_c> const &split_points);
   void dump_split_points() const;
   bool splitting() const;
   bool split_mode_produces_many_files() const;
@@ -78,6 +80,8 @@ private:
   void split(packet_cptr &packet);
 
   bool add_to_cues_maybe(packet_cptr &pack);
+
+  void render_cluster_with_crc32(KaxCues &cues);
 };
 
 extern cluster_helper_c *g_cluster_helper;
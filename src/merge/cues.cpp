@@ -24,14 +24,75 @@
 #include "merge/libmatroska_extensions.h"
 #include "merge/output_control.h"
 
+namespace {
+
+bool
+cue_point_less(cue_point_t const &a,
+               cue_point_t const &b) {
+  if (a.timecode < b.timecode)
+    return true;
+  if (a.timecode > b.timecode)
+    return false;
+
+  return a.track_num < b.track_num;
+}
+
+}
+
+void
+cue_point_store_c::push_back(cue_point_t const &point) {
+  m_timecodes.push_back(point.timecode);
+  m_durations.push_back(point.duration);
+  m_cluster_positions.push_back(point.cluster_position);
+  m_codec_state_positions.push_back(point.codec_state_position);
+  m_track_nums.push_back(point.track_num);
+  m_relative_positions.push_back(point.relative_position);
+}
+
+cue_point_t
+cue_point_store_c::at(size_t idx)
+  const {
+  return cue_point_t{ static_cast<uint64_t>(m_timecodes[idx]),
+                      static_cast<uint64_t>(m_durations[idx]),
+                      static_cast<uint64_t>(m_cluster_positions[idx]),
+                      static_cast<uint64_t>(m_codec_state_positions[idx]),
+                      static_cast<uint32_t>(m_track_nums[idx]),
+                      static_cast<uint32_t>(m_relative_positions[idx]) };
+}
+
+void
+cue_point_store_c::clear() {
+  m_timecodes.clear();
+  m_durations.clear();
+  m_cluster_positions.clear();
+  m_codec_state_positions.clear();
+  m_track_nums.clear();
+  m_relative_positions.clear();
+}
+
+size_t
+cue_point_store_c::get_memory_usage()
+  const {
+  return m_timecodes.get_memory_usage()
+       + m_durations.get_memory_usage()
+       + m_cluster_positions.get_memory_usage()
+       + m_codec_state_positions.get_memory_usage()
+       + m_track_nums.get_memory_usage()
+       + m_relative_positions.get_memory_usage();
+}
+
+// ----------------------------------------------------------------------
+
 cues_cptr cues_c::s_cues;
 
 cues_c::cues_c()
-  : m_num_cue_points_postprocessed{}
+  : m_stored_points_size{}
+  , m_stored_points_sorted{true}
   , m_no_cue_duration{hack_engaged(ENGAGE_NO_CUE_DURATION)}
   , m_no_cue_relative_position{hack_engaged(ENGAGE_NO_CUE_RELATIVE_POSITION)}
   , m_debug_cue_duration{         "cues|cues_cue_duration"}
   , m_debug_cue_relative_position{"cues|cues_cue_relative_position"}
+  , m_debug_cue_storage{          "cues|cues_storage"}
 {
 }
 
@@ -64,23 +125,20 @@ cues_c::add(KaxCuePoint &point) {
     uint64_t track_num = FindChildValue<KaxCueTrack>(*positions);
     assert(track_num <= static_cast<uint64_t>(std::numeric_limits<uint32_t>::max()));
 
-    m_points.push_back({ timecode, 0, FindChildValue<KaxCueClusterPosition>(*positions), static_cast<uint32_t>(track_num), 0 });
-
+    uint64_t cluster_position     = FindChildValue<KaxCueClusterPosition>(*positions);
     uint64_t codec_state_position = FindChildValue<KaxCueCodecState>(*positions);
-    if (codec_state_position)
-      m_codec_state_position_map[ id_timecode_t{ track_num, timecode } ] = codec_state_position;
+
+    m_pending_points.push_back({ timecode, 0, cluster_position, codec_state_position, static_cast<uint32_t>(track_num), 0 });
   }
 }
 
 void
 cues_c::write(mm_io_c &out,
               KaxSeekHead &seek_head) {
-  if (!m_points.size() || !g_cue_writing_requested)
-    return;
+  store_pending_points();
 
-  // auto start = get_current_time_millis();
-  sort();
-  // auto end_sort = get_current_time_millis();
+  if (m_stored_points.empty() || !g_cue_writing_requested)
+    return;
 
   // Need to write the (empty) cues element so that its position will
   // be set for indexing in g_kax_sh_main. Necessary because there's
@@ -95,54 +153,79 @@ cues_c::write(mm_io_c &out,
   // Write meta seek information if it is not disabled.
   seek_head.IndexThis(cues_dummy, *g_kax_segment);
 
-  // Forcefully write the correct head and copy its content from the
-  // temporary storage location.
-  auto total_size = calculate_total_size();
-  write_ebml_element_head(out, EBML_ID(KaxCues), total_size);
+  // Forcefully write the correct head and render the points one by
+  // one from the compact storage.
+  write_ebml_element_head(out, EBML_ID(KaxCues), m_stored_points_size);
 
-  for (auto &point : m_points) {
-    KaxCuePoint kc_point;
+  if (m_stored_points_sorted)
+    for (auto idx = 0u; idx < m_stored_points.size(); ++idx)
+      write_point(out, m_stored_points[idx]);
 
-    GetChild<KaxCueTime>(kc_point).SetValue(point.timecode / g_timecode_scale);
+  else {
+    // Some cue points of a cluster lie in front of those of an earlier
+    // cluster. Only in this case all of them have to be sorted in
+    // memory.
+    std::vector<cue_point_t> points;
+    points.reserve(m_stored_points.size());
 
-    auto &positions = GetChild<KaxCueTrackPositions>(kc_point);
-    GetChild<KaxCueTrack>(positions).SetValue(point.track_num);
-    GetChild<KaxCueClusterPosition>(positions).SetValue(point.cluster_position);
+    for (auto idx = 0u; idx < m_stored_points.size(); ++idx)
+      points.push_back(m_stored_points[idx]);
 
-    auto codec_state_position = m_codec_state_position_map.find({ point.track_num, point.timecode });
-    if (codec_state_position != m_codec_state_position_map.end())
-      GetChild<KaxCueCodecState>(positions).SetValue(codec_state_position->second);
+    std::stable_sort(points.begin(), points.end(), cue_point_less);
 
-    if (point.relative_position)
-      GetChild<KaxCueRelativePosition>(positions).SetValue(point.relative_position);
+    for (auto const &point : points)
+      write_point(out, point);
+  }
 
-    if (point.duration)
-      GetChild<KaxCueDuration>(positions).SetValue(RND_TIMECODE_SCALE(point.duration) / g_timecode_scale);
+  m_stored_points.clear();
+  m_stored_points_size   = 0;
+  m_stored_points_sorted = true;
+}
 
-    kc_point.Render(out);
-  }
+void
+cues_c::write_point(mm_io_c &out,
+                    cue_point_t const &point)
+  const {
+  KaxCuePoint kc_point;
+
+  GetChild<KaxCueTime>(kc_point).SetValue(point.timecode / g_timecode_scale);
+
+  auto &positions = GetChild<KaxCueTrackPositions>(kc_point);
+  GetChild<KaxCueTrack>(positions).SetValue(point.track_num);
+  GetChild<KaxCueClusterPosition>(positions).SetValue(point.cluster_position);
+
+  if (point.codec_state_position)
+    GetChild<KaxCueCodecState>(positions).SetValue(point.codec_state_position);
+
+  if (point.relative_position)
+    GetChild<KaxCueRelativePosition>(positions).SetValue(point.relative_position);
 
-  m_points.clear();
-  m_codec_state_position_map.clear();
-  m_num_cue_points_postprocessed = 0;
+  if (point.duration)
+    GetChild<KaxCueDuration>(positions).SetValue(RND_TIMECODE_SCALE(point.duration) / g_timecode_scale);
 
-  // auto end_all = get_current_time_millis();
-  // mxinfo(boost::format("dur sort %1% write %2% total %3%\n") % (end_sort - start) % (end_all - end_sort) % (end_all - start));
+  kc_point.Render(out);
 }
 
 void
-cues_c::sort() {
-  brng::sort(m_points, [](cue_point_t const &a, cue_point_t const &b) -> bool {
-      if (a.timecode < b.timecode)
-        return true;
-      if (a.timecode > b.timecode)
-        return false;
-
-      if (a.track_num < b.track_num)
-        return true;
-
-      return false;
-    });
+cues_c::store_pending_points() {
+  if (m_pending_points.empty())
+    return;
+
+  std::stable_sort(m_pending_points.begin(), m_pending_points.end(), cue_point_less);
+
+  if (m_stored_points_sorted && !m_stored_points.empty() && cue_point_less(m_pending_points.front(), m_stored_points[m_stored_points.size() - 1]))
+    m_stored_points_sorted = false;
+
+  for (auto const &point : m_pending_points) {
+    m_stored_points.push_back(point);
+    m_stored_points_size += calculate_point_size(point);
+  }
+
+  m_pending_points.clear();
+
+  mxdebug_if(m_debug_cue_storage,
+             boost::format("cue_storage: %1% points stored in %2% bytes; element size %3% sorted %4%\n")
+             % m_stored_points.size() % m_stored_points.get_memory_usage() % calculate_element_size() % m_stored_points_sorted);
 }
 
 std::multimap<id_timecode_t, uint64_t>
@@ -179,14 +262,16 @@ cues_c::postprocess_cues(KaxCues &cues,
                          KaxCluster &cluster) {
   add(cues);
 
-  if (m_no_cue_duration && m_no_cue_relative_position)
+  if (m_no_cue_duration && m_no_cue_relative_position) {
+    store_pending_points();
     return;
+  }
 
   auto cluster_data_start_pos = cluster.GetElementPosition() + cluster.HeadSize();
   auto block_positions        = calculate_block_positions(cluster);
   std::map<id_timecode_t, size_t> nblocks_processed; //# blocks processed so far with given track #/timecode
 
-  for (auto point = m_points.begin() + m_num_cue_points_postprocessed, end = m_points.end(); point != end; ++point) {
+  for (auto point = m_pending_points.begin(), end = m_pending_points.end(); point != end; ++point) {
     nblocks_processed[id_timecode_t{ point->track_num, point->timecode }]++;
 
     // Set CueRelativePosition for all cues.
@@ -235,15 +320,20 @@ cues_c::postprocess_cues(KaxCues &cues,
                % point->track_num % point->timecode % (duration_itr == m_id_timecode_duration_multimap.end() ? static_cast<int64_t>(-1) : duration_itr->second));
   }
 
-  m_num_cue_points_postprocessed = m_points.size();
+  store_pending_points();
 
   m_id_timecode_duration_multimap.clear();
 }
 
 uint64_t
-cues_c::calculate_total_size()
+cues_c::calculate_element_size()
   const {
-  return boost::accumulate(m_points, 0ull, [this](uint64_t sum, cue_point_t const &point) { return sum + calculate_point_size(point); });
+  if (m_stored_points.empty() && m_pending_points.empty())
+    return 0;
+
+  auto content_size = boost::accumulate(m_pending_points, m_stored_points_size, [this](uint64_t sum, cue_point_t const &point) { return sum + calculate_point_size(point); });
+
+  return EBML_ID_LENGTH(EBML_ID(KaxCues)) + CodedSizeLength(content_size, 0) + content_size;
 }
 
 uint64_t
@@ -264,9 +354,8 @@ cues_c::calculate_point_size(cue_point_t const &point)
                       + EBML_ID_LENGTH(EBML_ID(KaxCueTrack))           + 1 + calculate_bytes_for_uint(point.track_num)
                       + EBML_ID_LENGTH(EBML_ID(KaxCueClusterPosition)) + 1 + calculate_bytes_for_uint(point.cluster_position);
 
-  auto codec_state_position = m_codec_state_position_map.find({ point.track_num, point.timecode });
-  if (codec_state_position != m_codec_state_position_map.end())
-    point_size += EBML_ID_LENGTH(EBML_ID(KaxCueCodecState)) + 1 + calculate_bytes_for_uint(codec_state_position->second);
+  if (point.codec_state_position)
+    point_size += EBML_ID_LENGTH(EBML_ID(KaxCueCodecState)) + 1 + calculate_bytes_for_uint(point.codec_state_position);
 
   if (point.relative_position)
     point_size += EBML_ID_LENGTH(EBML_ID(KaxCueRelativePosition)) + 1 + calculate_bytes_for_uint(point.relative_position);
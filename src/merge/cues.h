@@ -20,27 +20,58 @@
 #include <matroska/KaxCuesData.h>
 #include <matroska/KaxSeekHead.h>
 
+#include "common/delta_coded_vector.h"
 #include "common/mm_io.h"
 
 typedef std::pair<uint64_t, uint64_t> id_timecode_t;
 
 struct cue_point_t {
-  uint64_t timecode, duration, cluster_position;
+  uint64_t timecode, duration, cluster_position, codec_state_position;
   uint32_t track_num, relative_position;
 };
 
+// Keeps finished cue points in a compact form. Each field is stored
+// in a delta coded vector of its own. As cue points are appended in
+// ascending order for the most part, the differences and therefore
+// the storage needed per point are small.
+class cue_point_store_c {
+protected:
+  delta_coded_vector_c m_timecodes, m_durations, m_cluster_positions, m_codec_state_positions, m_track_nums, m_relative_positions;
+
+public:
+  void push_back(cue_point_t const &point);
+  cue_point_t at(size_t idx) const;
+  cue_point_t operator [](size_t idx) const {
+    return at(idx);
+  }
+
+  size_t size() const {
+    return m_timecodes.size();
+  }
+  bool empty() const {
+    return m_timecodes.empty();
+  }
+
+  void clear();
+  size_t get_memory_usage() const;
+};
+
 class cues_c;
 typedef std::shared_ptr<cues_c> cues_cptr;
 
 class cues_c {
 protected:
-  std::vector<cue_point_t> m_points;
+  // Points are collected in m_pending_points until the cluster they
+  // refer to has been rendered and their relative positions and
+  // durations are known. Then they're moved to m_stored_points.
+  std::vector<cue_point_t> m_pending_points;
+  cue_point_store_c m_stored_points;
   std::multimap<id_timecode_t, uint64_t> m_id_timecode_duration_multimap;
-  std::map<id_timecode_t, uint64_t> m_codec_state_position_map;
 
-  size_t m_num_cue_points_postprocessed;
+  uint64_t m_stored_points_size;
+  bool m_stored_points_sorted;
   bool m_no_cue_duration, m_no_cue_relative_position;
-  debugging_option_c m_debug_cue_duration, m_debug_cue_relative_position;
+  debugging_option_c m_debug_cue_duration, m_debug_cue_relative_position, m_debug_cue_storage;
 
 protected:
   static cues_cptr s_cues;
@@ -54,13 +85,17 @@ public:
   void postprocess_cues(KaxCues &cues, KaxCluster &cluster);
   void set_duration_for_id_timecode(uint64_t id, uint64_t timecode, uint64_t duration);
 
+  // Size of the complete Cues element including its head if it was
+  // written now. It is updated with each cluster rendered.
+  uint64_t calculate_element_size() const;
+
 public:
   static cues_c &get();
 
 protected:
-  void sort();
+  void store_pending_points();
+  void write_point(mm_io_c &out, cue_point_t const &point) const;
   std::multimap<id_timecode_t, uint64_t> calculate_block_positions(KaxCluster &cluster) const;
-  uint64_t calculate_total_size() const;
   uint64_t calculate_point_size(cue_point_t const &point) const;
   uint64_t calculate_bytes_for_uint(uint64_t value) const;
 };
@@ -985,26 +985,8 @@ generic_packetizer_c::apply_factory_short_queueing(packet_cptr_di &p_start) {
   }
 }
 
-struct packet_sorter_t {
-  int m_index;
-  static std::deque<packet_cptr> *m_packet_queue;
-
-  packet_sorter_t(int index)
-    : m_index(index)
-  {
-  }
-
-  bool operator <(const packet_sorter_t &cmp) const {
-    return (*m_packet_queue)[m_index]->timecode < (*m_packet_queue)[cmp.m_index]->timecode;
-  }
-};
-
-std::deque<packet_cptr> *packet_sorter_t::m_packet_queue = nullptr;
-
 void
 generic_packetizer_c::apply_factory_full_queueing(packet_cptr_di &p_start) {
-  packet_sorter_t::m_packet_queue = &m_packet_queue;
-
   while (m_packet_queue.end() != p_start) {
     // Find the next I frame packet.
     packet_cptr_di p_end = p_start + 1;
@@ -1018,25 +1000,28 @@ generic_packetizer_c::apply_factory_full_queueing(packet_cptr_di &p_start) {
 
     // Now sort the frames by their timecode as the factory has to be
     // applied to the packets in the same order as they're timestamped.
-    std::vector<packet_sorter_t> sorter;
+    // The packets are sorted via their indexes within this
+    // packetizer's queue. Nothing is shared with other packetizers
+    // which may be doing the same in other threads.
+    std::vector<size_t> sorter;
     bool needs_sorting        = false;
     int64_t previous_timecode = 0;
     size_t i                  = distance(m_packet_queue.begin(), p_start);
 
     packet_cptr_di p_current;
     for (p_current = p_start; p_current != p_end; ++i, ++p_current) {
-      sorter.push_back(packet_sorter_t(i));
+      sorter.push_back(i);
       if (m_packet_queue[i]->timecode < previous_timecode)
         needs_sorting = true;
       previous_timecode = m_packet_queue[i]->timecode;
     }
 
     if (needs_sorting)
-      std::sort(sorter.begin(), sorter.end());
+      std::sort(sorter.begin(), sorter.end(), [this](size_t a, size_t b) { return m_packet_queue[a]->timecode < m_packet_queue[b]->timecode; });
 
     // Finally apply the factory.
-    for (i = 0; sorter.size() > i; ++i)
-      apply_factory_once(m_packet_queue[sorter[i].m_index]);
+    for (auto idx : sorter)
+      apply_factory_once(m_packet_queue[idx]);
 
     p_start = p_end;
   }
@@ -103,7 +103,7 @@ public:
   virtual file_status_e read();
 
   inline void add_packet(packet_t *packet) {
-    add_packet(packet_cptr(packet));
+    add_packet(packet_t::take(packet));
   }
   virtual void add_packet(packet_cptr packet);
   virtual void add_packet2(packet_cptr pack);
@@ -132,7 +132,7 @@ public:
   virtual void set_headers();
   virtual void fix_headers();
   inline int process(packet_t *packet) {
-    return process(packet_cptr(packet));
+    return process(packet_t::take(packet));
   }
   virtual int process(packet_cptr packet) = 0;
 
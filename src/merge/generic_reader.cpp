@@ -128,6 +128,29 @@ generic_reader_c::attachment_requested(int64_t id) {
   return ATTACH_MODE_SKIP;
 }
 
+/** \brief Add an attachment found in the file
+
+   While identifying the attachment is only kept by the reader: with
+   '--identify-batch' several files are identified at the same time,
+   and each file's results must only list its own attachments.
+   Otherwise it's added to the attachments that will be written.
+*/
+void
+generic_reader_c::add_attachment_from_file(attachment_t const &attachment) {
+  if (g_identifying)
+    m_identified_attachments.push_back(attachment);
+  else
+    add_attachment(attachment);
+}
+
+/** \brief The ID after which attachments found in subtitle files are numbered
+*/
+int64_t
+generic_reader_c::get_attachment_id_base()
+  const {
+  return g_identifying ? m_identified_attachments.size() : g_attachments.size();
+}
+
 int
 generic_reader_c::add_packetizer(generic_packetizer_c *ptzr) {
   if (outputting_webm() && !ptzr->is_compatible_with(OC_WEBM))
@@ -20,6 +20,7 @@
 
 #include "common/chapters/chapters.h"
 #include "common/translation.h"
+#include "merge/attachment.h"
 #include "merge/file_status.h"
 #include "merge/id_result.h"
 #include "merge/packet.h"
@@ -67,6 +68,10 @@ protected:
 
   timecode_c m_restricted_timecodes_min, m_restricted_timecodes_max;
 
+  // Attachments found in the file while identifying it. See
+  // add_attachment_from_file().
+  std::vector<attachment_t> m_identified_attachments;
+
 public:
   generic_reader_c(const track_info_c &ti, const mm_io_cptr &in);
   virtual ~generic_reader_c();
@@ -112,12 +117,20 @@ public:
   virtual bool is_simple_subtitle_container() {
     return false;
   }
+  // Positions the reader so that reading continues in front of the
+  // given timecode. Only called before the first packet is read.
+  // Returns false if the reader doesn't support it.
+  virtual bool seek_to_timecode(int64_t /* timecode */) {
+    return false;
+  }
 
   virtual file_status_e flush_packetizer(int num);
   virtual file_status_e flush_packetizer(generic_packetizer_c *ptzr);
   virtual file_status_e flush_packetizers();
 
   virtual attach_mode_e attachment_requested(int64_t id);
+  virtual void add_attachment_from_file(attachment_t const &attachment);
+  virtual int64_t get_attachment_id_base() const;
 
   virtual void display_identification_results();
 
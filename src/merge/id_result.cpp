@@ -14,16 +14,34 @@
 #include "merge/id_result.h"
 #include "merge/output_control.h"
 
+// Several files are identified at the same time in batch mode. The
+// message is only recorded for the file the current thread is
+// handling then instead of terminating the program.
+static thread_local std::string s_unsupported_container_message;
+
 void
 id_result_container_unsupported(const std::string &filename,
                                 const std::string &info) {
   if (g_identifying) {
-    if (g_identify_for_mmg)
-      mxinfo(boost::format("File '%1%': unsupported container: %2%\n") % filename % info);
-    else
-      mxinfo(boost::format(Y("File '%1%': unsupported container: %2%\n")) % filename % info);
+    auto message = g_identify_for_mmg ? (boost::format("File '%1%': unsupported container: %2%\n")     % filename % info).str()
+                 :                      (boost::format(Y("File '%1%': unsupported container: %2%\n")) % filename % info).str();
+
+    if (g_identify_batch) {
+      s_unsupported_container_message = message;
+      return;
+    }
+
+    mxinfo(message);
     mxexit(3);
 
   } else
     mxerror(boost::format(Y("The file '%1%' is a non-supported file type (%2%).\n")) % filename % info);
 }
+
+std::string
+id_result_fetch_unsupported_container() {
+  auto message = s_unsupported_container_message;
+  s_unsupported_container_message.clear();
+
+  return message;
+}
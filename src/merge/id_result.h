@@ -59,5 +59,6 @@ struct id_result_t {
 };
 
 void id_result_container_unsupported(const std::string &filename, const std::string &info);
+std::string id_result_fetch_unsupported_container();
 
 #endif  // MTX_MERGE_ID_RESULT_H
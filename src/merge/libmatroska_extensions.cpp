@@ -16,6 +16,7 @@
 
 #include <cassert>
 
+#include "common/endian.h"
 #include "merge/libmatroska_extensions.h"
 
 kax_reference_block_c::kax_reference_block_c():
@@ -33,6 +34,70 @@ kax_reference_block_c::UpdateSize(bool bSaveDefault,
   return EbmlSInteger::UpdateSize(bSaveDefault, bForceRender);
 }
 
+kax_direct_simple_block_c::kax_direct_simple_block_c(memory_cptr const &data,
+                                                     uint16 track_number,
+                                                     uint64 timecode)
+  : KaxSimpleBlock()
+  , m_data{data}
+{
+  // The values with all bits set are reserved for both one and two
+  // byte long EBML coded integers.
+  assert(track_number < 0x3fff);
+
+  Timecode    = timecode;
+  TrackNumber = track_number;
+  mLacing     = LACING_NONE;
+
+  SetValueIsSet();
+}
+
+size_t
+kax_direct_simple_block_c::get_header_size()
+  const {
+  // Track number as an EBML coded integer, the relative timecode and
+  // the flags.
+  return (0x7f > TrackNumber ? 1 : 2) + 2 + 1;
+}
+
+filepos_t
+kax_direct_simple_block_c::UpdateSize(bool /* bSaveDefault */,
+                                      bool /* bForceRender */) {
+  SetSize_(get_header_size() + m_data->get_size());
+  return GetSize();
+}
+
+filepos_t
+kax_direct_simple_block_c::RenderData(IOCallback &output,
+                                      bool /* bForceRender */,
+                                      bool /* bSaveDefault */) {
+  assert(ParentCluster);
+
+  unsigned char header[5];
+  auto idx = 0u;
+
+  if (0x7f > TrackNumber)
+    header[idx++] = 0x80 | TrackNumber;
+  else {
+    header[idx++] = 0x40 | (TrackNumber >> 8);
+    header[idx++] = TrackNumber & 0xff;
+  }
+
+  LocalTimecode      = ParentCluster->GetBlockLocalTimecode(Timecode);
+  bLocalTimecodeUsed = true;
+
+  put_uint16_be(&header[idx], static_cast<uint16_t>(LocalTimecode));
+  idx += 2;
+
+  header[idx++] = (IsKeyframe() ? 0x80 : 0x00) | (IsDiscardable() ? 0x01 : 0x00);
+
+  output.writeFully(header, idx);
+  output.writeFully(m_data->get_buffer(), m_data->get_size());
+
+  SetSize_(idx + m_data->get_size());
+
+  return GetSize();
+}
+
 bool
 kax_block_group_c::add_frame(const KaxTrackEntry &track,
                              uint64 timecode,
@@ -71,6 +136,25 @@ kax_block_group_c::add_frame(const KaxTrackEntry &track,
   return result;
 }
 
+static void
+set_simple_block_flags(KaxSimpleBlock &block,
+                       uint64 timecode,
+                       int64_t past_block,
+                       int64_t forw_block) {
+  if ((-1 == past_block) && (-1 == forw_block)) {
+    block.SetKeyframe(true);
+    block.SetDiscardable(false);
+
+  } else {
+    block.SetKeyframe(false);
+    if (   ((-1 == forw_block) || (forw_block <= static_cast<int64_t>(timecode)))
+        && ((-1 == past_block) || (past_block <= static_cast<int64_t>(timecode))))
+      block.SetDiscardable(false);
+    else
+      block.SetDiscardable(true);
+  }
+}
+
 bool
 kax_block_blob_c::add_frame_auto(const KaxTrackEntry &track,
                                  uint64 timecode,
@@ -91,18 +175,7 @@ kax_block_blob_c::add_frame_auto(const KaxTrackEntry &track,
     }
 
     result = Block.simpleblock->AddFrame(track, timecode, buffer, lacing);
-    if ((-1 == past_block) && (-1 == forw_block)) {
-      Block.simpleblock->SetKeyframe(true);
-      Block.simpleblock->SetDiscardable(false);
-
-    } else {
-      Block.simpleblock->SetKeyframe(false);
-      if (   ((-1 == forw_block) || (forw_block <= static_cast<int64_t>(timecode)))
-          && ((-1 == past_block) || (past_block <= static_cast<int64_t>(timecode))))
-        Block.simpleblock->SetDiscardable(false);
-      else
-        Block.simpleblock->SetDiscardable(true);
-    }
+    set_simple_block_flags(*Block.simpleblock, timecode, past_block, forw_block);
 
   } else if (replace_simple_by_group()) {
     kax_block_group_c *group = static_cast<kax_block_group_c *>(Block.group);
@@ -112,6 +185,26 @@ kax_block_blob_c::add_frame_auto(const KaxTrackEntry &track,
   return result;
 }
 
+bool
+kax_block_blob_c::can_add_frame_directly()
+  const {
+  return (BLOCK_BLOB_ALWAYS_SIMPLE == SimpleBlockMode) && !Block.simpleblock;
+}
+
+void
+kax_block_blob_c::add_frame_directly(memory_cptr const &data,
+                                     uint16 track_number,
+                                     uint64 timecode,
+                                     int64_t past_block,
+                                     int64_t forw_block) {
+  assert(can_add_frame_directly());
+
+  Block.simpleblock = new kax_direct_simple_block_c(data, track_number, timecode);
+  Block.simpleblock->SetParent(*ParentCluster);
+
+  set_simple_block_flags(*Block.simpleblock, timecode, past_block, forw_block);
+}
+
 bool
 kax_block_blob_c::replace_simple_by_group() {
   if (BLOCK_BLOB_ALWAYS_SIMPLE == SimpleBlockMode)
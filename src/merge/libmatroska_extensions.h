@@ -73,12 +73,31 @@ public:
   bool add_frame(const KaxTrackEntry &track, uint64 timecode, DataBuffer &buffer, int64_t past_block, int64_t forw_block, LacingType lacing);
 };
 
+// A SimpleBlock containing a single frame without lacing. The frame
+// is not wrapped in a DataBuffer but written straight from the
+// packet's memory when the block is rendered.
+class kax_direct_simple_block_c: public KaxSimpleBlock {
+protected:
+  memory_cptr m_data;
+
+public:
+  kax_direct_simple_block_c(memory_cptr const &data, uint16 track_number, uint64 timecode);
+
+  virtual filepos_t UpdateSize(bool bSaveDefault = false, bool bForceRender = false);
+  virtual filepos_t RenderData(IOCallback &output, bool bForceRender, bool bSaveDefault = false);
+
+protected:
+  size_t get_header_size() const;
+};
+
 class kax_block_blob_c: public KaxBlockBlob {
 public:
   kax_block_blob_c(BlockBlobType type): KaxBlockBlob(type) {
   }
 
   bool add_frame_auto(const KaxTrackEntry &track, uint64 timecode, DataBuffer &buffer, LacingType lacing, int64_t past_block, int64_t forw_block);
+  bool can_add_frame_directly() const;
+  void add_frame_directly(memory_cptr const &data, uint16 track_number, uint64 timecode, int64_t past_block, int64_t forw_block);
   void set_block_duration(uint64_t time_length);
   bool replace_simple_by_group();
 };
@@ -31,9 +31,13 @@
 #endif
 
 #include <algorithm>
+#include <condition_variable>
+#include <deque>
 #include <iostream>
 #include <list>
+#include <mutex>
 #include <sstream>
+#include <thread>
 #include <tuple>
 #include <typeinfo>
 
@@ -52,6 +56,7 @@
 #include "common/iso639.h"
 #include "common/mm_io.h"
 #include "common/mm_io_x.h"
+#include "common/mm_mmap_io.h"
 #include "common/segmentinfo.h"
 #include "common/split_arg_parsing.h"
 #include "common/strings/formatting.h"
@@ -64,6 +69,7 @@
 #include "merge/cluster_helper.h"
 #include "merge/generic_reader.h"
 #include "merge/output_control.h"
+#include "merge/split_jobs.h"
 #include "merge/track_info.h"
 
 using namespace libmatroska;
@@ -110,12 +116,21 @@ set_usage() {
                   "                           put at most n milliseconds of data into each\n"
                   "                           cluster.\n");
   usage_text += Y("  --no-cues                Do not write the cue data (the index).\n");
+  usage_text += Y("  --cues-at-front <size>   Reserve size bytes in front of the first cluster\n"
+                  "                           and write the cues there if they fit.\n");
   usage_text += Y("  --clusters-in-meta-seek  Write meta seek data for clusters.\n");
+  usage_text += Y("  --cluster-crc32          Write a CRC-32 element into each cluster.\n");
   usage_text += Y("  --disable-lacing         Do not Use lacing.\n");
   usage_text += Y("  --enable-durations       Enable block durations for all blocks.\n");
   usage_text += Y("  --timecode-scale <n>     Force the timecode scale factor to n.\n");
   usage_text += Y("  --disable-track-statistics-tags\n"
                   "                           Do not write tags with track statistics.\n");
+  usage_text += Y("  --threads <n>            Read and packetize the input files in n\n"
+                  "                           background threads.\n");
+  usage_text += Y("  --memory-map-input <never|auto|always>\n"
+                  "                           Whether or not to access input files via\n"
+                  "                           memory mapping. 'auto' only maps big files.\n"
+                  "                           Default: 'never'.\n");
   usage_text +=   "\n";
   usage_text += Y(" File splitting, linking, appending and concatenating (more global options):\n");
   usage_text += Y("  --split <d[K,M,G]|HH:MM:SS|s>\n"
@@ -138,6 +153,9 @@ set_usage() {
                   "                           Create a new file before each chapter (with 'all')\n"
                   "                           or before chapter numbers A, B etc.\n");
   usage_text += Y("  --split-max-files <n>    Create at most n files.\n");
+  usage_text += Y("  --split-jobs <n>         Create up to n of the files at the same time\n"
+                  "                           in separate processes. Only for 'timecodes:'\n"
+                  "                           and 'parts:'.\n");
   usage_text += Y("  --link                   Link splitted files.\n");
   usage_text += Y("  --link-to-previous <SID> Link the first file to the given SID.\n");
   usage_text += Y("  --link-to-next <SID>     Link the last file to the given SID.\n");
@@ -267,6 +285,9 @@ set_usage() {
   usage_text +=   "\n\n";
   usage_text += Y(" Other options:\n");
   usage_text += Y("  -i, --identify <file>    Print information about the source file.\n");
+  usage_text += Y("  --identify-batch <list>  Print information about all source files\n"
+                  "                           listed in the file 'list' (one per line,\n"
+                  "                           '-' for the standard input).\n");
   usage_text += Y("  -l, --list-types         Lists supported input file types.\n");
   usage_text += Y("  --list-languages         Lists all ISO639 languages and their\n"
                   "                           ISO639-2 codes.\n");
@@ -362,26 +383,23 @@ list_file_types() {
     mxinfo(boost::format("  %1% [%2%]\n") % file_type.title % file_type.extensions);
 }
 
-/** \brief Identify a file type and its contents
+/** \brief Probe a file for identification
 
-   This function called for \c --identify. It sets up dummy track info
-   data for the reader, probes the input file, creates the file reader
-   and calls its identify function.
+   Sets up dummy track info data for the reader and probes the input
+   file. A leading '=' in \c filename disables the detection of
+   additional files belonging to the same title.
 */
 static void
-identify(std::string &filename) {
+probe_file_for_identification(filelist_t &file,
+                              std::string filename) {
   track_info_c ti;
-  filelist_t file;
 
   if ('=' == filename[0]) {
     ti.m_disable_multi_file = true;
     filename                = filename.substr(1);
   }
 
-  verbose             = 0;
-  g_suppress_warnings = true;
-  g_identifying       = true;
-  file.name           = filename;
+  file.name = filename;
   file.all_names.push_back(filename);
 
   get_file_type(file);
@@ -394,6 +412,22 @@ identify(std::string &filename) {
             % file.name);
 
   file.ti = new track_info_c(ti);
+}
+
+/** \brief Identify a file type and its contents
+
+   This function called for \c --identify. It probes the input file,
+   creates the file reader and calls its identify function.
+*/
+static void
+identify(std::string &filename) {
+  filelist_t file;
+
+  verbose             = 0;
+  g_suppress_warnings = true;
+  g_identifying       = true;
+
+  probe_file_for_identification(file, filename);
 
   g_files.push_back(file);
 
@@ -403,6 +437,246 @@ identify(std::string &filename) {
   g_files[0].reader->display_identification_results();
 }
 
+struct batch_identification_job_t {
+  std::string file_name, unsupported_container, error;
+  filelist_t file;
+  bool done;
+
+  batch_identification_job_t(std::string const &p_file_name)
+    : file_name{p_file_name}
+    , done{}
+  {
+  }
+};
+
+static void
+identify_for_batch(batch_identification_job_t &job) {
+  try {
+    probe_file_for_identification(job.file, job.file_name);
+    create_reader(job.file);
+    job.file.reader->identify();
+
+  } catch (mtx::exception &ex) {
+    job.error = ex.error();
+
+  } catch (std::exception &ex) {
+    job.error = ex.what();
+
+  } catch (...) {
+    job.error = (boost::format(Y("File '%1%' could not be identified.\n")) % job.file_name).str();
+  }
+
+  if (!job.error.empty() && !balg::ends_with(job.error, "\n"))
+    job.error += "\n";
+
+  // A probe function or the reader may have found an unsupported
+  // container and carried on. Its message takes precedence.
+  job.unsupported_container = id_result_fetch_unsupported_container();
+  if (!job.unsupported_container.empty())
+    job.error.clear();
+
+  if (job.file.reader && (!job.error.empty() || !job.unsupported_container.empty())) {
+    delete job.file.reader;
+    job.file.reader = nullptr;
+  }
+}
+
+/** \brief Identify many files with a single process
+
+   This function is called for \c --identify-batch. The names of the
+   files to identify are read from a list file, one per line, or from
+   the standard input if the list file's name is '-'.
+
+   The list is read by a separate thread that queues each file name as
+   soon as its line has arrived. Programs can therefore keep the
+   standard input open and feed file names one by one, receiving each
+   file's results without having to close the list first.
+
+   The files are probed and their readers created by several worker
+   threads at the same time. The main thread outputs the results in
+   the order the files were listed in as soon as they're available.
+   Workers only ever run a limited number of files ahead of the
+   output so that neither memory nor file handles pile up.
+
+   A file that cannot be identified doesn't abort the whole run. Its
+   error message is output instead of its results, and the exit code
+   is 2 if this happened for at least one file.
+*/
+static void
+identify_batch(std::vector<std::string> const &args) {
+  std::string list_file_name;
+  int num_threads = 0;
+
+  for (auto idx = 0u; idx < args.size(); ++idx) {
+    auto const &this_arg = args[idx];
+    auto no_next_arg     = (idx + 1) >= args.size();
+
+    if (this_arg == "--identify-batch") {
+      if (no_next_arg)
+        mxerror(boost::format(Y("'%1%' lacks a file name.\n")) % this_arg);
+      list_file_name = args[++idx];
+
+    } else if ((this_arg == "--identify-verbose") || (this_arg == "-I"))
+      g_identify_verbose = true;
+
+    else if (this_arg == "--threads") {
+      if (no_next_arg)
+        mxerror(boost::format(Y("'%1%' lacks its argument.\n")) % this_arg);
+
+      if (!parse_number(args[++idx], num_threads) || (0 >= num_threads))
+        mxerror(boost::format(Y("Invalid number of threads '%1%'.\n")) % args[idx]);
+
+    } else
+      mxerror(boost::format(Y("'%1%' cannot be used together with '--identify-batch'.\n")) % this_arg);
+  }
+
+  verbose             = 0;
+  g_suppress_warnings = true;
+  g_identifying       = true;
+  g_identify_batch    = true;
+
+  std::unique_ptr<mm_text_io_c> list_file;
+  if (list_file_name != "-") {
+    try {
+      list_file.reset(new mm_text_io_c(new mm_file_io_c(list_file_name)));
+    } catch (mtx::mm_io::exception &ex) {
+      mxerror(boost::format(Y("The file '%1%' could not be opened for reading: %2%.\n")) % list_file_name % ex);
+    }
+  }
+
+  if (!num_threads)
+    num_threads = std::max(std::thread::hardware_concurrency(), 1u);
+
+  // Jobs are appended by the list reader and removed from the front
+  // once they've been output. A deque keeps references to the
+  // remaining jobs valid while the workers are busy with them. The
+  // job number n is found at jobs[n - num_output].
+  std::mutex mutex;
+  std::condition_variable cond;
+  auto jobs       = std::deque<batch_identification_job_t>{};
+  auto input_done = false;
+  auto max_ahead  = static_cast<size_t>(num_threads) * 4;
+  auto next_job   = size_t{};
+  auto num_output = size_t{};
+
+  auto list_reader = [&]() {
+    auto getline = [&list_file](std::string &line) -> bool {
+      if (!list_file)
+        return !!std::getline(std::cin, line);
+
+      try {
+        return list_file->getline2(line);
+      } catch (mtx::mm_io::exception &) {
+        return false;
+      }
+    };
+
+    std::string line;
+
+    while (getline(line)) {
+      strip(line);
+      if (line.empty())
+        continue;
+
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        jobs.emplace_back(line);
+      }
+
+      cond.notify_all();
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      input_done = true;
+    }
+
+    cond.notify_all();
+  };
+
+  auto worker = [&]() {
+    // Errors must not terminate the program. Throwing unwinds to
+    // identify_for_batch() instead.
+    throw_on_mxerror_c throw_on_mxerror;
+
+    while (true) {
+      batch_identification_job_t *job{};
+
+      {
+        std::unique_lock<std::mutex> lock(mutex);
+        cond.wait(lock, [&]() {
+          auto available = next_job < (num_output + jobs.size());
+          return (input_done && !available) || (available && ((next_job - num_output) < max_ahead));
+        });
+
+        if (next_job >= (num_output + jobs.size()))
+          return;
+
+        job = &jobs[next_job - num_output];
+        ++next_job;
+      }
+
+      identify_for_batch(*job);
+
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        job->done = true;
+      }
+
+      cond.notify_all();
+    }
+  };
+
+  auto threads = std::vector<std::thread>{};
+  threads.emplace_back(list_reader);
+  for (auto idx = 0; idx < num_threads; ++idx)
+    threads.emplace_back(worker);
+
+  auto num_failed = 0u;
+
+  while (true) {
+    batch_identification_job_t *job{};
+
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      cond.wait(lock, [&]() { return (input_done && jobs.empty()) || (!jobs.empty() && jobs.front().done); });
+
+      if (jobs.empty())
+        break;
+
+      job = &jobs.front();
+    }
+
+    if (job->file.reader) {
+      job->file.reader->display_identification_results();
+      delete job->file.reader;
+
+    } else {
+      ++num_failed;
+
+      if (!job->unsupported_container.empty())
+        mxinfo(job->unsupported_container);
+      else
+        mxmsg(MXMSG_ERROR, job->error);
+    }
+
+    delete job->file.ti;
+
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      jobs.pop_front();
+      ++num_output;
+    }
+
+    cond.notify_all();
+  }
+
+  for (auto &thread : threads)
+    thread.join();
+
+  mxexit(num_failed ? 2 : 0);
+}
+
 /** \brief Parse a number postfixed with a time-based unit
 
    This function parsers a number that is postfixed with one of the
@@ -919,6 +1193,38 @@ parse_arg_split_size(const std::string &arg) {
   g_cluster_helper->add_split_point(split_point_c(split_after * modifier, split_point_c::size, false));
 }
 
+/** \brief Parse the size given to \c --cues-at-front
+
+  The size can be postfixed with 'k', 'm' or 'g'.
+*/
+static void
+parse_arg_cues_at_front(const std::string &arg) {
+  std::string s = arg;
+
+  if (s.empty())
+    mxerror(boost::format(Y("Invalid size in '--cues-at-front %1%'.\n")) % arg);
+
+  char mod         = tolower(s[s.length() - 1]);
+  int64_t modifier = 1;
+  if ('k' == mod)
+    modifier = 1024;
+  else if ('m' == mod)
+    modifier = 1024 * 1024;
+  else if ('g' == mod)
+    modifier = 1024 * 1024 * 1024;
+  else if (!isdigit(mod))
+    mxerror(boost::format(Y("Invalid size in '--cues-at-front %1%'.\n")) % arg);
+
+  if (1 != modifier)
+    s.erase(s.size() - 1);
+
+  int64_t size = 0;
+  if (!parse_number(s, size) || (0 > size))
+    mxerror(boost::format(Y("Invalid size in '--cues-at-front %1%'.\n")) % arg);
+
+  g_cues_at_front_size = size * modifier;
+}
+
 /** \brief Parse the \c --split argument
 
    The \c --split option takes several formats.
@@ -1783,6 +2089,11 @@ parse_common_args(std::vector<std::string> args) {
 
 static void
 parse_args(std::vector<std::string> args) {
+  // Batch identification only allows a couple of options that
+  // influence it.
+  if (std::find(args.begin(), args.end(), "--identify-batch") != args.end())
+    identify_batch(args);
+
   // Check if only information about the file is wanted. In this mode only
   // two parameters are allowed: the --identify switch and the file.
   if ((   (2 == args.size())
@@ -1925,6 +2236,15 @@ parse_args(std::vector<std::string> args) {
 
       sit++;
 
+    } else if (this_arg == "--split-jobs") {
+      if (no_next_arg)
+        mxerror(boost::format(Y("'%1%' lacks its argument.\n")) % this_arg);
+
+      if (!parse_number(next_arg, g_num_split_jobs) || (1 > g_num_split_jobs))
+        mxerror(boost::format(Y("Invalid number of jobs '%1%'.\n")) % next_arg);
+
+      sit++;
+
     } else if (this_arg == "--link") {
       g_no_linking = false;
 
@@ -1959,9 +2279,19 @@ parse_args(std::vector<std::string> args) {
     } else if (this_arg == "--no-cues")
       g_write_cues = false;
 
-    else if (this_arg == "--clusters-in-meta-seek")
+    else if (this_arg == "--cues-at-front") {
+      if (no_next_arg)
+        mxerror(boost::format(Y("'%1%' lacks its argument.\n")) % this_arg);
+
+      parse_arg_cues_at_front(next_arg);
+      sit++;
+
+    } else if (this_arg == "--clusters-in-meta-seek")
       g_write_meta_seek_for_clusters = true;
 
+    else if (this_arg == "--cluster-crc32")
+      g_write_cluster_crc32 = true;
+
     else if (this_arg == "--disable-lacing")
       g_no_lacing = true;
 
@@ -2086,6 +2416,30 @@ parse_args(std::vector<std::string> args) {
 
       parse_arg_timecode_scale(next_arg);
       sit++;
+
+    } else if (this_arg == "--threads") {
+      if (no_next_arg)
+        mxerror(boost::format(Y("'%1%' lacks its argument.\n")) % this_arg);
+
+      if (!parse_number(next_arg, g_num_reader_threads) || (0 > g_num_reader_threads))
+        mxerror(boost::format(Y("Invalid number of threads '%1%'.\n")) % next_arg);
+
+      sit++;
+
+    } else if (this_arg == "--memory-map-input") {
+      if (no_next_arg)
+        mxerror(boost::format(Y("'%1%' lacks its argument.\n")) % this_arg);
+
+      if (next_arg == "never")
+        mm_mmap_io_c::set_mode(mm_mmap_io_c::MODE_NEVER);
+      else if (next_arg == "auto")
+        mm_mmap_io_c::set_mode(mm_mmap_io_c::MODE_AUTO);
+      else if (next_arg == "always")
+        mm_mmap_io_c::set_mode(mm_mmap_io_c::MODE_ALWAYS);
+      else
+        mxerror(boost::format(Y("Invalid memory mapping mode '%1%'.\n")) % next_arg);
+
+      sit++;
     }
 
     // Options that apply to the next input file only.
@@ -2510,6 +2864,7 @@ main(int argc,
   auto args = setup(argc, argv);
 
   parse_args(args);
+  start_split_jobs();
 
   int64_t start = get_current_time_millis();
 
@@ -2526,6 +2881,7 @@ main(int argc,
     check_append_mapping();
     calc_attachment_sizes();
     calc_max_chapter_size();
+    position_readers_for_split_job();
   }
 
   // Finally parse the chapter splitting argument.
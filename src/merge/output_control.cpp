@@ -31,7 +31,10 @@
 #endif
 
 #include <boost/date_time/posix_time/posix_time.hpp>
+#include <atomic>
 #include <iostream>
+#include <queue>
+#include <thread>
 #include <typeinfo>
 
 #include <ebml/EbmlHead.h>
@@ -66,11 +69,15 @@
 #include "common/ebml.h"
 #include "common/fs_sys_helpers.h"
 #include "common/hacks.h"
+#include "common/hdsub.h"
 #include "common/math.h"
 #include "common/mm_io_x.h"
 #include "common/mm_mpls_multi_file_io.h"
+#include "common/mm_mmap_io.h"
+#include "common/mm_probe_io.h"
 #include "common/mm_read_buffer_io.h"
 #include "common/mm_write_buffer_io.h"
+#include "common/pgssup.h"
 #include "common/strings/formatting.h"
 #include "common/tags/tags.h"
 #include "common/translation.h"
@@ -116,6 +123,7 @@
 #include "merge/cues.h"
 #include "merge/input_x.h"
 #include "merge/output_control.h"
+#include "merge/reader_thread.h"
 #include "merge/webm.h"
 
 using namespace libmatroska;
@@ -150,8 +158,10 @@ int g_max_blocks_per_cluster                = 65535;
 int64_t g_max_ns_per_cluster                = 5000000000ll;
 bool g_write_cues                           = true;
 bool g_cue_writing_requested                = false;
+int64_t g_cues_at_front_size                = 0;
 generic_packetizer_c *g_video_packetizer    = nullptr;
 bool g_write_meta_seek_for_clusters         = false;
+bool g_write_cluster_crc32                  = false;
 bool g_no_lacing                            = false;
 bool g_no_linking                           = true;
 bool g_use_durations                        = false;
@@ -167,6 +177,7 @@ int g_default_tracks_priority[3]            = { 0, 0, 0, };
 bool g_identifying                          = false;
 bool g_identify_verbose                     = false;
 bool g_identify_for_mmg                     = false;
+bool g_identify_batch                       = false;
 
 KaxSegment *g_kax_segment                   = nullptr;
 KaxTracks *g_kax_tracks                     = nullptr;
@@ -194,10 +205,15 @@ int g_file_num = 1;
 
 int g_split_max_num_files                   = 65535;
 std::string g_splitting_by_chapters_arg;
+int g_num_split_jobs                        = 0;
 
 append_mode_e g_append_mode                 = APPEND_MODE_FILE_BASED;
 bool s_appending_files                      = false;
+
+int g_num_reader_threads                    = 0;
+bool g_show_progress                        = true;
 auto s_debug_appending                      = debugging_option_c{"append|appending"};
+auto s_debug_cues_at_front                  = debugging_option_c{"cues|cues_at_front"};
 auto s_debug_rerender_track_headers         = debugging_option_c{"rerender|rerender_track_headers"};
 
 bool g_stereo_mode_used                     = false;
@@ -220,6 +236,8 @@ static EbmlVoid *s_kax_sh_void              = nullptr;
 static EbmlVoid *s_kax_chapters_void        = nullptr;
 static int64_t s_max_chapter_size           = 0;
 static EbmlVoid *s_void_after_track_headers = nullptr;
+static EbmlVoid *s_kax_cues_void            = nullptr;
+static int64_t s_previous_cues_size         = 0;
 
 static mm_io_cptr s_out;
 
@@ -228,12 +246,40 @@ static bitvalue_c s_seguid_prev(128), s_seguid_current(128), s_seguid_next(128);
 static int s_display_files_done           = 0;
 static int s_display_path_length          = 1;
 static generic_reader_c *s_display_reader = nullptr;
+static reader_thread_c *s_display_reader_thread = nullptr;
 
 static EbmlHead *s_head                   = nullptr;
 
 static std::string s_muxing_app, s_writing_app;
 static boost::posix_time::ptime s_writing_date;
 
+static void render_cues();
+
+// Orders packetizers by the timecode of their pending packets, the
+// smallest one first. Ties are resolved by the packetizers' order in
+// g_packetizers.
+struct later_packet_first_t {
+  bool operator ()(packetizer_t const *a,
+                   packetizer_t const *b)
+    const {
+    if (a->pack->output_order_timecode == b->pack->output_order_timecode)
+      return a > b;
+    return b->pack->output_order_timecode < a->pack->output_order_timecode;
+  }
+};
+
+typedef std::priority_queue<packetizer_t *, std::vector<packetizer_t *>, later_packet_first_t> packetizer_heap_t;
+
+static packetizer_heap_t s_packetizers_by_timecode;
+static std::vector<packetizer_t *> s_packetizers_to_pull;
+static bool s_interleaver_needs_rebuild = true;
+static int64_t s_interleaver_num_packets = 0, s_interleaver_num_pulls = 0, s_interleaver_num_heap_operations = 0, s_interleaver_num_rebuilds = 0;
+static auto s_debug_interleaver = debugging_option_c{"interleaver"};
+
+static std::vector<reader_thread_cptr> s_reader_threads;
+static std::thread::id s_main_thread_id;
+static std::atomic<bool> s_track_headers_need_rerendering{false};
+
 /** \brief Add a segment family UID to the list if it doesn't exist already.
 
   \param family This segment family element is converted to a 128 bit
@@ -282,7 +328,7 @@ sighandler(int /* signum */) {
   mxinfo(Y("The file is being fixed, part 1/4..."));
   // Render the cues.
   if (g_write_cues && g_cue_writing_requested)
-    cues_c::get().write(*s_out, *g_kax_sh_main);
+    render_cues();
   mxinfo(Y(" done\n"));
 
   mxinfo(Y("The file is being fixed, part 2/4..."));
@@ -325,7 +371,10 @@ file_names_to_paths(const std::vector<std::string> &file_names) {
 static mm_io_cptr
 open_input_file(filelist_t &file) {
   try {
-    if (file.all_names.size() == 1)
+    if ((file.all_names.size() == 1) && mm_mmap_io_c::should_be_used_for(file.name))
+      return mm_io_cptr(new mm_mmap_io_c(file.name));
+
+    else if (file.all_names.size() == 1)
       return mm_io_cptr(new mm_read_buffer_io_c(new mm_file_io_c(file.name), 1 << 17));
 
     else {
@@ -390,6 +439,10 @@ detect_text_file_formats(filelist_t const &file) {
 
    Opens the input file and calls the \c probe_file function for each known
    file reader class. Uses \c mm_text_io_c for subtitle probing.
+
+   The start of the file is read only once and kept in memory by
+   \c mm_probe_io_c. The probes for file types with a fixed signature at
+   the start of the file are only called if that signature is present.
 */
 static std::pair<file_type_e, int64_t>
 get_file_type_internal(filelist_t &file) {
@@ -401,46 +454,61 @@ get_file_type_internal(filelist_t &file) {
   if (is_playlist)
     io = file.playlist_mpls_in.get();
 
+  // Files with a signature are usually detected within the first few
+  // KB. The cache grows up to the largest amount read from the start
+  // by the probes that are run for the other files (the MP3/AC-3/AAC
+  // and the elementary stream probes).
+  mm_probe_io_c probe_io{io, 128 * 1024, false, 1024 * 1024};
+  io = &probe_io;
+
+  auto const &head = probe_io.get_head();
+  auto magic16     =  2 <= head.get_size() ? get_uint16_be(head.get_buffer())     : 0u;
+  auto magic32     =  4 <= head.get_size() ? get_uint32_be(head.get_buffer())     : 0u;
+  auto magic32_2   = 12 <= head.get_size() ? get_uint32_be(head.get_buffer() + 8) : 0u;
+  auto is_riff     = FOURCC('R', 'I', 'F', 'F') == magic32;
+
   file_type_e type = FILE_TYPE_IS_UNKNOWN;
 
   // File types that can be detected unambiguously but are not supported
-  if (aac_adif_reader_c::probe_file(io, size))
+  if ((FOURCC('A', 'D', 'I', 'F') == magic32) && aac_adif_reader_c::probe_file(io, size))
     type = FILE_TYPE_AAC;
-  else if (asf_reader_c::probe_file(io, size))
+  else if ((MAGIC_ASF_WMV == magic32) && asf_reader_c::probe_file(io, size))
     type = FILE_TYPE_ASF;
-  else if (cdxa_reader_c::probe_file(io, size))
+  else if (is_riff && (FOURCC('C', 'D', 'X', 'A') == magic32_2) && cdxa_reader_c::probe_file(io, size))
     type = FILE_TYPE_CDXA;
-  else if (flv_reader_c::probe_file(io, size))
+  else if ((FOURCC('F', 'L', 'V', 0) == (magic32 & 0xffffff00)) && flv_reader_c::probe_file(io, size))
     type = FILE_TYPE_FLV;
-  else if (hdsub_reader_c::probe_file(io, size))
+  else if ((HDSUB_FILE_MAGIC == magic16) && hdsub_reader_c::probe_file(io, size))
     type = FILE_TYPE_HDSUB;
 
-  // File types that can be detected unambiguously
-  else if (avi_reader_c::probe_file(io, size))
+  // File types that can be detected unambiguously. The case
+  // insensitive signatures consist of letters only (apart from the
+  // dot in ".RMF"), so masking out bit 5 is enough.
+  else if ((FOURCC('R', 'I', 'F', 'F') == (magic32 & 0xdfdfdfdf)) && (FOURCC('A', 'V', 'I', 0) == (magic32_2 & 0xdfdfdf00)) && avi_reader_c::probe_file(io, size))
     type = FILE_TYPE_AVI;
-  else if (kax_reader_c::probe_file(io, size))
+  else if ((MAGIC_MKV == magic32) && kax_reader_c::probe_file(io, size))
     type = FILE_TYPE_MATROSKA;
-  else if (wav_reader_c::probe_file(io, size))
+  else if (is_riff && (FOURCC('W', 'A', 'V', 'E') == magic32_2) && wav_reader_c::probe_file(io, size))
     type = FILE_TYPE_WAV;
-  else if (ogm_reader_c::probe_file(io, size))
+  else if ((FOURCC('O', 'g', 'g', 'S') == magic32) && ogm_reader_c::probe_file(io, size))
     type = FILE_TYPE_OGM;
-  else if (flac_reader_c::probe_file(io, size))
+  else if ((FOURCC('f', 'L', 'a', 'C') == magic32) && flac_reader_c::probe_file(io, size))
     type = FILE_TYPE_FLAC;
-  else if (pgssup_reader_c::probe_file(io, size))
+  else if ((PGSSUP_FILE_MAGIC == magic16) && pgssup_reader_c::probe_file(io, size))
     type = FILE_TYPE_PGSSUP;
-  else if (real_reader_c::probe_file(io, size))
+  else if ((FOURCC('.', 'R', 'M', 'F') == (magic32 & 0xffdfdfdf)) && real_reader_c::probe_file(io, size))
     type = FILE_TYPE_REAL;
   else if (qtmp4_reader_c::probe_file(io, size))
     type = FILE_TYPE_QTMP4;
   else if (tta_reader_c::probe_file(io, size))
     type = FILE_TYPE_TTA;
-  else if (vc1_es_reader_c::probe_file(io, size))
+  else if (((VC1_MARKER_SEQHDR == magic32) || (VC1_MARKER_ENTRYPOINT == magic32) || (VC1_MARKER_FRAME == magic32)) && vc1_es_reader_c::probe_file(io, size))
     type = FILE_TYPE_VC1;
-  else if (wavpack_reader_c::probe_file(io, size))
+  else if ((FOURCC('w', 'v', 'p', 'k') == magic32) && wavpack_reader_c::probe_file(io, size))
     type = FILE_TYPE_WAVPACK4;
-  else if (ivf_reader_c::probe_file(io, size))
+  else if ((FOURCC('D', 'K', 'I', 'F') == magic32) && ivf_reader_c::probe_file(io, size))
     type = FILE_TYPE_IVF;
-  else if (coreaudio_reader_c::probe_file(io, size))
+  else if ((FOURCC('C', 'A', 'F', 'F') == (magic32 & 0xdfdfdfdf)) && coreaudio_reader_c::probe_file(io, size))
     type = FILE_TYPE_COREAUDIO;
   else if (dirac_es_reader_c::probe_file(io, size))
     type = FILE_TYPE_DIRAC;
@@ -525,7 +593,10 @@ void
 get_file_type(filelist_t &file) {
   auto result = get_file_type_internal(file);
 
-  g_file_sizes += result.second;
+  // Several files may be probed at the same time during batch
+  // identification which doesn't need the total size anyway.
+  if (!g_identifying)
+    g_file_sizes += result.second;
 
   file.size     = result.second;
   file.type     = result.first;
@@ -559,7 +630,7 @@ display_progress(bool is_100percent = false) {
   static int64_t s_previous_progress_on = 0;
   static int s_previous_percentage      = -1;
 
-  if (s_no_progress)
+  if (s_no_progress || !g_show_progress)
     return;
 
   if (is_100percent) {
@@ -567,11 +638,17 @@ display_progress(bool is_100percent = false) {
     return;
   }
 
-  if (!s_display_reader)
+  if (!s_display_reader) {
     s_display_reader = determine_display_reader();
 
+    for (auto &ptzr : g_packetizers)
+      if (ptzr.packetizer->m_reader == s_display_reader)
+        s_display_reader_thread = ptzr.reader_thread;
+  }
+
   bool display_progress  = false;
-  int current_percentage = (s_display_reader->get_progress() + s_display_files_done * 100) / s_display_path_length;
+  int reader_progress    = s_display_reader_thread ? s_display_reader_thread->get_progress(s_display_reader) : s_display_reader->get_progress();
+  int current_percentage = (reader_progress + s_display_files_done * 100) / s_display_path_length;
   int64_t current_time   = get_current_time_millis();
 
   if (   (-1 == s_previous_percentage)
@@ -962,6 +1039,13 @@ render_void(int64_t new_size) {
 */
 void
 rerender_track_headers() {
+  // Packetizers running in reader threads must not write to the output
+  // file. The main loop re-renders the headers on their behalf.
+  if (!s_reader_threads.empty() && (std::this_thread::get_id() != s_main_thread_id)) {
+    s_track_headers_need_rerendering = true;
+    return;
+  }
+
   g_kax_tracks->UpdateSize(false);
 
   int64_t new_void_size       = s_void_after_track_headers->GetElementPosition() + s_void_after_track_headers->ElementSize() - g_kax_tracks->GetElementPosition() - g_kax_tracks->ElementSize();
@@ -1322,147 +1406,151 @@ calc_attachment_sizes() {
   }
 }
 
-/** \brief Creates the file readers
+/** \brief Creates the file reader for a single file
 
-   For each file the appropriate file reader class is instantiated.
+   The appropriate file reader class is instantiated for the file.
    The newly created class must read all track information in its
    contrsuctor and throw an exception in case of an error. Otherwise
    it is assumed that the file can be hanlded.
 */
 void
-create_readers() {
+create_reader(filelist_t &file) {
   static auto s_debug_timecode_restrictions = debugging_option_c{"timecode_restrictions"};
 
-  for (auto &file : g_files) {
-    try {
-      mm_io_cptr input_file = file.playlist_mpls_in ? std::static_pointer_cast<mm_io_c>(file.playlist_mpls_in) : open_input_file(file);
+  try {
+    mm_io_cptr input_file = file.playlist_mpls_in ? std::static_pointer_cast<mm_io_c>(file.playlist_mpls_in) : open_input_file(file);
 
-      switch (file.type) {
-        case FILE_TYPE_AAC:
-          file.reader = new aac_reader_c(*file.ti, input_file);
-          break;
-        case FILE_TYPE_AC3:
-          file.reader = new ac3_reader_c(*file.ti, input_file);
-          break;
-        case FILE_TYPE_AVC_ES:
-          file.reader = new avc_es_reader_c(*file.ti, input_file);
-          break;
-        case FILE_TYPE_HEVC_ES:
-          file.reader = new hevc_es_reader_c(*file.ti, input_file);
-          break;
-        case FILE_TYPE_AVI:
-          file.reader = new avi_reader_c(*file.ti, input_file);
-          break;
-        case FILE_TYPE_COREAUDIO:
-          file.reader = new coreaudio_reader_c(*file.ti, input_file);
-          break;
-        case FILE_TYPE_DIRAC:
-          file.reader = new dirac_es_reader_c(*file.ti, input_file);
-          break;
-        case FILE_TYPE_DTS:
-          file.reader = new dts_reader_c(*file.ti, input_file);
-          break;
+    switch (file.type) {
+      case FILE_TYPE_AAC:
+        file.reader = new aac_reader_c(*file.ti, input_file);
+        break;
+      case FILE_TYPE_AC3:
+        file.reader = new ac3_reader_c(*file.ti, input_file);
+        break;
+      case FILE_TYPE_AVC_ES:
+        file.reader = new avc_es_reader_c(*file.ti, input_file);
+        break;
+      case FILE_TYPE_HEVC_ES:
+        file.reader = new hevc_es_reader_c(*file.ti, input_file);
+        break;
+      case FILE_TYPE_AVI:
+        file.reader = new avi_reader_c(*file.ti, input_file);
+        break;
+      case FILE_TYPE_COREAUDIO:
+        file.reader = new coreaudio_reader_c(*file.ti, input_file);
+        break;
+      case FILE_TYPE_DIRAC:
+        file.reader = new dirac_es_reader_c(*file.ti, input_file);
+        break;
+      case FILE_TYPE_DTS:
+        file.reader = new dts_reader_c(*file.ti, input_file);
+        break;
 #if defined(HAVE_FLAC_FORMAT_H)
-        case FILE_TYPE_FLAC:
-          file.reader = new flac_reader_c(*file.ti, input_file);
-          break;
+      case FILE_TYPE_FLAC:
+        file.reader = new flac_reader_c(*file.ti, input_file);
+        break;
 #endif
-        case FILE_TYPE_FLV:
-          file.reader = new flv_reader_c(*file.ti, input_file);
-          break;
-        case FILE_TYPE_IVF:
-          file.reader = new ivf_reader_c(*file.ti, input_file);
-          break;
-        case FILE_TYPE_MATROSKA:
-          file.reader = new kax_reader_c(*file.ti, input_file);
-          break;
-        case FILE_TYPE_MP3:
-          file.reader = new mp3_reader_c(*file.ti, input_file);
-          break;
-        case FILE_TYPE_MPEG_ES:
-          file.reader = new mpeg_es_reader_c(*file.ti, input_file);
-          break;
-        case FILE_TYPE_MPEG_PS:
-          file.reader = new mpeg_ps_reader_c(*file.ti, input_file);
-          break;
-        case FILE_TYPE_MPEG_TS:
-          file.reader = new mpeg_ts_reader_c(*file.ti, input_file);
-          break;
-        case FILE_TYPE_OGM:
-          file.reader = new ogm_reader_c(*file.ti, input_file);
-          break;
-        case FILE_TYPE_PGSSUP:
-          file.reader = new pgssup_reader_c(*file.ti, input_file);
-          break;
-        case FILE_TYPE_QTMP4:
-          file.reader = new qtmp4_reader_c(*file.ti, input_file);
-          break;
-        case FILE_TYPE_REAL:
-          file.reader = new real_reader_c(*file.ti, input_file);
-          break;
-        case FILE_TYPE_SSA:
-          file.reader = new ssa_reader_c(*file.ti, input_file);
-          break;
-        case FILE_TYPE_SRT:
-          file.reader = new srt_reader_c(*file.ti, input_file);
-          break;
-        case FILE_TYPE_TRUEHD:
-          file.reader = new truehd_reader_c(*file.ti, input_file);
-          break;
-        case FILE_TYPE_TTA:
-          file.reader = new tta_reader_c(*file.ti, input_file);
-          break;
-        case FILE_TYPE_USF:
-          file.reader = new usf_reader_c(*file.ti, input_file);
-          break;
-        case FILE_TYPE_VC1:
-          file.reader = new vc1_es_reader_c(*file.ti, input_file);
-          break;
-        case FILE_TYPE_VOBBTN:
-          file.reader = new vobbtn_reader_c(*file.ti, input_file);
-          break;
-        case FILE_TYPE_VOBSUB:
-          file.reader = new vobsub_reader_c(*file.ti, input_file);
-          break;
-        case FILE_TYPE_WAV:
-          file.reader = new wav_reader_c(*file.ti, input_file);
-          break;
-        case FILE_TYPE_WAVPACK4:
-          file.reader = new wavpack_reader_c(*file.ti, input_file);
-          break;
-        default:
-          mxerror(boost::format(Y("EVIL internal bug! (unknown file type). %1%\n")) % BUGMSG);
-          break;
-      }
+      case FILE_TYPE_FLV:
+        file.reader = new flv_reader_c(*file.ti, input_file);
+        break;
+      case FILE_TYPE_IVF:
+        file.reader = new ivf_reader_c(*file.ti, input_file);
+        break;
+      case FILE_TYPE_MATROSKA:
+        file.reader = new kax_reader_c(*file.ti, input_file);
+        break;
+      case FILE_TYPE_MP3:
+        file.reader = new mp3_reader_c(*file.ti, input_file);
+        break;
+      case FILE_TYPE_MPEG_ES:
+        file.reader = new mpeg_es_reader_c(*file.ti, input_file);
+        break;
+      case FILE_TYPE_MPEG_PS:
+        file.reader = new mpeg_ps_reader_c(*file.ti, input_file);
+        break;
+      case FILE_TYPE_MPEG_TS:
+        file.reader = new mpeg_ts_reader_c(*file.ti, input_file);
+        break;
+      case FILE_TYPE_OGM:
+        file.reader = new ogm_reader_c(*file.ti, input_file);
+        break;
+      case FILE_TYPE_PGSSUP:
+        file.reader = new pgssup_reader_c(*file.ti, input_file);
+        break;
+      case FILE_TYPE_QTMP4:
+        file.reader = new qtmp4_reader_c(*file.ti, input_file);
+        break;
+      case FILE_TYPE_REAL:
+        file.reader = new real_reader_c(*file.ti, input_file);
+        break;
+      case FILE_TYPE_SSA:
+        file.reader = new ssa_reader_c(*file.ti, input_file);
+        break;
+      case FILE_TYPE_SRT:
+        file.reader = new srt_reader_c(*file.ti, input_file);
+        break;
+      case FILE_TYPE_TRUEHD:
+        file.reader = new truehd_reader_c(*file.ti, input_file);
+        break;
+      case FILE_TYPE_TTA:
+        file.reader = new tta_reader_c(*file.ti, input_file);
+        break;
+      case FILE_TYPE_USF:
+        file.reader = new usf_reader_c(*file.ti, input_file);
+        break;
+      case FILE_TYPE_VC1:
+        file.reader = new vc1_es_reader_c(*file.ti, input_file);
+        break;
+      case FILE_TYPE_VOBBTN:
+        file.reader = new vobbtn_reader_c(*file.ti, input_file);
+        break;
+      case FILE_TYPE_VOBSUB:
+        file.reader = new vobsub_reader_c(*file.ti, input_file);
+        break;
+      case FILE_TYPE_WAV:
+        file.reader = new wav_reader_c(*file.ti, input_file);
+        break;
+      case FILE_TYPE_WAVPACK4:
+        file.reader = new wavpack_reader_c(*file.ti, input_file);
+        break;
+      default:
+        mxerror(boost::format(Y("EVIL internal bug! (unknown file type). %1%\n")) % BUGMSG);
+        break;
+    }
 
-      file.reader->read_headers();
-      file.reader->set_timecode_restrictions(file.restricted_timecode_min, file.restricted_timecode_max);
+    file.reader->read_headers();
+    file.reader->set_timecode_restrictions(file.restricted_timecode_min, file.restricted_timecode_max);
 
-      // Re-calculate file size because the reader might switch to a
-      // multi I/O reader in read_headers().
-      file.size = file.reader->get_file_size();
+    // Re-calculate file size because the reader might switch to a
+    // multi I/O reader in read_headers().
+    file.size = file.reader->get_file_size();
 
-      mxdebug_if(s_debug_timecode_restrictions,
-                 boost::format("Timecode restrictions for %3%: min %1% max %2%\n") % file.restricted_timecode_min % file.restricted_timecode_max % file.ti->m_fname);
+    mxdebug_if(s_debug_timecode_restrictions,
+               boost::format("Timecode restrictions for %3%: min %1% max %2%\n") % file.restricted_timecode_min % file.restricted_timecode_max % file.ti->m_fname);
 
-    } catch (mtx::mm_io::open_x &error) {
-      mxerror(boost::format(Y("The demultiplexer for the file '%1%' failed to initialize:\n%2%\n")) % file.ti->m_fname % Y("The file could not be opened for reading, or there was not enough data to parse its headers."));
+  } catch (mtx::mm_io::open_x &error) {
+    mxerror(boost::format(Y("The demultiplexer for the file '%1%' failed to initialize:\n%2%\n")) % file.ti->m_fname % Y("The file could not be opened for reading, or there was not enough data to parse its headers."));
 
-    } catch (mtx::input::open_x &error) {
-      mxerror(boost::format(Y("The demultiplexer for the file '%1%' failed to initialize:\n%2%\n")) % file.ti->m_fname % Y("The file could not be opened for reading, or there was not enough data to parse its headers."));
+  } catch (mtx::input::open_x &error) {
+    mxerror(boost::format(Y("The demultiplexer for the file '%1%' failed to initialize:\n%2%\n")) % file.ti->m_fname % Y("The file could not be opened for reading, or there was not enough data to parse its headers."));
 
-    } catch (mtx::input::invalid_format_x &error) {
-      mxerror(boost::format(Y("The demultiplexer for the file '%1%' failed to initialize:\n%2%\n")) % file.ti->m_fname % Y("The file content does not match its format type and was not recognized."));
+  } catch (mtx::input::invalid_format_x &error) {
+    mxerror(boost::format(Y("The demultiplexer for the file '%1%' failed to initialize:\n%2%\n")) % file.ti->m_fname % Y("The file content does not match its format type and was not recognized."));
 
-    } catch (mtx::input::header_parsing_x &error) {
-      mxerror(boost::format(Y("The demultiplexer for the file '%1%' failed to initialize:\n%2%\n")) % file.ti->m_fname % Y("The file headers could not be parsed, e.g. because they're incomplete, invalid or damaged."));
+  } catch (mtx::input::header_parsing_x &error) {
+    mxerror(boost::format(Y("The demultiplexer for the file '%1%' failed to initialize:\n%2%\n")) % file.ti->m_fname % Y("The file headers could not be parsed, e.g. because they're incomplete, invalid or damaged."));
 
-    } catch (mtx::input::exception &error) {
-      mxerror(boost::format(Y("The demultiplexer for the file '%1%' failed to initialize:\n%2%\n")) % file.ti->m_fname % error.error());
-    }
+  } catch (mtx::input::exception &error) {
+    mxerror(boost::format(Y("The demultiplexer for the file '%1%' failed to initialize:\n%2%\n")) % file.ti->m_fname % error.error());
   }
 }
 
+void
+create_readers() {
+  for (auto &file : g_files)
+    create_reader(file);
+}
+
 void
 create_packetizers() {
   // Create the packetizers.
@@ -1607,6 +1695,82 @@ render_chapter_void_placeholder() {
   s_kax_chapters_void->Render(*s_out);
 }
 
+/** \brief Render an EbmlVoid element as a placeholder for the cues
+
+    Only done if the user has requested the cues to be placed at the
+    front of the file. The space reserved is the size given on the
+    command line. When splitting, the size of the previous file's
+    cues plus a quarter is used if that's larger.
+ */
+static void
+render_cues_void_placeholder() {
+  if (!g_write_cues || (0 >= g_cues_at_front_size))
+    return;
+
+  s_kax_cues_void = new EbmlVoid;
+  s_kax_cues_void->SetSize(std::max(g_cues_at_front_size, s_previous_cues_size + s_previous_cues_size / 4));
+  s_kax_cues_void->Render(*s_out);
+}
+
+/** \brief Fill the space at the current position with an EbmlVoid element
+
+    'size' is the element's total size including its head and must be
+    at least two bytes.
+ */
+static void
+render_void_filler(int64_t size) {
+  EbmlVoid filler;
+  auto content_size = size;
+
+  filler.SetSize(content_size);
+  filler.UpdateSize();
+
+  while (static_cast<int64_t>(filler.ElementSize()) > size)
+    filler.SetSize(--content_size);
+
+  if (static_cast<int64_t>(filler.ElementSize()) < size)
+    filler.SetSizeLength(size - content_size - 1);
+
+  filler.Render(*s_out);
+}
+
+/** \brief Render the cues
+
+    The cues are written into the space reserved at the front of the
+    file if there is such space and the cues fit. Otherwise they're
+    written at the current position.
+ */
+static void
+render_cues() {
+  auto &cues           = cues_c::get();
+  auto element_size    = static_cast<int64_t>(cues.calculate_element_size());
+  s_previous_cues_size = element_size;
+
+  if (s_kax_cues_void) {
+    auto void_position = s_kax_cues_void->GetElementPosition();
+    auto void_size     = static_cast<int64_t>(s_kax_cues_void->ElementSize());
+    auto remaining     = void_size - element_size;
+
+    mxdebug_if(s_debug_cues_at_front, boost::format("cues_at_front: void at %1% size %2% cues size %3%\n") % void_position % void_size % element_size);
+
+    // A Void element needs at least two bytes.
+    if ((0 == remaining) || (2 <= remaining)) {
+      s_out->save_pos(void_position);
+      cues.write(*s_out, *g_kax_sh_main);
+      if (remaining)
+        render_void_filler(remaining);
+      s_out->restore_pos();
+
+      return;
+    }
+
+    mxwarn(boost::format(Y("The space reserved for the cues at the front of the file (%1% bytes) is too small as %2% bytes are needed. The cues will be written at the end of the file.\n"))
+           % void_size % element_size);
+  }
+
+  cues.write(*s_out, *g_kax_sh_main);
+}
+
 /** \brief Prepare tag elements for rendering
 
     Adds missing mandatory elements to the tag structures and sorts
@@ -1654,9 +1818,12 @@ create_next_output_file() {
   auto this_outfile   = g_cluster_helper->split_mode_produces_many_files() ? create_output_name() : g_outfile;
   g_kax_segment       = new KaxSegment();
 
-  // Open the output file.
+  // Open the output file. Full buffers are written in a background
+  // thread unless that has been turned off.
   try {
-    s_out = !g_cluster_helper->discarding() ? mm_write_buffer_io_c::open(this_outfile, 20 * 1024 * 1024) : mm_io_cptr{ new mm_null_io_c{this_outfile} };
+    s_out = g_cluster_helper->discarding()      ? mm_io_cptr{ new mm_null_io_c{this_outfile} }
+          : hack_engaged(ENGAGE_NO_ASYNC_OUTPUT) ? mm_write_buffer_io_c::open(this_outfile, 20 * 1024 * 1024)
+          :                                        mm_async_write_buffer_io_c::open(this_outfile, 20 * 1024 * 1024);
   } catch (mtx::mm_io::exception &ex) {
     mxerror(boost::format(Y("The file '%1%' could not be opened for writing: %2%.\n")) % this_outfile % ex);
   }
@@ -1669,6 +1836,7 @@ create_next_output_file() {
   render_headers(s_out.get());
   render_attachments(s_out.get());
   render_chapter_void_placeholder();
+  render_cues_void_placeholder();
   add_tags_from_cue_chapters();
   prepare_tags_for_rendering();
 
@@ -1779,7 +1947,7 @@ finish_file(bool last_file,
   if (g_write_cues && g_cue_writing_requested) {
     if (do_output)
       mxinfo(Y("The cue entries (the index) are being written...\n"));
-    cues_c::get().write(*s_out, *g_kax_sh_main);
+    render_cues();
   }
 
   // Now re-render the s_kax_duration and fill in the biggest timecode
@@ -1912,6 +2080,8 @@ finish_file(bool last_file,
   delete s_kax_sh_void;
   delete g_kax_sh_main;
   delete s_void_after_track_headers;
+  delete s_kax_cues_void;
+  s_kax_cues_void = nullptr;
   if (g_kax_sh_cues)
     delete g_kax_sh_cues;
   delete s_head;
@@ -2139,6 +2309,9 @@ append_track(packetizer_t &ptzr,
   append_chapters_for_track(src_file, timecode_adjustment);
 
   ptzr.deferred = false;
+
+  // The packetizer is active again. Let the interleaver pick it up.
+  s_interleaver_needs_rebuild = true;
 }
 
 /** \brief Decide if packetizers have to be appended
@@ -2206,61 +2379,125 @@ establish_deferred_connections(filelist_t &file) {
 }
 
 static void
-pull_packetizers_for_packets() {
-  for (auto &ptzr : g_packetizers) {
-    if (FILE_STATUS_HOLDING == ptzr.status)
-      ptzr.status = FILE_STATUS_MOREDATA;
+pull_packetizer_for_packets_directly(packetizer_t &ptzr) {
+  while (   !ptzr.pack
+         && (FILE_STATUS_MOREDATA == ptzr.status)
+         && !ptzr.packetizer->packet_available())
+    ptzr.status = ptzr.packetizer->read();
+
+  if (   (FILE_STATUS_MOREDATA != ptzr.status)
+         && (FILE_STATUS_MOREDATA == ptzr.old_status))
+    ptzr.packetizer->force_duration_on_last_packet();
+
+  if (!ptzr.pack)
+    ptzr.pack = ptzr.packetizer->get_packet();
+}
 
-    ptzr.old_status = ptzr.status;
+static void
+pull_packetizer_for_packets_from_thread(packetizer_t &ptzr) {
+  // The reader thread takes care of reading, forcing durations and
+  // retrieving packets from the packetizer.
+  if (!ptzr.pack && (FILE_STATUS_MOREDATA == ptzr.status))
+    ptzr.status = ptzr.reader_thread->fetch(ptzr.packetizer, ptzr.pack);
+}
 
-    while (   !ptzr.pack
-           && (FILE_STATUS_MOREDATA == ptzr.status)
-           && !ptzr.packetizer->packet_available())
-      ptzr.status = ptzr.packetizer->read();
+static void
+pull_packetizer_for_packets(packetizer_t &ptzr) {
+  ++s_interleaver_num_pulls;
 
-    if (   (FILE_STATUS_MOREDATA != ptzr.status)
-           && (FILE_STATUS_MOREDATA == ptzr.old_status))
-      ptzr.packetizer->force_duration_on_last_packet();
-
-    if (!ptzr.pack)
-      ptzr.pack = ptzr.packetizer->get_packet();
-
-    if (!ptzr.pack && (FILE_STATUS_DONE == ptzr.status))
-      ptzr.status = FILE_STATUS_DONE_AND_DRY;
-
-    // Has this packetizer changed its status from "data available" to
-    // "file done" during this loop? If so then decrease the number of
-    // unfinished packetizers in the corresponding file structure.
-    if (   (FILE_STATUS_DONE_AND_DRY == ptzr.status)
-        && (ptzr.old_status != ptzr.status)) {
-      filelist_t &file = g_files[ptzr.file];
-      file.num_unfinished_packetizers--;
-
-      // If all packetizers for a file have finished then establish the
-      // deferred connections.
-      if ((0 >= file.num_unfinished_packetizers) && (0 < file.old_num_unfinished_packetizers)) {
-        establish_deferred_connections(file);
-        file.done = true;
-      }
-      file.old_num_unfinished_packetizers = file.num_unfinished_packetizers;
+  if (FILE_STATUS_HOLDING == ptzr.status)
+    ptzr.status = FILE_STATUS_MOREDATA;
+
+  ptzr.old_status = ptzr.status;
+
+  if (ptzr.reader_thread)
+    pull_packetizer_for_packets_from_thread(ptzr);
+  else
+    pull_packetizer_for_packets_directly(ptzr);
+
+  if (!ptzr.pack && (FILE_STATUS_DONE == ptzr.status))
+    ptzr.status = FILE_STATUS_DONE_AND_DRY;
+
+  // Has this packetizer changed its status from "data available" to
+  // "file done" during this loop? If so then decrease the number of
+  // unfinished packetizers in the corresponding file structure.
+  if (   (FILE_STATUS_DONE_AND_DRY == ptzr.status)
+      && (ptzr.old_status != ptzr.status)) {
+    filelist_t &file = g_files[ptzr.file];
+    file.num_unfinished_packetizers--;
+
+    // If all packetizers for a file have finished then establish the
+    // deferred connections.
+    if ((0 >= file.num_unfinished_packetizers) && (0 < file.old_num_unfinished_packetizers)) {
+      establish_deferred_connections(file);
+      file.done = true;
     }
+    file.old_num_unfinished_packetizers = file.num_unfinished_packetizers;
+  }
+}
+
+static void
+schedule_packetizer(packetizer_t &ptzr) {
+  if (ptzr.pack) {
+    ++s_interleaver_num_heap_operations;
+    s_packetizers_by_timecode.push(&ptzr);
+
+  } else if (FILE_STATUS_DONE_AND_DRY != ptzr.status)
+    s_packetizers_to_pull.push_back(&ptzr);
+}
+
+/** \brief Make sure a packet is available for each packetizer
+
+   Only those packetizers that don't have a packet pending are asked
+   for one: the one whose packet has been written last and the ones
+   that were holding. All packetizers are pulled in the first round and
+   after tracks have been appended as appending modifies the
+   packetizers' states.
+*/
+static void
+pull_packetizers_for_packets() {
+  if (!s_interleaver_needs_rebuild) {
+    auto to_pull = std::move(s_packetizers_to_pull);
+    s_packetizers_to_pull.clear();
+
+    // Keep the order the packetizers have in g_packetizers.
+    brng::sort(to_pull);
+
+    for (auto ptzr : to_pull) {
+      pull_packetizer_for_packets(*ptzr);
+      schedule_packetizer(*ptzr);
+    }
+  }
+
+  // Deferred connections established above may have set the flag, too.
+  if (!s_interleaver_needs_rebuild)
+    return;
+
+  s_interleaver_needs_rebuild = false;
+  s_packetizers_to_pull.clear();
+  s_packetizers_by_timecode = packetizer_heap_t{};
+
+  ++s_interleaver_num_rebuilds;
+
+  for (auto &ptzr : g_packetizers) {
+    pull_packetizer_for_packets(ptzr);
+    schedule_packetizer(ptzr);
   }
 }
 
 static packetizer_t *
 select_winning_packetizer() {
-  packetizer_t *winner = nullptr;
+  if (s_packetizers_by_timecode.empty())
+    return nullptr;
 
-  for (auto &ptzr : g_packetizers) {
-    if (!ptzr.pack)
-      continue;
+  ++s_interleaver_num_heap_operations;
 
-    if (!winner || !winner->pack)
-      winner = &ptzr;
+  auto winner = s_packetizers_by_timecode.top();
+  s_packetizers_by_timecode.pop();
 
-    else if (ptzr.pack && (ptzr.pack->output_order_timecode < winner->pack->output_order_timecode))
-      winner = &ptzr;
-  }
+  // The winner's packet will be consumed. Ask it for a new one in the
+  // next round.
+  s_packetizers_to_pull.push_back(winner);
 
   return winner;
 }
@@ -2273,6 +2510,103 @@ discard_queued_packets() {
   g_cluster_helper->discard_queued_packets();
 }
 
+/** \brief Keep packetizers in reader threads from running
+
+   Packetizers may modify their track headers at any time, e.g. when
+   they find the codec private data. The main thread must therefore
+   pause the reader threads whenever it accesses the track headers,
+   e.g. while rendering clusters or the track headers themselves.
+*/
+void
+pause_reader_threads() {
+  if (s_reader_threads.empty() || (std::this_thread::get_id() != s_main_thread_id))
+    return;
+
+  for (auto &thread : s_reader_threads)
+    thread->pause();
+}
+
+void
+resume_reader_threads() {
+  if (s_reader_threads.empty() || (std::this_thread::get_id() != s_main_thread_id))
+    return;
+
+  for (auto &thread : s_reader_threads)
+    thread->resume();
+}
+
+static void
+rerender_track_headers_for_reader_threads() {
+  if (!s_track_headers_need_rerendering)
+    return;
+
+  pause_reader_threads();
+
+  s_track_headers_need_rerendering = false;
+  rerender_track_headers();
+
+  resume_reader_threads();
+}
+
+/** \brief Distribute the readers over a number of background threads
+
+   All packetizers of a single reader are handled by the same thread.
+   Appending and splitting require the main loop to reconfigure readers
+   and packetizers on the fly. Therefore multi-threaded reading is not
+   used in those cases.
+*/
+static void
+start_reader_threads() {
+  if (0 >= g_num_reader_threads)
+    return;
+
+  if (s_appending_files || g_cluster_helper->splitting()) {
+    mxinfo(Y("Multi-threaded reading is not supported when appending or splitting. Only a single thread will be used.\n"));
+    return;
+  }
+
+  auto thread_by_file = std::unordered_map<int64_t, reader_thread_c *>{};
+
+  for (auto &ptzr : g_packetizers) {
+    auto &thread = thread_by_file[ptzr.file];
+
+    if (!thread) {
+      auto idx = (thread_by_file.size() - 1) % g_num_reader_threads;
+      if (idx == s_reader_threads.size())
+        s_reader_threads.push_back(std::make_shared<reader_thread_c>());
+      thread = s_reader_threads[idx].get();
+    }
+
+    thread->add_packetizer(ptzr.packetizer);
+    ptzr.reader_thread = thread;
+  }
+
+  s_main_thread_id = std::this_thread::get_id();
+
+  for (auto &thread : s_reader_threads)
+    thread->start();
+}
+
+static void
+stop_reader_threads() {
+  if (s_reader_threads.empty())
+    return;
+
+  for (auto &thread : s_reader_threads)
+    thread->stop();
+
+  for (auto &ptzr : g_packetizers)
+    ptzr.reader_thread = nullptr;
+
+  s_reader_threads.clear();
+  s_display_reader_thread = nullptr;
+
+  if (s_track_headers_need_rerendering) {
+    s_track_headers_need_rerendering = false;
+    rerender_track_headers();
+  }
+}
+
 /** \brief Request packets and handle the next one
 
    Requests packets from each packetizer, selects the packet with the
@@ -2281,12 +2615,16 @@ discard_queued_packets() {
 */
 void
 main_loop() {
+  start_reader_threads();
+
   // Let's go!
   while (1) {
     // Step 1: Make sure a packet is available for each output
     // as long we haven't already processed the last one.
     pull_packetizers_for_packets();
 
+    rerender_track_headers_for_reader_threads();
+
     // Step 2: Pick the packet with the lowest timecode and
     // stuff it into the Matroska file.
     auto winner = select_winning_packetizer();
@@ -2297,6 +2635,8 @@ main_loop() {
     if (winner && winner->pack) {
       packet_cptr pack = winner->pack;
 
+      ++s_interleaver_num_packets;
+
       // Step 3: Add the winning packet to a cluster. Full clusters will be
       // rendered automatically.
       g_cluster_helper->add_packet(pack);
@@ -2318,6 +2658,14 @@ main_loop() {
       break;
   }
 
+  stop_reader_threads();
+
+  mxdebug_if(s_debug_interleaver,
+             boost::format("interleaver: %1% packetizers, %2% packets, %3% packetizer pulls, %4% heap operations, %5% rebuilds; %|6$.2f| pulls and %|7$.2f| heap operations per packet\n")
+             % g_packetizers.size() % s_interleaver_num_packets % s_interleaver_num_pulls % s_interleaver_num_heap_operations % s_interleaver_num_rebuilds
+             % (static_cast<double>(s_interleaver_num_pulls)           / std::max<int64_t>(s_interleaver_num_packets, 1))
+             % (static_cast<double>(s_interleaver_num_heap_operations) / std::max<int64_t>(s_interleaver_num_packets, 1)));
+
   // Render all remaining packets (if there are any).
   if (g_cluster_helper && (0 < g_cluster_helper->get_packet_count()))
     g_cluster_helper->render();
@@ -25,6 +25,7 @@
 #include "common/file_types.h"
 #include "common/mm_mpls_multi_file_io.h"
 #include "common/segmentinfo.h"
+#include "merge/attachment.h"
 #include "merge/file_status.h"
 #include "merge/packet.h"
 
@@ -46,6 +47,7 @@ using namespace libmatroska;
 class mm_io_c;
 class generic_packetizer_c;
 class generic_reader_c;
+class reader_thread_c;
 class track_info_c;
 
 struct append_spec_t {
@@ -80,6 +82,7 @@ struct packetizer_t {
   generic_packetizer_c *packetizer, *orig_packetizer;
   int64_t file, orig_file;
   bool deferred;
+  reader_thread_c *reader_thread;
 
   packetizer_t()
     : status{FILE_STATUS_MOREDATA}
@@ -89,6 +92,7 @@ struct packetizer_t {
     , file{}
     , orig_file{}
     , deferred{}
+    , reader_thread{}
   {
   }
 };
@@ -143,28 +147,6 @@ struct filelist_t {
   }
 };
 
-struct attachment_t {
-  std::string name, stored_name, mime_type, description;
-  uint64_t id;
-  bool to_all_files;
-  memory_cptr data;
-  int64_t ui_id;
-
-  attachment_t() {
-    clear();
-  }
-  void clear() {
-    name         = "";
-    stored_name  = "";
-    mime_type    = "";
-    description  = "";
-    id           = 0;
-    ui_id        = 0;
-    to_all_files = false;
-    data.reset();
-  }
-};
-
 struct track_order_t {
   int64_t file_id;
   int64_t track_id;
@@ -207,6 +189,7 @@ extern family_uids_c g_segfamily_uids;
 extern kax_info_cptr g_kax_info_chap;
 
 extern bool g_write_meta_seek_for_clusters;
+extern bool g_write_cluster_crc32;
 
 extern std::string g_chapter_file_name;
 extern std::string g_chapter_language;
@@ -231,9 +214,10 @@ extern float g_video_fps;
 extern generic_packetizer_c *g_video_packetizer;
 
 extern bool g_write_cues, g_cue_writing_requested;
+extern int64_t g_cues_at_front_size;
 extern bool g_no_lacing, g_no_linking, g_use_durations, g_no_track_statistics_tags;
 
-extern bool g_identifying, g_identify_verbose, g_identify_for_mmg;
+extern bool g_identifying, g_identify_verbose, g_identify_for_mmg, g_identify_batch;
 
 extern int g_file_num;
 
@@ -244,13 +228,18 @@ extern int g_default_tracks[3], g_default_tracks_priority[3];
 extern bool g_splitting;
 extern int g_split_max_num_files;
 extern std::string g_splitting_by_chapters_arg;
+extern int g_num_split_jobs;
 
 extern append_mode_e g_append_mode;
 
+extern int g_num_reader_threads;
+extern bool g_show_progress;
+
 extern bool g_stereo_mode_used;
 
 void get_file_type(filelist_t &file);
 
+void create_reader(filelist_t &file);
 void create_readers();
 void create_packetizers();
 void calc_attachment_sizes();
@@ -269,6 +258,8 @@ void finish_file(bool last_file, bool create_new_file = false, bool previously_d
 void force_close_output_file();
 void rerender_track_headers();
 void rerender_ebml_head();
+void pause_reader_threads();
+void resume_reader_threads();
 std::string create_output_name();
 
 int64_t add_attachment(attachment_t attachment);
@@ -146,6 +146,28 @@ struct packet_t {
   ~packet_t() {
   }
 
+  // Packets are created and destroyed at a high rate. Both the
+  // packets and their shared pointers' control blocks are therefore
+  // allocated from the memory pool.
+  static void *operator new(size_t size) {
+    return memory_pool_c::allocate(size);
+  }
+
+  static void operator delete(void *p, size_t size) {
+    memory_pool_c::release(p, size);
+  }
+
+  template<typename... Args>
+  static std::shared_ptr<packet_t>
+  create(Args &&... args) {
+    return std::allocate_shared<packet_t>(memory_pool_allocator_c<packet_t>{}, std::forward<Args>(args)...);
+  }
+
+  static std::shared_ptr<packet_t>
+  take(packet_t *packet) {
+    return std::shared_ptr<packet_t>{packet, std::default_delete<packet_t>{}, memory_pool_allocator_c<packet_t>{}};
+  }
+
   bool
   has_timecode()
     const {
@@ -0,0 +1,255 @@
+/*
+   mkvmerge -- utility for splicing together matroska files
+   from component media subtypes
+
+   Distributed under the GPL v2
+   see the file COPYING for details
+   or visit http://www.gnu.org/copyleft/gpl.html
+
+   reading and packetizing in background threads
+
+   Written by Moritz Bunkus <moritz@bunkus.org>.
+*/
+
+#include "common/common_pch.h"
+
+#include "merge/generic_packetizer.h"
+#include "merge/generic_reader.h"
+#include "merge/reader_thread.h"
+
+reader_thread_c::reader_thread_c(size_t max_queued_packets)
+  : m_max_queued_packets{std::max<size_t>(max_queued_packets, 1)}
+  , m_started{}
+  , m_stop_requested{}
+  , m_paused{}
+  , m_worker_waiting{}
+  , m_debug{"reader_thread|reader_threads"}
+{
+}
+
+reader_thread_c::~reader_thread_c() {
+  stop();
+}
+
+void
+reader_thread_c::add_packetizer(generic_packetizer_c *packetizer) {
+  assert(!m_started);
+
+  m_track_idx_by_packetizer[packetizer] = m_tracks.size();
+  m_progress_by_reader[packetizer->m_reader] = 0;
+  m_tracks.emplace_back(packetizer, m_max_queued_packets);
+}
+
+void
+reader_thread_c::start() {
+  if (m_started)
+    return;
+
+  m_started = true;
+  m_thread  = std::thread{[this]() { run(); }};
+}
+
+void
+reader_thread_c::stop() {
+  if (!m_thread.joinable())
+    return;
+
+  // Errors raised in this thread are reported by the main
+  // thread. This only happens if code running here terminates the
+  // process directly.
+  if (std::this_thread::get_id() == m_thread.get_id()) {
+    m_thread.detach();
+    return;
+  }
+
+  // The main thread may exit due to an error while the thread is
+  // paused.
+  if (m_paused)
+    resume();
+
+  {
+    std::lock_guard<std::mutex> lock{m_mutex};
+    m_stop_requested = true;
+  }
+
+  m_worker_cond.notify_all();
+  m_thread.join();
+}
+
+void
+reader_thread_c::pause() {
+  m_processing_mutex.lock();
+  m_paused = true;
+}
+
+void
+reader_thread_c::resume() {
+  m_paused = false;
+  m_processing_mutex.unlock();
+}
+
+file_status_e
+reader_thread_c::fetch(generic_packetizer_c *packetizer,
+                       packet_cptr &packet) {
+  auto &track = m_tracks[m_track_idx_by_packetizer[packetizer]];
+
+  while (true) {
+    if (track.m_packets.try_pop(packet)) {
+      wake_worker_if_waiting();
+      return FILE_STATUS_MOREDATA;
+    }
+
+    std::unique_lock<std::mutex> lock{m_mutex};
+
+    if (m_exception) {
+      auto exception = m_exception;
+      lock.unlock();
+
+      rethrow_thread_exception(exception);
+    }
+
+    // The thread queues packets before it takes the lock for setting
+    // the flags and signalling. Therefore the queue has to be checked
+    // again while holding the lock.
+    if (!track.m_packets.empty())
+      continue;
+
+    if (track.m_holding) {
+      track.m_holding = false;
+      m_worker_cond.notify_one();
+
+      return FILE_STATUS_HOLDING;
+    }
+
+    if (track.m_finished)
+      return FILE_STATUS_DONE;
+
+    m_consumer_cond.wait(lock);
+  }
+}
+
+void
+reader_thread_c::wake_worker_if_waiting() {
+  if (!m_worker_waiting)
+    return;
+
+  std::lock_guard<std::mutex> lock{m_mutex};
+  m_worker_cond.notify_one();
+}
+
+int
+reader_thread_c::get_progress(generic_reader_c *reader) {
+  std::lock_guard<std::mutex> lock{m_mutex};
+  return m_progress_by_reader[reader];
+}
+
+reader_thread_c::track_t *
+reader_thread_c::find_track_to_process() {
+  // Prefer the track with the fewest packets waiting as the main
+  // thread is most likely waiting for it. Tracks with packets left
+  // over from their last read() may only queue those.
+  track_t *selected = nullptr;
+
+  for (auto &track : m_tracks) {
+    if (track.m_packets.full())
+      continue;
+
+    auto can_proceed = !track.m_overflow.empty() || (!track.m_finished && !track.m_holding);
+    if (can_proceed && (!selected || (track.m_packets.size() < selected->m_packets.size())))
+      selected = &track;
+  }
+
+  return selected;
+}
+
+void
+reader_thread_c::run() {
+  // Errors are reported by the main thread in fetch().
+  throw_on_mxerror_c throw_on_mxerror;
+
+  std::unique_lock<std::mutex> lock{m_mutex};
+
+  while (!m_stop_requested) {
+    auto track = find_track_to_process();
+    if (!track) {
+      // The main thread frees space in the queues without taking the
+      // lock and only signals if this flag is set. The tracks must
+      // therefore be checked once more after setting it.
+      m_worker_waiting = true;
+      if (!find_track_to_process())
+        m_worker_cond.wait(lock);
+      m_worker_waiting = false;
+
+      continue;
+    }
+
+    lock.unlock();
+
+    try {
+      process(*track);
+
+    } catch (...) {
+      lock.lock();
+      m_exception = std::current_exception();
+      m_consumer_cond.notify_all();
+      break;
+    }
+
+    lock.lock();
+  }
+}
+
+void
+reader_thread_c::process(track_t &track) {
+  auto packetizer = track.m_packetizer;
+  auto progress   = -1;
+
+  if (track.m_overflow.empty()) {
+    auto status = FILE_STATUS_MOREDATA;
+
+    {
+      std::lock_guard<std::mutex> processing_lock{m_processing_mutex};
+
+      while ((FILE_STATUS_MOREDATA == status) && !packetizer->packet_available())
+        status = packetizer->read();
+
+      if (FILE_STATUS_MOREDATA != status)
+        packetizer->force_duration_on_last_packet();
+
+      while (packetizer->packet_available())
+        track.m_overflow.push_back(packetizer->get_packet());
+
+      progress = packetizer->m_reader->get_progress();
+    }
+
+    track.m_pending_status = status;
+
+    mxdebug_if(m_debug, boost::format("reader_thread: track %1% of '%2%': %3% packets, status %4%\n") % packetizer->m_ti.m_id % packetizer->m_ti.m_fname % track.m_overflow.size() % static_cast<int>(status));
+  }
+
+  queue_packets(track);
+
+  std::lock_guard<std::mutex> lock{m_mutex};
+
+  // The status must only be passed on once all packets read before
+  // have been queued.
+  if (track.m_overflow.empty() && (FILE_STATUS_MOREDATA != track.m_pending_status)) {
+    if (FILE_STATUS_HOLDING == track.m_pending_status)
+      track.m_holding = true;
+    else
+      track.m_finished = true;
+
+    track.m_pending_status = FILE_STATUS_MOREDATA;
+  }
+
+  if (-1 != progress)
+    m_progress_by_reader[packetizer->m_reader] = progress;
+
+  m_consumer_cond.notify_all();
+}
+
+void
+reader_thread_c::queue_packets(track_t &track) {
+  while (!track.m_overflow.empty() && track.m_packets.try_push(track.m_overflow.front()))
+    track.m_overflow.pop_front();
+}
@@ -0,0 +1,119 @@
+/*
+   mkvmerge -- utility for splicing together matroska files
+   from component media subtypes
+
+   Distributed under the GPL v2
+   see the file COPYING for details
+   or visit http://www.gnu.org/copyleft/gpl.html
+
+   reading and packetizing in background threads
+
+   Written by Moritz Bunkus <moritz@bunkus.org>.
+*/
+
+#ifndef MTX_MERGE_READER_THREAD_H
+#define MTX_MERGE_READER_THREAD_H
+
+#include "common/common_pch.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <thread>
+
+#include "common/spsc_queue.h"
+#include "merge/file_status.h"
+#include "merge/packet.h"
+
+class generic_packetizer_c;
+class generic_reader_c;
+
+class reader_thread_c;
+typedef std::shared_ptr<reader_thread_c> reader_thread_cptr;
+
+// A reader thread drives the readers of one or more input files and
+// the packetizers attached to them. Finished packets are handed over
+// to the main thread via a bounded single producer/single consumer
+// queue per packetizer which both sides access without locking. All
+// packetizers of a single reader must be handled by the same thread
+// as a reader's read() may produce packets for any of its
+// packetizers.
+//
+// A single read() may produce more packets than fit into the
+// queue. Those are kept in the track's overflow list, and the track
+// isn't read from again until all of them have been queued. The
+// thread never blocks on a full queue as the main thread might be
+// waiting for a different packetizer handled by the same thread.
+class reader_thread_c {
+protected:
+  struct track_t {
+    generic_packetizer_c *m_packetizer;
+    spsc_queue_c<packet_cptr> m_packets;
+
+    // Only accessed by the reader thread.
+    std::deque<packet_cptr> m_overflow;
+    file_status_e m_pending_status;
+
+    // Protected by m_mutex.
+    bool m_holding, m_finished;
+
+    track_t(generic_packetizer_c *packetizer,
+            size_t max_queued_packets)
+      : m_packetizer{packetizer}
+      , m_packets{max_queued_packets}
+      , m_pending_status{FILE_STATUS_MOREDATA}
+      , m_holding{}
+      , m_finished{}
+    {
+    }
+  };
+
+  // A deque as the tracks' queues cannot be moved.
+  std::deque<track_t> m_tracks;
+  std::unordered_map<generic_packetizer_c *, size_t> m_track_idx_by_packetizer;
+  std::unordered_map<generic_reader_c *, int> m_progress_by_reader;
+  size_t m_max_queued_packets;
+
+  std::thread m_thread;
+  std::mutex m_mutex, m_processing_mutex;
+  std::condition_variable m_worker_cond, m_consumer_cond;
+  bool m_started, m_stop_requested;
+  // Only accessed by the main thread.
+  bool m_paused;
+  std::atomic<bool> m_worker_waiting;
+  std::exception_ptr m_exception;
+
+  debugging_option_c m_debug;
+
+public:
+  reader_thread_c(size_t max_queued_packets = 64);
+  ~reader_thread_c();
+
+  void add_packetizer(generic_packetizer_c *packetizer);
+
+  void start();
+  void stop();
+
+  // Blocks until the packetizer has a packet ready, has signalled
+  // that its reader is holding back or has finished. Returns
+  // FILE_STATUS_MOREDATA and sets 'packet' in the first case,
+  // FILE_STATUS_HOLDING and FILE_STATUS_DONE in the other two cases.
+  file_status_e fetch(generic_packetizer_c *packetizer, packet_cptr &packet);
+
+  int get_progress(generic_reader_c *reader);
+
+  // Prevents the thread from running any reader or packetizer code
+  // until resume() is called.
+  void pause();
+  void resume();
+
+protected:
+  void run();
+  track_t *find_track_to_process();
+  void process(track_t &track);
+  void queue_packets(track_t &track);
+  void wake_worker_if_waiting();
+};
+
+#endif  // MTX_MERGE_READER_THREAD_H
@@ -0,0 +1,278 @@
+/*
+   mkvmerge -- utility for splicing together matroska files
+   from component media subtypes
+
+   Distributed under the GPL v2
+   see the file COPYING for details
+   or visit http://www.gnu.org/copyleft/gpl.html
+
+   creating the files of a split run in parallel processes
+
+   Written by Moritz Bunkus <moritz@bunkus.org>.
+*/
+
+#include "common/common_pch.h"
+
+#if !defined(SYS_WINDOWS)
+# include <sys/types.h>
+# include <sys/wait.h>
+# include <unistd.h>
+#endif
+
+#include "common/fs_sys_helpers.h"
+#include "common/strings/formatting.h"
+#include "merge/cluster_helper.h"
+#include "merge/generic_packetizer.h"
+#include "merge/generic_reader.h"
+#include "merge/output_control.h"
+#include "merge/split_jobs.h"
+
+namespace {
+
+struct range_t {
+  int64_t start, end;
+};
+
+// All timecode ranges that make up one output file. There's more
+// than one range if parts are appended to each other with
+// '--split parts:...,+start-end'.
+typedef std::vector<range_t> ranges_t;
+
+// The readers are positioned this far in front of the start of a
+// file's first range so that packets stored slightly out of order
+// in the source aren't lost.
+int64_t const s_seek_margin = 10000000000ll;
+
+// On the output timeline. May be negative.
+int64_t s_seek_timecode     = 0;
+bool s_position_readers     = false;
+
+debugging_option_c s_debug{"split_jobs"};
+
+std::vector<ranges_t>
+determine_files() {
+  auto const &split_points = g_cluster_helper->get_split_points();
+  auto files               = std::vector<ranges_t>{};
+  auto infinity            = std::numeric_limits<int64_t>::max();
+
+  if (split_point_c::timecode == split_points.front().m_type) {
+    auto start = int64_t{};
+
+    for (auto const &split_point : split_points) {
+      if (split_point.m_point <= start)
+        continue;
+
+      files.push_back(ranges_t{ range_t{ start, split_point.m_point } });
+      start = split_point.m_point;
+    }
+
+    files.push_back(ranges_t{ range_t{ start, infinity } });
+
+  } else {
+    for (auto idx = 0u; idx < split_points.size(); ++idx) {
+      auto const &split_point = split_points[idx];
+      if (split_point.m_discard)
+        continue;
+
+      if (files.empty() || split_point.m_create_new_file)
+        files.emplace_back();
+
+      files.back().push_back(range_t{ split_point.m_point, (idx + 1) < split_points.size() ? split_points[idx + 1].m_point : infinity });
+    }
+  }
+
+  // Once the maximum number of files has been reached no further
+  // splitting takes place. The last file therefore contains
+  // everything from its start up to the end.
+  if (files.size() > static_cast<size_t>(g_split_max_num_files)) {
+    files.resize(g_split_max_num_files);
+    files.back() = ranges_t{ range_t{ files.back().front().start, infinity } };
+  }
+
+  return files;
+}
+
+// Creates the same split points '--split parts:' would create for
+// the ranges of a single file.
+std::vector<split_point_c>
+create_split_points_for(ranges_t const &ranges) {
+  auto split_points = std::vector<split_point_c>{};
+  auto previous_end = int64_t{};
+
+  for (auto const &range : ranges) {
+    auto create_new_file = &range == &ranges.front();
+
+    if (previous_end < range.start)
+      split_points.push_back(split_point_c{ previous_end, split_point_c::parts, true, true, create_new_file });
+    split_points.push_back(split_point_c{ range.start, split_point_c::parts, true, false, create_new_file });
+
+    previous_end = range.end;
+  }
+
+  if (previous_end < std::numeric_limits<int64_t>::max())
+    split_points.push_back(split_point_c{ previous_end, split_point_c::parts, true, true });
+
+  return split_points;
+}
+
+void
+verify_split_mode() {
+  auto supported = g_splitting_by_chapters_arg.empty();
+
+  for (auto const &split_point : g_cluster_helper->get_split_points())
+    if ((split_point_c::timecode != split_point.m_type) && (split_point_c::parts != split_point.m_type))
+      supported = false;
+
+  if (!supported)
+    mxerror(Y("Creating the files in parallel jobs is only supported for the splitting modes 'timecodes:' and 'parts:'.\n"));
+
+  if (!g_no_linking)
+    mxerror(Y("Creating the files in parallel jobs cannot be combined with '--link'.\n"));
+
+  // The forced segment UIDs are used one after the other for each
+  // file created, but each job only knows about its own file.
+  if (!g_forced_seguids.empty())
+    mxerror(Y("Creating the files in parallel jobs cannot be combined with '--segment-uid'.\n"));
+}
+
+void
+setup_job(ranges_t const &ranges,
+          size_t file_idx) {
+
+  // Output file names and handling of attachments depend on the file
+  // number.
+  g_file_num      = file_idx + 1;
+  g_outfile       = create_output_name();
+  g_show_progress = false;
+
+  g_cluster_helper->set_split_points(create_split_points_for(ranges));
+
+  if (0 < ranges.front().start) {
+    s_seek_timecode    = ranges.front().start - s_seek_margin;
+    s_position_readers = true;
+  }
+
+  mxdebug_if(s_debug, boost::format("split_jobs: job for file %1% (%2%) with %3% range(s) starting at %4%\n") % g_file_num % g_outfile % ranges.size() % format_timecode(ranges.front().start));
+}
+
+#if !defined(SYS_WINDOWS)
+int
+wait_for_job(std::map<pid_t, size_t> &running) {
+  while (true) {
+    auto status = 0;
+    auto pid    = waitpid(-1, &status, 0);
+
+    if ((-1 == pid) && (EINTR == errno))
+      continue;
+
+    if (-1 == pid)
+      mxerror(boost::format(Y("Waiting for a child process failed: %1%\n")) % strerror(errno));
+
+    auto itr = running.find(pid);
+    if (running.end() == itr)
+      continue;
+
+    mxdebug_if(s_debug, boost::format("split_jobs: job for file %1% finished with status %2%\n") % (itr->second + 1) % status);
+
+    running.erase(itr);
+
+    return WIFEXITED(status) ? WEXITSTATUS(status) : 2;
+  }
+}
+#endif
+
+}
+
+void
+start_split_jobs() {
+  if ((1 >= g_num_split_jobs) || g_identifying || (!g_cluster_helper->splitting() && g_splitting_by_chapters_arg.empty()))
+    return;
+
+  verify_split_mode();
+
+  auto files = determine_files();
+  if (2 > files.size())
+    return;
+
+#if defined(SYS_WINDOWS)
+  mxerror(Y("Creating the files in parallel jobs is not supported on Windows.\n"));
+
+#else  // SYS_WINDOWS
+  auto start     = get_current_time_millis();
+  auto num_jobs  = std::min<size_t>(g_num_split_jobs, files.size());
+  auto running   = std::map<pid_t, size_t>{};
+  auto exit_code = 0;
+  auto num_done  = 0u;
+
+  mxinfo(boost::format(Y("Creating %1% files in up to %2% parallel jobs.\n")) % files.size() % num_jobs);
+
+  for (auto file_idx = 0u; file_idx < files.size(); ++file_idx) {
+    if (running.size() >= num_jobs) {
+      exit_code = std::max(exit_code, wait_for_job(running));
+      ++num_done;
+      mxinfo(boost::format(Y("Progress: %1%%%%2%")) % (num_done * 100 / files.size()) % "\r");
+    }
+
+    // Don't let the children output what the parent has buffered.
+    g_mm_stdio->flush();
+
+    auto pid = fork();
+    if (-1 == pid)
+      mxerror(boost::format(Y("Creating a child process failed: %1%\n")) % strerror(errno));
+
+    if (0 == pid) {
+      setup_job(files[file_idx], file_idx);
+      return;
+    }
+
+    running[pid] = file_idx;
+  }
+
+  while (!running.empty()) {
+    exit_code = std::max(exit_code, wait_for_job(running));
+    ++num_done;
+    mxinfo(boost::format(Y("Progress: %1%%%%2%")) % (num_done * 100 / files.size()) % "\r");
+  }
+
+  mxinfo("\n");
+  mxinfo(boost::format(Y("Muxing took %1%.\n")) % create_minutes_seconds_time_string((get_current_time_millis() - start + 500) / 1000, true));
+
+  mxexit(exit_code);
+#endif  // SYS_WINDOWS
+}
+
+int64_t
+split_job_source_timecode(int64_t output_timecode,
+                          timecode_sync_t const &sync) {
+  // The inverse of the packetizers' mapping: output = source * factor
+  // + displacement.
+  return static_cast<int64_t>((output_timecode - sync.displacement) * sync.denominator / sync.numerator);
+}
+
+void
+position_readers_for_split_job() {
+  if (!s_position_readers)
+    return;
+
+  // Appended files are shifted in time depending on the preceding
+  // files' content. All of them have to be read in that case.
+  for (auto const &file : g_files)
+    if (file.appending)
+      return;
+
+  for (auto const &file : g_files) {
+    // All of the reader's tracks must start in front of the seek
+    // point after their '--sync' settings have been applied. The
+    // offset for tracks whose timecodes are reset depends on their
+    // first packet. Such files are read from the start.
+    auto timecode = std::numeric_limits<int64_t>::max();
+    for (auto ptzr : file.reader->m_reader_packetizers)
+      timecode = std::min(timecode, ptzr->m_ti.m_reset_timecodes ? 0 : split_job_source_timecode(s_seek_timecode, ptzr->m_ti.m_tcsync));
+
+    if ((0 >= timecode) || (std::numeric_limits<int64_t>::max() == timecode))
+      continue;
+
+    auto positioned = file.reader->seek_to_timecode(timecode);
+    mxdebug_if(s_debug, boost::format("split_jobs: positioning reader for %1% before %2%: %3%\n") % file.name % format_timecode(timecode) % positioned);
+  }
+}
@@ -0,0 +1,44 @@
+/*
+   mkvmerge -- utility for splicing together matroska files
+   from component media subtypes
+
+   Distributed under the GPL v2
+   see the file COPYING for details
+   or visit http://www.gnu.org/copyleft/gpl.html
+
+   creating the files of a split run in parallel processes
+
+   Written by Moritz Bunkus <moritz@bunkus.org>.
+*/
+
+#ifndef MTX_MERGE_SPLIT_JOBS_H
+#define MTX_MERGE_SPLIT_JOBS_H
+
+#include "common/common_pch.h"
+
+struct timecode_sync_t;
+
+// If the user has requested more than one split job and all split
+// points are known in advance ('--split timecodes:' and '--split
+// parts:') then one child process is forked for each output file. At
+// most g_num_split_jobs of them run at the same time. Each child
+// discards everything outside of the timecode ranges of its own
+// file.
+//
+// The function returns in the child processes and if splitting in
+// parallel isn't possible. It doesn't return in the parent process
+// which exits once all children have finished.
+void start_split_jobs();
+
+// Called in the child processes after the readers have been
+// created. Asks the readers to position themselves shortly before
+// the start of the child's first timecode range so that the data in
+// front of it doesn't have to be read.
+void position_readers_for_split_job();
+
+// The split points refer to the output timeline while the readers
+// seek in their source's timeline. Converts a timecode from the
+// former to the latter for a track with the given '--sync' settings.
+int64_t split_job_source_timecode(int64_t output_timecode, timecode_sync_t const &sync);
+
+#endif  // MTX_MERGE_SPLIT_JOBS_H
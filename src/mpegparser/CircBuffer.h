@@ -101,6 +101,22 @@ public:
       return m_buf[i - bbw];
   }
 
+  //Returns a pointer to the byte at position i and the number of
+  //bytes that are stored contiguously starting at that position.
+  binary* GetContiguous(uint32_t i, uint32_t& length){
+    uint32_t bbw = bytes_before_wrap_read();
+    if(i >= bytes_in_buf){
+      length = 0;
+      return read_ptr;
+    }
+    if(i < bbw){
+      length = std::min(bbw, bytes_in_buf) - i;
+      return read_ptr + i;
+    }
+    length = bytes_in_buf - i;
+    return m_buf + (i - bbw);
+  }
+
   int32_t Read(binary* dest, uint32_t numBytes);
   int32_t Skip(uint32_t numBytes);
   int32_t Write(binary* data, uint32_t numBytes);
@@ -22,6 +22,8 @@
 
 #include "common/common_pch.h"
 
+#include "common/start_code.h"
+
 #include "MPEGVideoBuffer.h"
 #include <cstring>
 #include <stddef.h>
@@ -39,29 +41,39 @@ MPEG2PictureHeader::MPEG2PictureHeader() {
 }
 
 int32_t MPEGVideoBuffer::FindStartCode(uint32_t startPos){
-  //How many bytes can we look through?
-  uint32_t window = myBuffer->GetLength() - startPos;
+  CircBuffer& buf = *myBuffer;
+  uint32_t length = buf.GetLength();
+  uint32_t pos = startPos;
 
-  if(window < 4) //Make sure we have enough bytes to search.
-    return -1;
+  //We need the start code plus the byte identifying it.
+  while((pos + 3) < length){
+    uint32_t contiguous = 0;
+    binary* data = buf.GetContiguous(pos, contiguous);
+    uint32_t found = pos + mtx::start_code::find(data, contiguous);
 
-  for(unsigned int i = startPos; i < (window - 3); i++){
-    CircBuffer& buf = *myBuffer;
-    binary a,b,c,d;
-    a = buf[i];
-    b = buf[i+1];
-    c = buf[i+2];
-    d = buf[i+3];
-    if((a == 0x00) && (b == 0x00) && (c == 0x01)){
-      switch(d){
-        case MPEG_VIDEO_SEQUENCE_START_CODE:
-        case MPEG_VIDEO_GOP_START_CODE:
-        case MPEG_VIDEO_PICTURE_START_CODE:
-          return i;  //Return our position if we found
-          //one of the codes we want
+    if(found == (pos + contiguous)){
+      //A start code may span the end of the circular buffer's
+      //storage. Check the last two positions byte by byte.
+      pos = found - std::min<uint32_t>(contiguous, 2);
+      while((pos < found) && ((pos + 3) < length) && !((buf[pos] == 0x00) && (buf[pos+1] == 0x00) && (buf[pos+2] == 0x01)))
+        pos++;
+      if((pos == found) || ((pos + 3) >= length))
+        continue;
+      found = pos;
+    }
 
-      }
+    if((found + 3) >= length)
+      break;
+
+    switch(buf[found+3]){
+      case MPEG_VIDEO_SEQUENCE_START_CODE:
+      case MPEG_VIDEO_GOP_START_CODE:
+      case MPEG_VIDEO_PICTURE_START_CODE:
+        return found;  //Return our position if we found
+        //one of the codes we want
     }
+
+    pos = found + 3;
   }
 
   //If we get here we have no _wanted_ start code found.
@@ -170,7 +170,7 @@ ac3_packetizer_c::flush_packets() {
   while (m_parser.frame_available()) {
     auto frame = get_frame();
     adjust_header_values(frame);
-    set_timecode_and_add_packet(std::make_shared<packet_t>(frame.m_data));
+    set_timecode_and_add_packet(packet_t::create(frame.m_data));
   }
 }
 
@@ -134,7 +134,7 @@ dts_packetizer_c::process_available_packets(bool flushing) {
     auto samples_in_packet = get_dts_packet_length_in_core_samples(&dtsheader);
     auto new_timecode      = m_timecode_calculator.get_next_timecode(samples_in_packet);
 
-    add_packet(std::make_shared<packet_t>(dts_packet, new_timecode.to_ns(), get_dts_packet_length_in_nanoseconds(&dtsheader)));
+    add_packet(packet_t::create(dts_packet, new_timecode.to_ns(), get_dts_packet_length_in_nanoseconds(&dtsheader)));
   }
 }
 
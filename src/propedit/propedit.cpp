@@ -94,6 +94,7 @@ run(options_cptr &options) {
   mxinfo(boost::format("%1%\n") % Y("The file is being analyzed."));
 
   analyzer->set_show_progress(options->m_show_progress);
+  analyzer->set_use_index_file(options->m_use_index_file);
 
   bool ok = false;
   try {
@@ -34,6 +34,11 @@ propedit_cli_parser_c::set_parse_mode() {
   }
 }
 
+void
+propedit_cli_parser_c::set_use_index_file() {
+  m_options->m_use_index_file = true;
+}
+
 void
 propedit_cli_parser_c::add_target() {
   try {
@@ -191,6 +196,8 @@ propedit_cli_parser_c::init_parser() {
   add_section_header(YT("Options"));
   OPT("l|list-property-names",      list_property_names, YT("List all valid property names and exit"));
   OPT("p|parse-mode=<mode>",        set_parse_mode,      YT("Sets the Matroska parser mode to 'fast' (default) or 'full'"));
+  OPT("use-index-file",             set_use_index_file,  YT("Keep the positions of the file's elements in an index file next to it "
+                                                            "and use them instead of analyzing the file as long as it hasn't been changed"));
 
   add_section_header(YT("Actions for handling properties"));
   OPT("e|edit=<selector>",          add_target,          YT("Sets the Matroska file section that all following add/set/delete "
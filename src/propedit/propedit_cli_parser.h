@@ -37,6 +37,7 @@ protected:
   void add_tags();
   void add_chapters();
   void set_parse_mode();
+  void set_use_index_file();
   void set_file_name();
 
   void set_attachment_name();
@@ -0,0 +1,21 @@
+#!/usr/bin/ruby -w
+
+# T_470identify_batch_attachments
+describe "mkvmerge / identifying several files with attachments in one batch"
+
+# The same file is listed twice on purpose: its attachments must not
+# be dropped as duplicates of the first one's.
+files    = %w{data/mkv/attachments.mkv data/ssa-ass/Embedded.ssa data/mkv/attachment-without-fileuid.mkv data/mkv/attachments.mkv}
+expected = nil
+
+setup do
+  expected = files.collect { |file| sys("../src/mkvmerge --identify-verbose #{file}").first }.flatten.join('')
+end
+
+[ 1, 3 ].each do |num_threads|
+  test "--identify-batch with #{num_threads} thread(s)" do
+    File.open(tmp, 'w') { |file| file.puts files }
+    output = sys("../src/mkvmerge --identify-verbose --identify-batch #{tmp} --threads #{num_threads}").first.join('')
+    output == expected ? :ok : :bad
+  end
+end
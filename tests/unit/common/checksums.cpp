@@ -134,4 +134,25 @@ TEST_F(ChecksumTest, FileChunked1000) {
   EXPECT_EQ(*m_data_md5, *calculate_bin(mtx::checksum::md5,                       1000));
 }
 
+TEST(Checksum, Crc32IeeeLeUnalignedBuffers) {
+  auto reference = [](unsigned char const *buffer, size_t size) -> uint32_t {
+    auto crc = uint32_t{0xffffffff};
+    for (auto idx = 0u; idx < size; ++idx) {
+      crc ^= buffer[idx];
+      for (auto bit = 0; bit < 8; ++bit)
+        crc = (crc >> 1) ^ (crc & 1 ? 0xedb88320 : 0);
+    }
+
+    return crc;
+  };
+
+  auto data = std::vector<unsigned char>(5000);
+  for (auto idx = 0u; idx < data.size(); ++idx)
+    data[idx] = static_cast<unsigned char>((idx * 2654435761u) >> 13);
+
+  for (auto offset : std::vector<size_t>{ 0, 1, 3, 7, 8, 15 })
+    for (auto size : std::vector<size_t>{ 0, 1, 15, 16, 63, 64, 65, 127, 128, 1000, 4096, 4985 })
+      EXPECT_EQ(reference(&data[offset], size), mtx::checksum::calculate_as_uint(mtx::checksum::crc32_ieee_le, &data[offset], size, 0xffffffff)) << "offset " << offset << " size " << size;
+}
+
 }
@@ -0,0 +1,69 @@
+#include "common/common_pch.h"
+
+#include "common/delta_coded_vector.h"
+
+#include "gtest/gtest.h"
+
+namespace {
+
+TEST(DeltaCodedVector, Empty) {
+  auto v = delta_coded_vector_c{};
+
+  EXPECT_TRUE(v.empty());
+  EXPECT_EQ(0u, v.size());
+}
+
+TEST(DeltaCodedVector, SequentialAccess) {
+  auto v      = delta_coded_vector_c{4};
+  auto values = std::vector<int64_t>{ 0, 1, 1, -5, 1000, 999, 41708333, 83416666, std::numeric_limits<int64_t>::max(), std::numeric_limits<int64_t>::min(), 0, 17 };
+
+  for (auto value : values)
+    v.push_back(value);
+
+  ASSERT_EQ(values.size(), v.size());
+  EXPECT_EQ(17, v.back());
+
+  for (auto idx = 0u; idx < values.size(); ++idx)
+    EXPECT_EQ(values[idx], v[idx]);
+}
+
+TEST(DeltaCodedVector, RandomAccess) {
+  auto v      = delta_coded_vector_c{8};
+  auto values = std::vector<int64_t>{};
+
+  for (auto idx = 0; idx < 1000; ++idx) {
+    values.push_back(static_cast<int64_t>(idx) * 1234567 - (idx % 3) * 99);
+    v.push_back(values.back());
+  }
+
+  for (auto idx : std::vector<size_t>{ 999, 0, 500, 500, 501, 7, 8, 6, 998, 15, 16 })
+    EXPECT_EQ(values[idx], v[idx]);
+}
+
+TEST(DeltaCodedVector, CompactStorage) {
+  auto v = delta_coded_vector_c{};
+
+  for (auto idx = 0; idx < 10000; ++idx)
+    v.push_back(static_cast<int64_t>(idx) * 1024);
+
+  v.shrink_to_fit();
+
+  EXPECT_LT(v.get_memory_usage(), 10000u * 3);
+}
+
+TEST(DeltaCodedVector, Clear) {
+  auto v = delta_coded_vector_c{};
+
+  v.push_back(42);
+  v.push_back(43);
+  EXPECT_EQ(43, v[1]);
+
+  v.clear();
+  EXPECT_TRUE(v.empty());
+
+  v.push_back(7);
+  EXPECT_EQ(1u, v.size());
+  EXPECT_EQ(7,  v[0]);
+}
+
+}
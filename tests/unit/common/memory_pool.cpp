@@ -0,0 +1,51 @@
+#include "common/common_pch.h"
+
+#include "common/memory_pool.h"
+
+#include "gtest/gtest.h"
+
+namespace {
+
+TEST(MemoryPool, Capacity) {
+  EXPECT_EQ(16u,        memory_pool_c::get_capacity(0));
+  EXPECT_EQ(16u,        memory_pool_c::get_capacity(1));
+  EXPECT_EQ(16u,        memory_pool_c::get_capacity(16));
+  EXPECT_EQ(32u,        memory_pool_c::get_capacity(17));
+  EXPECT_EQ(4096u,      memory_pool_c::get_capacity(4000));
+  EXPECT_EQ(65536u,     memory_pool_c::get_capacity(65536));
+  EXPECT_EQ(65537u,     memory_pool_c::get_capacity(65537));
+}
+
+TEST(MemoryPool, ReusesReleasedBuffers) {
+  auto buffer = memory_pool_c::allocate(100);
+  memory_pool_c::release(buffer, 100);
+
+  EXPECT_EQ(buffer, memory_pool_c::allocate(120));
+
+  memory_pool_c::release(buffer, 120);
+}
+
+TEST(MemoryPool, MemoryResizeKeepsContent) {
+  auto mem = memory_c::alloc(10);
+  memcpy(mem->get_buffer(), "0123456789", 10);
+
+  mem->resize(14);
+  EXPECT_EQ(0, memcmp(mem->get_buffer(), "0123456789", 10));
+
+  mem->add(reinterpret_cast<unsigned char const *>("abcdefghijklmnopqrstuvwxyz"), 26);
+  EXPECT_EQ(40u, mem->get_size());
+  EXPECT_EQ(0, memcmp(mem->get_buffer(), "0123456789", 10));
+  EXPECT_EQ(0, memcmp(mem->get_buffer() + 14, "abcdefghijklmnopqrstuvwxyz", 26));
+
+  mem->resize(100000);
+  EXPECT_EQ(0, memcmp(mem->get_buffer() + 14, "abcdefghijklmnopqrstuvwxyz", 26));
+}
+
+TEST(MemoryPool, CloneOfNullBuffer) {
+  auto mem = memory_c::clone(nullptr, 0);
+
+  EXPECT_FALSE(mem->is_allocated());
+  EXPECT_EQ(0u, mem->get_size());
+}
+
+}
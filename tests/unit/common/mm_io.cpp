@@ -4,6 +4,9 @@
 #include "tests/unit/util.h"
 
 #include "common/mm_io_x.h"
+#include "common/mm_mmap_io.h"
+#include "common/mm_probe_io.h"
+#include "common/mm_write_buffer_io.h"
 
 namespace {
 
@@ -16,4 +19,152 @@ TEST(MmIo, Slurp) {
   ASSERT_THROW(mm_file_io_c::slurp("doesnotexist"), mtx::mm_io::exception);
 }
 
+TEST(MmIo, AsyncWriteBuffer) {
+  mm_mem_io_c mem{nullptr, 0, 1000};
+
+  {
+    mm_async_write_buffer_io_c out{&mem, 4, false};
+
+    out.write(std::string{"0123456789"});
+    EXPECT_EQ(10u, out.getFilePointer());
+
+    out.setFilePointer(2);
+    out.write(std::string{"ab"});
+    EXPECT_EQ(4u, out.getFilePointer());
+
+    out.setFilePointer(0, seek_end);
+    out.write(std::string{"xyz"});
+    EXPECT_EQ(13u, out.getFilePointer());
+  }
+
+  EXPECT_EQ(13, mem.get_size());
+  EXPECT_EQ(std::string{"01ab456789xyz"}, std::string(reinterpret_cast<char const *>(mem.get_buffer()), 13));
+}
+
+TEST(MmIo, AsyncWriteBufferErrorInDestructor) {
+  static unsigned char const s_data[] = "0123456789";
+  mm_mem_io_c read_only{s_data, 10};
+
+  // The background write fails. The destructor must neither throw nor
+  // terminate the program.
+  {
+    mm_async_write_buffer_io_c out{&read_only, 4, false};
+    out.write(std::string{"abcdef"});
+  }
+
+  EXPECT_EQ(std::string{"0123456789"}, std::string(reinterpret_cast<char const *>(s_data), 10));
+}
+
+TEST(MmIo, AsyncWriteBufferDiscard) {
+  mm_mem_io_c mem{nullptr, 0, 1000};
+
+  {
+    mm_async_write_buffer_io_c out{&mem, 4, false};
+
+    out.write(std::string{"0123456"});
+    out.discard_buffer();
+  }
+
+  // The first buffer may or may not have been written already, but
+  // the discarded rest must never end up in the file.
+  EXPECT_TRUE((0 == mem.get_size()) || (4 == mem.get_size()));
+}
+
+TEST(MmIo, MmapIo) {
+  mm_mmap_io_c in{"tests/unit/data/text/chunky_bacon.txt"};
+
+  EXPECT_EQ(13, in.get_size());
+
+  auto view = in.read(6);
+  EXPECT_EQ(*view, std::string{"Chunky"});
+  EXPECT_EQ(6u, in.getFilePointer());
+
+  std::string rest;
+  EXPECT_EQ(7u, in.read(rest, 100));
+  EXPECT_EQ(std::string{" Bacon\n"}, rest);
+  EXPECT_TRUE(in.eof());
+
+  in.setFilePointer(-6, seek_end);
+  EXPECT_FALSE(in.eof());
+  EXPECT_EQ(*in.read(5), std::string{"Bacon"});
+
+  ASSERT_THROW(in.read(10), mtx::mm_io::end_of_file_x);
+
+  // Views aren't copied when the packetizers take ownership of them.
+  auto buffer = view->get_buffer();
+  view->grab();
+  EXPECT_EQ(buffer, view->get_buffer());
+
+  // Views stay valid after the file has been closed.
+  in.close();
+  EXPECT_EQ(*view, std::string{"Chunky"});
+
+  ASSERT_THROW(mm_mmap_io_c{"doesnotexist"}, mtx::mm_io::exception);
+}
+
+TEST(MmIo, ProbeIo) {
+  mm_mem_io_c mem{reinterpret_cast<unsigned char const *>("0123456789abcdef"), 16};
+  mm_probe_io_c in{&mem, 6, false};
+
+  EXPECT_EQ(16, in.get_size());
+  EXPECT_EQ(std::string{"012345"}, std::string(reinterpret_cast<char const *>(in.get_head().get_buffer()), in.get_head().get_size()));
+
+  // Reads from the cached head don't touch the proxied file.
+  mem.setFilePointer(10);
+  in.setFilePointer(2);
+
+  std::string data;
+  EXPECT_EQ(3u, in.read(data, 3));
+  EXPECT_EQ(std::string{"234"}, data);
+  EXPECT_EQ(5u, in.getFilePointer());
+  EXPECT_EQ(10u, mem.getFilePointer());
+
+  // Reads crossing the end of the cached head.
+  EXPECT_EQ(4u, in.read(data, 4));
+  EXPECT_EQ(std::string{"5678"}, data);
+  EXPECT_EQ(9u, in.getFilePointer());
+
+  in.setFilePointer(-3, seek_end);
+  EXPECT_EQ(3u, in.read(data, 10));
+  EXPECT_EQ(std::string{"def"}, data);
+  EXPECT_TRUE(in.eof());
+
+  in.setFilePointer(0);
+  EXPECT_FALSE(in.eof());
+  EXPECT_EQ(0x30313233u, in.read_uint32_be());
+
+  // The cached head is shorter than requested for short files.
+  mm_mem_io_c short_mem{reinterpret_cast<unsigned char const *>("xyz"), 3};
+  mm_probe_io_c short_in{&short_mem, 6, false};
+
+  EXPECT_EQ(3u, short_in.get_head().get_size());
+}
+
+TEST(MmIo, ProbeIoGrowingHead) {
+  mm_mem_io_c mem{reinterpret_cast<unsigned char const *>("0123456789abcdef"), 16};
+  mm_probe_io_c in{&mem, 4, false, 10};
+
+  EXPECT_EQ(4u, in.get_head().get_size());
+
+  // Reads continuing past the cached head let it grow at least by a
+  // factor of two.
+  std::string data;
+  in.setFilePointer(2);
+  EXPECT_EQ(3u, in.read(data, 3));
+  EXPECT_EQ(std::string{"234"}, data);
+  EXPECT_EQ(8u, in.get_head().get_size());
+
+  // It never grows beyond the maximum size.
+  EXPECT_EQ(7u, in.read(data, 7));
+  EXPECT_EQ(std::string{"56789ab"}, data);
+  EXPECT_EQ(10u, in.get_head().get_size());
+
+  // Reads starting beyond the cached head don't grow it.
+  mm_probe_io_c other_in{&mem, 4, false, 10};
+  other_in.setFilePointer(6);
+  EXPECT_EQ(2u, other_in.read(data, 2));
+  EXPECT_EQ(std::string{"67"}, data);
+  EXPECT_EQ(4u, other_in.get_head().get_size());
+}
+
 }
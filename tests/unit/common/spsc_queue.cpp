@@ -0,0 +1,76 @@
+#include "common/common_pch.h"
+
+#include <thread>
+
+#include "common/spsc_queue.h"
+
+#include "gtest/gtest.h"
+
+namespace {
+
+TEST(SpscQueue, PushAndPop) {
+  spsc_queue_c<int> queue{3};
+  auto value = 0;
+
+  EXPECT_TRUE(queue.empty());
+  EXPECT_FALSE(queue.try_pop(value));
+
+  EXPECT_TRUE(queue.try_push(1));
+  EXPECT_TRUE(queue.try_push(2));
+  EXPECT_TRUE(queue.try_push(3));
+  EXPECT_TRUE(queue.full());
+  EXPECT_FALSE(queue.try_push(4));
+  EXPECT_EQ(3u, queue.size());
+
+  EXPECT_TRUE(queue.try_pop(value));
+  EXPECT_EQ(1, value);
+  EXPECT_TRUE(queue.try_push(4));
+
+  for (auto expected = 2; expected <= 4; ++expected) {
+    EXPECT_TRUE(queue.try_pop(value));
+    EXPECT_EQ(expected, value);
+  }
+
+  EXPECT_TRUE(queue.empty());
+}
+
+TEST(SpscQueue, ReleasesPoppedItems) {
+  spsc_queue_c<std::shared_ptr<int>> queue{2};
+  auto item = std::make_shared<int>(42);
+
+  EXPECT_TRUE(queue.try_push(item));
+  EXPECT_EQ(2, item.use_count());
+
+  auto popped = std::shared_ptr<int>{};
+  EXPECT_TRUE(queue.try_pop(popped));
+  popped.reset();
+
+  EXPECT_EQ(1, item.use_count());
+}
+
+TEST(SpscQueue, TwoThreads) {
+  spsc_queue_c<unsigned int> queue{16};
+  auto num_items = 100000u;
+
+  std::thread producer{[&queue, num_items]() {
+    for (auto idx = 0u; idx < num_items; ++idx)
+      while (!queue.try_push(idx))
+        std::this_thread::yield();
+  }};
+
+  auto in_order = true;
+  for (auto idx = 0u; idx < num_items; ++idx) {
+    auto value = 0u;
+    while (!queue.try_pop(value))
+      std::this_thread::yield();
+
+    in_order = in_order && (value == idx);
+  }
+
+  producer.join();
+
+  EXPECT_TRUE(in_order);
+  EXPECT_TRUE(queue.empty());
+}
+
+}
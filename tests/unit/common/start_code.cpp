@@ -0,0 +1,162 @@
+#include "common/common_pch.h"
+
+#include "common/start_code.h"
+
+#include "gtest/gtest.h"
+
+namespace {
+
+using namespace mtx::start_code;
+
+size_t
+find_reference(unsigned char const *buffer,
+               size_t size) {
+  for (auto pos = 0u; (pos + 2) < size; ++pos)
+    if (!buffer[pos] && !buffer[pos + 1] && (buffer[pos + 2] == 1))
+      return pos;
+
+  return size;
+}
+
+std::vector<unsigned char>
+remove_reference(std::vector<unsigned char> const &src) {
+  auto dest = std::vector<unsigned char>{};
+
+  for (auto pos = 0u; pos < src.size(); ++pos) {
+    dest.push_back(src[pos]);
+    if (((pos + 2) < src.size()) && !src[pos] && !src[pos + 1] && (src[pos + 2] == 3)) {
+      dest.push_back(0);
+      pos += 2;
+    }
+  }
+
+  return dest;
+}
+
+std::vector<unsigned char>
+add_reference(std::vector<unsigned char> const &src) {
+  auto dest = std::vector<unsigned char>{};
+
+  for (auto pos = 0u; pos < src.size(); ++pos) {
+    dest.push_back(src[pos]);
+    if (((pos + 2) < src.size()) && !src[pos] && !src[pos + 1] && (src[pos + 2] <= 3)) {
+      dest.push_back(0);
+      dest.push_back(3);
+      ++pos;
+    }
+  }
+
+  return dest;
+}
+
+std::vector<implementation_e>
+get_available_implementations() {
+  auto implementations = std::vector<implementation_e>{};
+
+  for (auto implementation : { IMPLEMENTATION_SCALAR, IMPLEMENTATION_SSE2, IMPLEMENTATION_AVX2 })
+    if (is_available(implementation))
+      implementations.push_back(implementation);
+
+  return implementations;
+}
+
+TEST(StartCode, Basics) {
+  unsigned char const buffer[] = { 0x12, 0x00, 0x00, 0x00, 0x01, 0x42, 0x00, 0x01, 0x00, 0x00 };
+
+  for (auto implementation : get_available_implementations()) {
+    EXPECT_EQ(2u,  find(implementation, buffer,      sizeof(buffer)));
+    EXPECT_EQ(0u,  find(implementation, buffer + 2,  3));
+    EXPECT_EQ(2u,  find(implementation, buffer,      5));
+    EXPECT_EQ(4u,  find(implementation, buffer,      4));
+    EXPECT_EQ(5u,  find(implementation, buffer + 5,  5));
+    EXPECT_EQ(0u,  find(implementation, buffer,      0));
+  }
+}
+
+TEST(StartCode, AllPositionsAndImplementations) {
+  // Start codes at every position of buffers of different lengths
+  // cover both the vectorized loops and the scalar tails.
+  for (auto size = 3u; size < 100; ++size)
+    for (auto pos = 0u; (pos + 3) <= size; ++pos) {
+      auto buffer = std::vector<unsigned char>(size, 0x80);
+
+      buffer[pos]     = 0x00;
+      buffer[pos + 1] = 0x00;
+      buffer[pos + 2] = 0x01;
+
+      for (auto implementation : get_available_implementations()) {
+        EXPECT_EQ(pos,     find(implementation, &buffer[0], size));
+        EXPECT_EQ(pos + 2, find(implementation, &buffer[0], pos + 2));
+      }
+    }
+}
+
+TEST(StartCode, RandomData) {
+  auto buffer = std::vector<unsigned char>(1000);
+
+  for (auto run = 0; run < 1000; ++run) {
+    // Lots of 0x00 and 0x01 bytes lead to many partial matches.
+    for (auto &byte : buffer)
+      byte = std::rand() % 3 ? std::rand() % 2 : std::rand() % 256;
+
+    auto offset = std::rand() % 40;
+    auto size   = std::rand() % (buffer.size() - offset);
+    auto start  = &buffer[offset];
+
+    for (auto implementation : get_available_implementations())
+      EXPECT_EQ(find_reference(start, size), find(implementation, start, size));
+  }
+}
+
+TEST(StartCode, EmulationPreventionBytes) {
+  auto escaped   = std::vector<unsigned char>{ 0x67, 0x00, 0x00, 0x03, 0x01, 0x00, 0x00, 0x03, 0x00, 0x03, 0x42, 0x00, 0x00 };
+  auto unescaped = std::vector<unsigned char>{ 0x67, 0x00, 0x00,       0x01, 0x00, 0x00,       0x00, 0x03, 0x42, 0x00, 0x00 };
+  auto dest      = std::vector<unsigned char>(max_size_with_emulation_prevention_bytes(escaped.size()));
+
+  for (auto implementation : get_available_implementations()) {
+    dest.resize(remove_emulation_prevention_bytes(implementation, &escaped[0], escaped.size(), &dest[0], dest.size()));
+    EXPECT_EQ(unescaped, dest);
+
+    dest.resize(max_size_with_emulation_prevention_bytes(escaped.size()));
+    dest.resize(add_emulation_prevention_bytes(implementation, &unescaped[0], unescaped.size(), &dest[0]));
+    EXPECT_EQ(escaped, dest);
+  }
+}
+
+TEST(StartCode, EmulationPreventionBytesRandomData) {
+  for (auto run = 0; run < 1000; ++run) {
+    auto src = std::vector<unsigned char>(std::rand() % 200);
+    for (auto &byte : src)
+      byte = std::rand() % 3 ? 0 : std::rand() % 5;
+
+    auto expected_removed = remove_reference(src);
+    auto expected_added   = add_reference(src);
+
+    for (auto implementation : get_available_implementations()) {
+      auto dest = std::vector<unsigned char>(max_size_with_emulation_prevention_bytes(src.size()));
+
+      dest.resize(remove_emulation_prevention_bytes(implementation, src.data(), src.size(), dest.data(), dest.size()));
+      EXPECT_EQ(expected_removed, dest);
+
+      dest.resize(max_size_with_emulation_prevention_bytes(src.size()));
+      dest.resize(add_emulation_prevention_bytes(implementation, src.data(), src.size(), dest.data()));
+      EXPECT_EQ(expected_added, dest);
+
+      // Only a prefix of the unescaped data is requested.
+      auto prefix_size = std::rand() % 40;
+      dest.resize(prefix_size);
+      dest.resize(remove_emulation_prevention_bytes(implementation, src.data(), src.size(), dest.data(), dest.size()));
+      EXPECT_EQ(std::vector<unsigned char>(expected_removed.begin(), expected_removed.begin() + std::min<size_t>(prefix_size, expected_removed.size())), dest);
+    }
+  }
+}
+
+TEST(StartCode, DefaultImplementation) {
+  unsigned char const buffer[] = { 0x12, 0x34, 0x00, 0x00, 0x01 };
+
+  EXPECT_TRUE(is_available(get_implementation()));
+  EXPECT_TRUE(is_available(IMPLEMENTATION_SCALAR));
+  EXPECT_EQ(2u, find(buffer, sizeof(buffer)));
+}
+
+}
@@ -0,0 +1,56 @@
+#include "common/common_pch.h"
+
+#include "merge/cues.h"
+
+#include "gtest/gtest.h"
+
+namespace {
+
+TEST(CuePointStore, Empty) {
+  auto store = cue_point_store_c{};
+
+  EXPECT_TRUE(store.empty());
+  EXPECT_EQ(0u, store.size());
+}
+
+TEST(CuePointStore, StoresAllFields) {
+  auto store  = cue_point_store_c{};
+  auto points = std::vector<cue_point_t>{
+    { 0,            40000000, 1234,      0,      1, 0     },
+    { 0,            0,        1234,      0,      2, 4711  },
+    { 1001000000,   40000000, 5000000,   0,      1, 17    },
+    { 1001000000,   21333333, 5000000,   123456, 2, 98765 },
+    { 900000000000, 0,        987654321, 0,      7, 0     },
+  };
+
+  for (auto const &point : points)
+    store.push_back(point);
+
+  ASSERT_EQ(points.size(), store.size());
+
+  for (auto idx = 0u; idx < points.size(); ++idx) {
+    auto point = store[idx];
+
+    EXPECT_EQ(points[idx].timecode,             point.timecode);
+    EXPECT_EQ(points[idx].duration,             point.duration);
+    EXPECT_EQ(points[idx].cluster_position,     point.cluster_position);
+    EXPECT_EQ(points[idx].codec_state_position, point.codec_state_position);
+    EXPECT_EQ(points[idx].track_num,            point.track_num);
+    EXPECT_EQ(points[idx].relative_position,    point.relative_position);
+  }
+}
+
+TEST(CuePointStore, CompactStorage) {
+  auto store = cue_point_store_c{};
+
+  for (auto idx = 0u; idx < 10000; ++idx)
+    store.push_back({ idx * 40000000ull, 40000000, idx / 100 * 5000000ull, 0, 1, (idx % 100) * 50000 });
+
+  EXPECT_EQ(10000u, store.size());
+  EXPECT_LT(store.get_memory_usage(), 10000u * sizeof(cue_point_t) * 2 / 3);
+
+  store.clear();
+  EXPECT_TRUE(store.empty());
+}
+
+}
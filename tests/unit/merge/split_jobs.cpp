@@ -0,0 +1,41 @@
+#include "common/common_pch.h"
+
+#include "merge/split_jobs.h"
+#include "merge/track_info.h"
+
+#include "gtest/gtest.h"
+
+namespace {
+
+TEST(SplitJobs, SourceTimecodeWithoutSync) {
+  auto sync = timecode_sync_t{};
+
+  EXPECT_EQ(60000000000ll, split_job_source_timecode(60000000000ll, sync));
+  EXPECT_EQ(-5000000000ll, split_job_source_timecode(-5000000000ll, sync));
+}
+
+TEST(SplitJobs, SourceTimecodeWithDisplacement) {
+  auto sync = timecode_sync_t{};
+
+  // '--sync 30000': the track is delayed by 30s. Its source data for
+  // the output's 60s mark is located at 30s.
+  sync.displacement = 30000000000ll;
+  EXPECT_EQ(30000000000ll, split_job_source_timecode(60000000000ll, sync));
+  EXPECT_GT(0, split_job_source_timecode(20000000000ll, sync));
+
+  // '--sync -30000': the first 30s of the track are cut off.
+  sync.displacement = -30000000000ll;
+  EXPECT_EQ(90000000000ll, split_job_source_timecode(60000000000ll, sync));
+}
+
+TEST(SplitJobs, SourceTimecodeWithLinearDrift) {
+  auto sync = timecode_sync_t{};
+
+  // '--sync 10000,2/1': output = source * 2 + 10s
+  sync.displacement = 10000000000ll;
+  sync.numerator    = 2;
+  sync.denominator  = 1;
+  EXPECT_EQ(25000000000ll, split_job_source_timecode(60000000000ll, sync));
+}
+
+}